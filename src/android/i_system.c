@@ -88,6 +88,11 @@ tic_t I_GetTime(void)
   return (since_start*TICRATE)/1000000;
 }
 
+UINT32 I_GetTimeMicros(void)
+{
+  return (UINT32)(current_time_in_ps() - start_time);
+}
+
 void I_Sleep(void){}
 
 void I_GetEvent(void){}
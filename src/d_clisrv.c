@@ -106,6 +106,28 @@ static tic_t maketic;
 
 static INT16 consistancy[BACKUPTICS];
 
+// What went into each consistancy value, so a synch failure
+// can be narrowed down to one part of the game
+enum
+{
+	CONSISTANCY_PLAYERS,
+	CONSISTANCY_SEED,
+#ifdef MOBJCONSISTANCY
+	CONSISTANCY_MOBJS,
+	NUMCONSISTANCYPARTS = CONSISTANCY_MOBJS + NUMMOBJCONSISTANCY
+#else
+	NUMCONSISTANCYPARTS
+#endif
+};
+static const char *const consistancynames[] =
+{
+	"players", "seed",
+#ifdef MOBJCONSISTANCY
+	"playermobjs", "enemies", "missiles", "items", "other",
+#endif
+};
+static UINT32 consistancyparts[BACKUPTICS][NUMCONSISTANCYPARTS];
+
 // Resynching shit!
 static UINT32 resynch_score[MAXNETNODES]; // "score" for kicking -- if this gets too high then cfail kick
 static UINT16 resynch_delay[MAXNETNODES]; // delay time before the player can be considered to have desynched
@@ -122,6 +144,8 @@ static ticcmd_t localcmds2;
 static boolean cl_packetmissed;
 // here it is for the secondary local player (splitscreen)
 static UINT8 mynode; // my address pointofview server
+static boolean watching = false; // joined without a player of our own
+static boolean relaying = false; // passing the server's tics on to watchers
 
 static UINT8 localtextcmd[MAXTEXTCMD];
 static UINT8 localtextcmd2[MAXTEXTCMD]; // splitscreen
@@ -192,24 +216,36 @@ static inline void *G_ScpyTiccmd(ticcmd_t* dest, void* src, const size_t n)
 // of 512 bytes is like 0.1)
 UINT16 software_MAXPACKETLENGTH;
 
-/** Guesses the value of a tic from its lowest byte and from maketic
+/** Guesses the value of a tic from its lowest byte and from a nearby tic
   *
   * \param low The lowest byte of the tic value
+  * \param basetic A tic known to be close to the one wanted
   * \return The full tic value
   *
   */
-tic_t ExpandTics(INT32 low)
+static tic_t ExpandTicsNear(INT32 low, tic_t basetic)
 {
 	INT32 delta;
 
-	delta = low - (maketic & UINT8_MAX);
+	delta = low - (basetic & UINT8_MAX);
 
 	if (delta >= -64 && delta <= 64)
-		return (maketic & ~UINT8_MAX) + low;
+		return (basetic & ~UINT8_MAX) + low;
 	else if (delta > 64)
-		return (maketic & ~UINT8_MAX) - 256 + low;
+		return (basetic & ~UINT8_MAX) - 256 + low;
 	else //if (delta < -64)
-		return (maketic & ~UINT8_MAX) + 256 + low;
+		return (basetic & ~UINT8_MAX) + 256 + low;
+}
+
+/** Guesses the value of a tic from its lowest byte and from maketic
+  *
+  * \param low The lowest byte of the tic value
+  * \return The full tic value
+  *
+  */
+tic_t ExpandTics(INT32 low)
+{
+	return ExpandTicsNear(low, maketic);
 }
 
 // -----------------------------------------------------------------
@@ -1042,6 +1078,14 @@ static void SV_AcknowledgeResynchAck(INT32 node, UINT8 rsg)
 // -----------------------------------------------------------------
 
 static INT16 Consistancy(void);
+static void PrintConsistancyParts(tic_t tic);
+
+#ifndef NONET
+static void CL_ResetRelay(tic_t starttic);
+static void CL_RelayStoreTic(tic_t tic, UINT8 numslots, const UINT8 *cmds, const UINT8 *txtcmds, size_t textsize);
+static void CL_HandlePacketFromWatcher(SINT8 node);
+static void CL_RelayPacket(size_t length);
+#endif
 
 #ifndef NONET
 #define JOININGAME
@@ -1215,7 +1259,9 @@ static boolean CL_SendJoin(void)
 		CONS_Printf(M_GetText("Sending join request...\n"));
 	netbuffer->packettype = PT_CLIENTJOIN;
 
-	if (splitscreen || botingame)
+	if (watching)
+		localplayers = 0;
+	else if (splitscreen || botingame)
 		localplayers++;
 	netbuffer->u.clientcfg.localplayers = localplayers;
 	netbuffer->u.clientcfg.version = VERSION;
@@ -1362,7 +1408,9 @@ static boolean SV_SendServerConfig(INT32 node)
 	netbuffer->u.servercfg.serverplayer = (UINT8)serverplayer;
 	netbuffer->u.servercfg.totalslotnum = (UINT8)(doomcom->numslots);
 	netbuffer->u.servercfg.gametic = (tic_t)LONG(gametic);
-	netbuffer->u.servercfg.clientnode = (UINT8)node;
+	// A relay's watchers must never match a node number in the
+	// real server's XD_ADDPLAYER commands
+	netbuffer->u.servercfg.clientnode = (UINT8)(relaying ? UINT8_MAX : node);
 	netbuffer->u.servercfg.gamestate = (UINT8)gamestate;
 	netbuffer->u.servercfg.gametype = (UINT8)gametype;
 	netbuffer->u.servercfg.modifiedgame = (UINT8)modifiedgame;
@@ -1423,19 +1471,33 @@ static boolean SV_SendServerConfig(INT32 node)
 #ifdef JOININGAME
 #define SAVEGAMESIZE (768*1024)
 
-static void SV_SendSaveGame(INT32 node)
+// The last savegame built, kept for the rest of its tic so that players
+// joining together don't each make the server save and compress the game.
+static UINT8 *cachedsave = NULL;
+static size_t cachedsavelength;
+static tic_t cachedsavetic;
+
+static void SV_FreeCachedSaveGame(void)
+{
+	free(cachedsave);
+	cachedsave = NULL;
+}
+
+static boolean SV_BuildSaveGame(void)
 {
 	size_t length, compressedlen;
 	UINT8 *savebuffer;
 	UINT8 *compressedsave;
-	UINT8 *buffertosend;
+	UINT32 starttime = I_GetTimeMicros();
+
+	SV_FreeCachedSaveGame();
 
 	// first save it in a malloced buffer
 	savebuffer = (UINT8 *)malloc(SAVEGAMESIZE);
 	if (!savebuffer)
 	{
 		CONS_Alert(CONS_ERROR, M_GetText("No more free memory for savegame\n"));
-		return;
+		return false;
 	}
 
 	// Leave room for the uncompressed length.
@@ -1444,10 +1506,10 @@ static void SV_SendSaveGame(INT32 node)
 	P_SaveNetGame();
 
 	length = save_p - savebuffer;
+	save_p = NULL;
 	if (length > SAVEGAMESIZE)
 	{
 		free(savebuffer);
-		save_p = NULL;
 		I_Error("Savegame buffer overrun");
 	}
 
@@ -1456,8 +1518,9 @@ static void SV_SendSaveGame(INT32 node)
 	compressedsave = malloc(length - 1);
 	if (!compressedsave)
 	{
+		free(savebuffer);
 		CONS_Alert(CONS_ERROR, M_GetText("No more free memory for savegame\n"));
-		return;
+		return false;
 	}
 
 	// Attempt to compress it.
@@ -1468,9 +1531,9 @@ static void SV_SendSaveGame(INT32 node)
 		free(savebuffer);
 
 		// State that we're compressed.
-		buffertosend = compressedsave;
+		cachedsave = compressedsave;
 		WRITEUINT32(compressedsave, length - sizeof(UINT32));
-		length = compressedlen + sizeof(UINT32);
+		cachedsavelength = compressedlen + sizeof(UINT32);
 	}
 	else
 	{
@@ -1479,16 +1542,43 @@ static void SV_SendSaveGame(INT32 node)
 		free(compressedsave);
 
 		// State that we're not compressed
-		buffertosend = savebuffer;
+		cachedsave = savebuffer;
 		WRITEUINT32(savebuffer, 0);
+		cachedsavelength = length;
 	}
 
-	SV_SendRam(node, buffertosend, length, SF_RAM, 0);
-	save_p = NULL;
+	cachedsavetic = gametic;
+	CONS_Debug(DBG_NETPLAY, "Savegame for joining players: %s bytes (%s sent), stalled %u us\n",
+		sizeu1(length), sizeu2(cachedsavelength), I_GetTimeMicros() - starttime);
+	return true;
+}
+
+static void SV_SendSaveGame(INT32 node)
+{
+	UINT8 *buffertosend;
+
+	if (!cachedsave || cachedsavetic != gametic)
+	{
+		if (!SV_BuildSaveGame())
+			return;
+	}
+	else
+		CONS_Debug(DBG_NETPLAY, "Reusing this tic's savegame for node %d\n", node);
+
+	// Every transfer frees its own copy when done.
+	buffertosend = malloc(cachedsavelength);
+	if (!buffertosend)
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("No more free memory for savegame\n"));
+		return;
+	}
+	M_Memcpy(buffertosend, cachedsave, cachedsavelength);
+
+	SV_SendRam(node, buffertosend, cachedsavelength, SF_RAM, 0);
 
 	// Remember when we started sending the savegame so we can handle timeouts
 	sendingsavegame[node] = true;
-	freezetimeout[node] = I_GetTime() + jointimeout + length / 1024; // 1 extra tic for each kilobyte
+	freezetimeout[node] = I_GetTime() + jointimeout + cachedsavelength / 1024; // 1 extra tic for each kilobyte
 }
 
 #ifdef DUMPCONSISTENCY
@@ -1783,7 +1873,7 @@ static boolean CL_ServerConnectionSearchTicker(boolean viams, tic_t *asksent)
 		}
 
 		// Quit here rather than downloading files and being refused later.
-		if (serverlist[i].info.numberofplayer >= serverlist[i].info.maxplayer)
+		if (!watching && serverlist[i].info.numberofplayer >= serverlist[i].info.maxplayer)
 		{
 			D_QuitNetGame();
 			CL_Reset();
@@ -1913,6 +2003,20 @@ static boolean CL_ServerConnectionTicker(boolean viams, const char *tmpsave, tic
 			if (waitmore)
 				break; // exit the case
 
+			// Ask for any that didn't fit in the last request
+			for (i = 0; i < fileneedednum; i++)
+				if (fileneeded[i].status == FS_NOTFOUND
+					|| fileneeded[i].status == FS_MD5SUMBAD)
+				{
+					waitmore = true;
+					break;
+				}
+			if (waitmore)
+			{
+				CL_SendRequestFile();
+				break;
+			}
+
 			cl_mode = CL_ASKJOIN; // don't break case continue to cljoin request now
 			/* FALLTHRU */
 
@@ -2353,6 +2457,24 @@ void CL_ClearPlayer(INT32 playernum)
 	memset(&players[playernum], 0, sizeof (player_t));
 }
 
+//
+// CL_WatchSomeone
+//
+// Points a playerless client's view at the first player in the game
+//
+static void CL_WatchSomeone(void)
+{
+	INT32 i;
+
+	for (i = 0; i < MAXPLAYERS; i++)
+		if (playeringame[i])
+			break;
+	if (i == MAXPLAYERS)
+		i = 0;
+
+	consoleplayer = displayplayer = secondarydisplayplayer = i;
+}
+
 //
 // CL_RemovePlayer
 //
@@ -2434,7 +2556,9 @@ static void CL_RemovePlayer(INT32 playernum, INT32 reason)
 		RemoveAdminPlayer(playernum); // don't stay admin after you're gone
 	}
 
-	if (playernum == displayplayer)
+	if (playerless && playernum == consoleplayer)
+		CL_WatchSomeone(); // they were only who we were watching
+	else if (playernum == displayplayer)
 		displayplayer = consoleplayer; // don't look through someone's view who isn't there
 
 #ifdef HAVE_BLUA
@@ -2850,7 +2974,7 @@ static void Got_KickCmd(UINT8 **p, INT32 playernum)
 			break;
 	}
 
-	if (pnum == consoleplayer)
+	if (pnum == consoleplayer && !playerless)
 	{
 #ifdef DUMPCONSISTENCY
 		if (msg == KICK_MSG_CON_FAIL) SV_SavedGame();
@@ -2894,7 +3018,14 @@ consvar_t cv_noticedownload = {"noticedownload", "Off", CV_SAVE, CV_OnOff, NULL,
 static CV_PossibleValue_t downloadspeed_cons_t[] = {{0, "MIN"}, {32, "MAX"}, {0, NULL}};
 consvar_t cv_downloadspeed = {"downloadspeed", "16", CV_SAVE, downloadspeed_cons_t, NULL, 0, NULL, NULL, 0, 0, NULL};
 
+// Draw the local player's view ahead of the tics confirmed by the server
+consvar_t cv_netprediction = {"netprediction", "Off", CV_SAVE, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
+
+// Let relays and -watch clients join without taking a player slot
+consvar_t cv_allowwatchers = {"allowwatchers", "Off", CV_SAVE, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
+
 static void Got_AddPlayer(UINT8 **p, INT32 playernum);
+static void CL_CheckViewPrediction(void);
 
 // called one time at init
 void D_ClientServerInit(void)
@@ -2932,6 +3063,10 @@ void D_ClientServerInit(void)
 	CV_RegisterVar(&cv_dumpconsistency);
 #endif
 	Ban_Load_File(false);
+
+	// -relay joins like -watch and lets others watch through us
+	relaying = M_CheckParm("-relay") != 0;
+	watching = relaying || M_CheckParm("-watch");
 #endif
 
 	gametic = 0;
@@ -2990,6 +3125,10 @@ void SV_ResetServer(void)
 	mynode = 0;
 	cl_packetmissed = false;
 
+#ifdef JOININGAME
+	SV_FreeCachedSaveGame();
+#endif
+
 	if (dedicated)
 	{
 		nodeingame[0] = true;
@@ -3054,6 +3193,16 @@ void D_QuitNetGame(void)
 	}
 	else if (servernode > 0 && servernode < MAXNETNODES && nodeingame[(UINT8)servernode])
 	{
+		if (relaying)
+		{
+			INT32 i;
+
+			netbuffer->packettype = PT_SERVERSHUTDOWN;
+			for (i = 1; i < MAXNETNODES; i++)
+				if (nodeingame[i] && i != servernode)
+					HSendPacket(i, true, 0, 0);
+		}
+
 		netbuffer->packettype = PT_CLIENTQUIT;
 		HSendPacket(servernode, true, 0, 0);
 	}
@@ -3140,6 +3289,8 @@ static void Got_AddPlayer(UINT8 **p, INT32 playernum)
 		D_SendPlayerConfig();
 		addedtogame = true;
 	}
+	else if (playerless && consoleplayer != newplayernum && !playeringame[consoleplayer])
+		CL_WatchSomeone(); // had nobody to watch until now
 
 	if (netgame)
 	{
@@ -3338,6 +3489,7 @@ void SV_StopServer(void)
 		D_Clearticcmd(i);
 
 	consoleplayer = 0;
+	playerless = false;
 	cl_mode = CL_SEARCHING;
 	maketic = gametic+1;
 	neededtic = maketic;
@@ -3391,6 +3543,9 @@ static size_t TotalTextCmdPerTic(tic_t tic)
   */
 static void HandleConnect(SINT8 node)
 {
+	// Relays and -watch clients join without a player
+	const boolean watcher = !netbuffer->u.clientcfg.localplayers;
+
 	if (bannednode && bannednode[node])
 		SV_SendRefuse(node, M_GetText("You have been banned\nfrom the server"));
 	else if (netbuffer->u.clientcfg.version != VERSION
@@ -3398,11 +3553,11 @@ static void HandleConnect(SINT8 node)
 		SV_SendRefuse(node, va(M_GetText("Different SRB2 versions cannot\nplay a netgame!\n(server version %d.%d.%d)"), VERSION/100, VERSION%100, SUBVERSION));
 	else if (!cv_allownewplayer.value && node)
 		SV_SendRefuse(node, M_GetText("The server is not accepting\njoins for the moment"));
-	else if (D_NumPlayers() >= cv_maxplayers.value)
+	else if (!watcher && D_NumPlayers() >= cv_maxplayers.value)
 		SV_SendRefuse(node, va(M_GetText("Maximum players reached: %d"), cv_maxplayers.value));
 	else if (netgame && netbuffer->u.clientcfg.localplayers > 1) // Hacked client?
 		SV_SendRefuse(node, M_GetText("Too many players from\nthis node."));
-	else if (netgame && !netbuffer->u.clientcfg.localplayers) // Stealth join?
+	else if (netgame && watcher && !cv_allowwatchers.value) // Stealth join?
 		SV_SendRefuse(node, M_GetText("No players from\nthis node."));
 	else
 	{
@@ -3443,13 +3598,16 @@ static void HandleConnect(SINT8 node)
 			DEBFILE("new node joined\n");
 		}
 #ifdef JOININGAME
-		if (nodewaiting[node])
+		if (nodewaiting[node] || watcher)
 		{
 			if ((gamestate == GS_LEVEL || gamestate == GS_INTERMISSION) && newnode)
 			{
 				SV_SendSaveGame(node); // send a complete game state
 				DEBFILE("send savegame\n");
 			}
+		}
+		if (nodewaiting[node])
+		{
 			SV_AddWaitingPlayers();
 			player_joining = true;
 		}
@@ -3650,6 +3808,11 @@ static void HandlePacketFromAwayNode(SINT8 node)
 				players[j].skincolor = netbuffer->u.servercfg.playercolor[j];
 			}
 
+			// Watchers never get a player of their own
+			playerless = watching;
+			if (playerless)
+				CL_WatchSomeone();
+
 			scp = netbuffer->u.servercfg.varlengthinputs;
 			CV_LoadPlayerNames(&scp);
 			CV_LoadNetVars(&scp);
@@ -3657,6 +3820,8 @@ static void HandlePacketFromAwayNode(SINT8 node)
 			/// \note Wait. What if a Lua script uses some global custom variables synched with the NetVars hook?
 			///       Shouldn't them be downloaded even at intermission time?
 			///       Also, according to HandleConnect, the server will send the savegame even during intermission...
+			if (relaying)
+				CL_ResetRelay(gametic);
 			if (netbuffer->u.servercfg.gamestate == GS_LEVEL/* ||
 				netbuffer->u.servercfg.gamestate == GS_INTERMISSION*/)
 				cl_mode = CL_DOWNLOADSAVEGAME;
@@ -3780,7 +3945,7 @@ FILESTAMP
 			nettics[node] = realend;
 
 			// Don't do anything for packets of type NODEKEEPALIVE?
-			if (netconsole == -1 || netbuffer->packettype == PT_NODEKEEPALIVE
+			if (netbuffer->packettype == PT_NODEKEEPALIVE
 				|| netbuffer->packettype == PT_NODEKEEPALIVEMIS)
 				break;
 
@@ -3791,6 +3956,10 @@ FILESTAMP
 			/// \todo Use a separate cvar for that kind of timeout?
 			freezetimeout[node] = I_GetTime() + connectiontimeout;
 
+			// Watchers have no player for the ticcmd to go to
+			if (netconsole == -1)
+				break;
+
 			// Copy ticcmd
 			G_MoveTiccmd(&netcmds[maketic%BACKUPTICS][netconsole], &netbuffer->u.clientpak.cmd, 1);
 
@@ -3830,10 +3999,13 @@ FILESTAMP
 				if (cv_resynchattempts.value && resynch_score[node] <= (unsigned)cv_resynchattempts.value*250)
 				{
 					if (cv_blamecfail.value)
+					{
 						CONS_Printf(M_GetText("Synch failure for player %d (%s); expected %hd, got %hd\n"),
 							netconsole+1, player_names[netconsole],
 							consistancy[realstart%BACKUPTICS],
 							SHORT(netbuffer->u.clientpak.consistancy));
+						PrintConsistancyParts(realstart);
+					}
 					DEBFILE(va("Restoring player %d (synch failure) [%update] %d!=%d\n",
 						netconsole, realstart, consistancy[realstart%BACKUPTICS],
 						SHORT(netbuffer->u.clientpak.consistancy)));
@@ -4012,6 +4184,10 @@ FILESTAMP
 
 				for (i = realstart; i < realend; i++)
 				{
+#ifndef NONET
+					const UINT8 *ticstart = pak, *txtstart = txtpak;
+#endif
+
 					// clear first
 					D_Clearticcmd(i);
 
@@ -4030,6 +4206,11 @@ FILESTAMP
 							M_Memcpy(D_GetTextcmd(i, k), txtpak, txtsize);
 						txtpak += txtsize;
 					}
+
+#ifndef NONET
+					if (relaying)
+						CL_RelayStoreTic(i, netbuffer->u.serverpak.numslots, ticstart, txtstart, txtpak - txtstart);
+#endif
 				}
 
 				neededtic = realend;
@@ -4088,6 +4269,10 @@ FILESTAMP
 				for (i = 0; i < MAXPLAYERS; i++)
 					if (playeringame[i])
 						playerpingtable[i] = (tic_t)netbuffer->u.pingtable[i];
+#ifndef NONET
+				if (relaying)
+					CL_RelayPacket(sizeof(INT32) * MAXPLAYERS);
+#endif
 			}
 
 			break;
@@ -4140,6 +4325,13 @@ FILESTAMP
 			HandleConnect(node);
 			continue;
 		}
+#ifndef NONET
+		if (relaying && node != servernode && cl_mode == CL_CONNECTED)
+		{
+			CL_HandlePacketFromWatcher(node);
+			continue;
+		}
+#endif
 		if (node == servernode && client && cl_mode != CL_SEARCHING)
 		{
 			if (netbuffer->packettype == PT_SERVERSHUTDOWN)
@@ -4186,10 +4378,7 @@ static INT16 Consistancy(void)
 {
 	INT32 i;
 	UINT32 ret = 0;
-#ifdef MOBJCONSISTANCY
-	thinker_t *th;
-	mobj_t *mo;
-#endif
+	UINT32 *parts = consistancyparts[gametic%BACKUPTICS];
 
 	DEBFILE(va("TIC %u ", gametic));
 
@@ -4206,90 +4395,46 @@ static INT16 Consistancy(void)
 			ret *= i+1;
 		}
 	}
+	parts[CONSISTANCY_PLAYERS] = ret;
+
 	// I give up
 	// Coop desynching enemies is painful
-	if (!G_PlatformGametype())
-		ret += P_GetRandSeed();
+	parts[CONSISTANCY_SEED] = G_PlatformGametype() ? 0 : P_GetRandSeed();
+	ret += parts[CONSISTANCY_SEED];
 
 #ifdef MOBJCONSISTANCY
-	if (!thinkercap.next)
+	// Kept up to date as the mobjs think; see P_UpdateMobjConsistancy
+	for (i = 0; i < NUMMOBJCONSISTANCY; i++)
 	{
-		DEBFILE(va("Consistancy = %u\n", ret));
-		return ret;
+		parts[CONSISTANCY_MOBJS+i] = mobjconsistancy[i];
+		ret += mobjconsistancy[i];
 	}
-	for (th = thinkercap.next; th != &thinkercap; th = th->next)
-	{
-		if (th->function.acp1 != (actionf_p1)P_MobjThinker)
-			continue;
-
-		mo = (mobj_t *)th;
+#endif
 
-		if (mo->flags & (MF_SPECIAL | MF_SOLID | MF_PUSHABLE | MF_BOSS | MF_MISSILE | MF_SPRING | MF_MONITOR | MF_FIRE | MF_ENEMY | MF_PAIN | MF_STICKY))
-		{
-			ret -= mo->type;
-			ret += mo->x;
-			ret -= mo->y;
-			ret += mo->z;
-			ret -= mo->momx;
-			ret += mo->momy;
-			ret -= mo->momz;
-			ret += mo->angle;
-			ret -= mo->flags;
-			ret += mo->flags2;
-			ret -= mo->eflags;
-			if (mo->target)
-			{
-				ret += mo->target->type;
-				ret -= mo->target->x;
-				ret += mo->target->y;
-				ret -= mo->target->z;
-				ret += mo->target->momx;
-				ret -= mo->target->momy;
-				ret += mo->target->momz;
-				ret -= mo->target->angle;
-				ret += mo->target->flags;
-				ret -= mo->target->flags2;
-				ret += mo->target->eflags;
-				ret -= mo->target->state - states;
-				ret += mo->target->tics;
-				ret -= mo->target->sprite;
-				ret += mo->target->frame;
-			}
-			else
-				ret ^= 0x3333;
-			if (mo->tracer && mo->tracer->type != MT_OVERLAY)
-			{
-				ret += mo->tracer->type;
-				ret -= mo->tracer->x;
-				ret += mo->tracer->y;
-				ret -= mo->tracer->z;
-				ret += mo->tracer->momx;
-				ret -= mo->tracer->momy;
-				ret += mo->tracer->momz;
-				ret -= mo->tracer->angle;
-				ret += mo->tracer->flags;
-				ret -= mo->tracer->flags2;
-				ret += mo->tracer->eflags;
-				ret -= mo->tracer->state - states;
-				ret += mo->tracer->tics;
-				ret -= mo->tracer->sprite;
-				ret += mo->tracer->frame;
-			}
-			else
-				ret ^= 0xAAAA;
-			ret -= mo->state - states;
-			ret += mo->tics;
-			ret -= mo->sprite;
-			ret += mo->frame;
-		}
+#ifdef DEBUGFILE
+	if (debugfile)
+	{
+		for (i = 0; i < NUMCONSISTANCYPARTS; i++)
+			fprintf(debugfile, "%s %08x ", consistancynames[i], parts[i]);
 	}
 #endif
-
 	DEBFILE(va("Consistancy = %u\n", (ret & 0xFFFF)));
 
 	return (INT16)(ret & 0xFFFF);
 }
 
+/** Prints what went into the desync check for a tic
+  *
+  * \param tic A tic no more than BACKUPTICS old
+  */
+static void PrintConsistancyParts(tic_t tic)
+{
+	INT32 i;
+
+	for (i = 0; i < NUMCONSISTANCYPARTS; i++)
+		CONS_Printf("  %s: %08x\n", consistancynames[i], consistancyparts[tic%BACKUPTICS][i]);
+}
+
 // send the client packet to the server
 static void CL_SendClientCmd(void)
 {
@@ -4467,6 +4612,341 @@ static void SV_SendTics(void)
 	supposedtics[0] = maketic;
 }
 
+#ifndef NONET
+// -----------------------------------------------------------------
+// Relay
+//
+// A relay joins the server like a -watch client, as a single node
+// without a player, and lets any number of watchers join it instead.
+// It keeps the tics it gets for RELAYBACKUPTICS, so each watcher can
+// fall behind, or take its time downloading the relay's own savegame,
+// without the relay ever holding up the real server. Relays can be
+// chained to serve more watchers than a single node table holds.
+// -----------------------------------------------------------------
+#define RELAYBACKUPTICS (20*TICRATE)
+
+typedef struct
+{
+	tic_t tic;
+	UINT8 numslots; // 0 if nothing was stored here yet
+	UINT8 *textcmds; // As found in PT_SERVERTICS, or NULL if there were none
+	size_t textsize;
+	ticcmd_t cmds[MAXPLAYERS]; // Still in network byte order
+} relaytic_t;
+
+static relaytic_t *relaytics = NULL;
+static tic_t relayfirsttic; // Oldest tic that can still be sent
+
+static void CL_ResetRelay(tic_t starttic)
+{
+	INT32 i;
+
+	if (!relaytics)
+		relaytics = Z_Calloc(RELAYBACKUPTICS * sizeof (*relaytics), PU_STATIC, NULL);
+	else
+		for (i = 0; i < RELAYBACKUPTICS; i++)
+		{
+			Z_Free(relaytics[i].textcmds);
+			relaytics[i].textcmds = NULL;
+			relaytics[i].numslots = 0;
+		}
+
+	relayfirsttic = starttic;
+}
+
+/** Keeps a tic received from the server so it can be passed on
+  *
+  * \param tic The tic
+  * \param numslots Number of ticcmds in the tic
+  * \param cmds The ticcmds, straight from the packet
+  * \param txtcmds The tic's part of the textcmd list, starting with its count
+  * \param textsize Size of that part
+  *
+  */
+static void CL_RelayStoreTic(tic_t tic, UINT8 numslots, const UINT8 *cmds, const UINT8 *txtcmds, size_t textsize)
+{
+	relaytic_t *rt = &relaytics[tic % RELAYBACKUPTICS];
+
+	if (tic < relayfirsttic || (rt->numslots && rt->tic == tic))
+		return; // resent
+
+	Z_Free(rt->textcmds);
+	rt->textcmds = NULL;
+	rt->textsize = 0;
+
+	rt->tic = tic;
+	rt->numslots = numslots;
+	M_Memcpy(rt->cmds, cmds, numslots * sizeof (ticcmd_t));
+	if (txtcmds[0])
+	{
+		rt->textcmds = Z_Malloc(textsize, PU_STATIC, NULL);
+		M_Memcpy(rt->textcmds, txtcmds, textsize);
+		rt->textsize = textsize;
+	}
+
+	if (tic >= relayfirsttic + RELAYBACKUPTICS)
+		relayfirsttic = tic - RELAYBACKUPTICS + 1;
+}
+
+/** Disconnects a watcher from the relay
+  *
+  * \param node The watcher's node
+  * \param timeout Whether to tell them it timed out
+  *
+  */
+static void CL_DropWatcher(INT32 node, boolean timeout)
+{
+	if (timeout)
+	{
+		netbuffer->packettype = PT_NODETIMEOUT;
+		HSendPacket(node, false, 0, 0);
+	}
+	Net_CloseConnection(node);
+	nodeingame[node] = false;
+	CONS_Debug(DBG_NETPLAY, "Watcher on node %d left the relay\n", node);
+}
+
+/** Called when a PT_CLIENTJOIN packet reaches a relay
+  *
+  * \param node The packet sender
+  *
+  */
+static void CL_HandleRelayConnect(SINT8 node)
+{
+	if (bannednode && bannednode[node])
+		SV_SendRefuse(node, M_GetText("You have been banned\nfrom the server"));
+	else if (netbuffer->u.clientcfg.version != VERSION
+		|| netbuffer->u.clientcfg.subversion != SUBVERSION)
+		SV_SendRefuse(node, va(M_GetText("Different SRB2 versions cannot\nplay a netgame!\n(server version %d.%d.%d)"), VERSION/100, VERSION%100, SUBVERSION));
+	else if (netbuffer->u.clientcfg.localplayers)
+		SV_SendRefuse(node, M_GetText("This is a relay for spectators.\nStart with -watch to join it."));
+	else if (!nodeingame[node])
+	{
+		SV_AddNode(node);
+		freezetimeout[node] = I_GetTime() + jointimeout;
+
+		if (!SV_SendServerConfig(node))
+		{
+			ResetNode(node);
+			SV_SendRefuse(node, M_GetText("Server couldn't send info, please try again"));
+			return;
+		}
+
+		if (gamestate == GS_LEVEL || gamestate == GS_INTERMISSION)
+			SV_SendSaveGame(node);
+		CONS_Debug(DBG_NETPLAY, "Watcher joined the relay on node %d\n", node);
+	}
+}
+
+/** Handles a packet a relay got from anyone but its server
+  *
+  * \param node The packet sender
+  * \sa GetPackets
+  *
+  */
+static void CL_HandlePacketFromWatcher(SINT8 node)
+{
+	tic_t realend;
+
+	switch (netbuffer->packettype)
+	{
+		case PT_ASKINFO:
+			SV_SendServerInfo(node, (tic_t)LONG(netbuffer->u.askinfo.time));
+			SV_SendPlayerInfo(node);
+			Net_CloseConnection(node);
+			break;
+
+		case PT_CLIENTJOIN:
+			CL_HandleRelayConnect(node);
+			break;
+
+		case PT_REQUESTFILE:
+			if (!cv_downloading.value || !Got_RequestFilePak(node))
+				Net_CloseConnection(node);
+			break;
+
+		case PT_CLIENTCMD:
+		case PT_CLIENT2CMD:
+		case PT_CLIENTMIS:
+		case PT_CLIENT2MIS:
+		case PT_NODEKEEPALIVE:
+		case PT_NODEKEEPALIVEMIS:
+			if (!nodeingame[node])
+				break;
+
+			// Only the acknowledgement matters, watchers' input goes nowhere.
+			// They can be far behind us, so expand from what they last had.
+			realend = ExpandTicsNear(netbuffer->u.clientpak.resendfrom, nettics[node]);
+
+			if (netbuffer->packettype == PT_CLIENTMIS || netbuffer->packettype == PT_CLIENT2MIS
+				|| netbuffer->packettype == PT_NODEKEEPALIVEMIS
+				|| supposedtics[node] < realend)
+			{
+				supposedtics[node] = realend;
+			}
+			if (nettics[node] > realend)
+				break;
+			nettics[node] = realend;
+
+			if (netbuffer->packettype != PT_NODEKEEPALIVE && netbuffer->packettype != PT_NODEKEEPALIVEMIS)
+				sendingsavegame[node] = false;
+			freezetimeout[node] = I_GetTime() + connectiontimeout;
+			break;
+
+		case PT_NODETIMEOUT:
+			if (nodeingame[node])
+				CL_DropWatcher(node, true);
+			else
+				Net_CloseConnection(node);
+			break;
+
+		case PT_CLIENTQUIT:
+			if (nodeingame[node])
+				CL_DropWatcher(node, false);
+			else
+				Net_CloseConnection(node);
+			break;
+
+		case PT_TEXTCMD:
+		case PT_TEXTCMD2:
+		case PT_RESYNCHGET:
+			break; // Watchers have no say in the game
+
+		default:
+			DEBFILE(va("relay: unexpected packet %d from node %d\n", netbuffer->packettype, node));
+			if (!nodeingame[node])
+				Net_CloseConnection(node);
+			break;
+	}
+}
+
+/** Sends each watcher the tics it is missing
+  *
+  * \sa SV_SendTics
+  *
+  */
+static void CL_RelaySendTics(void)
+{
+	tic_t realfirsttic, lasttictosend, i;
+	INT32 n;
+	UINT8 numslots;
+	size_t textsize, packsize;
+	UINT8 *bufpos;
+
+	for (n = 1; n < MAXNETNODES; n++)
+	{
+		if (!nodeingame[n] || n == servernode)
+			continue;
+
+		if (nettics[n] < relayfirsttic)
+		{
+			// Too far behind for anything we still have
+			CL_DropWatcher(n, true);
+			continue;
+		}
+
+		lasttictosend = neededtic;
+
+		realfirsttic = supposedtics[n];
+		if (realfirsttic >= lasttictosend)
+		{
+			// Same as the server: use spare bandwidth to resend what may be lost
+			realfirsttic = nettics[n];
+			if (realfirsttic >= lasttictosend || (I_GetTime() + n)&3)
+				continue;
+		}
+		if (realfirsttic < relayfirsttic)
+			realfirsttic = relayfirsttic;
+
+		// They can't hold more than that
+		if (lasttictosend > nettics[n] + BACKUPTICS)
+			lasttictosend = nettics[n] + BACKUPTICS;
+		if (realfirsttic >= lasttictosend)
+			continue;
+
+		// All tics in a packet share a slot count; pad the smaller ones
+		numslots = 0;
+		textsize = 0;
+		for (i = realfirsttic; i < lasttictosend; i++)
+		{
+			const relaytic_t *rt = &relaytics[i % RELAYBACKUPTICS];
+			const UINT8 slots = max(numslots, rt->numslots);
+			const size_t newtextsize = textsize + (rt->textcmds ? rt->textsize : 1);
+
+			if (BASESERVERTICSSIZE + (i + 1 - realfirsttic) * slots * sizeof (ticcmd_t) + newtextsize
+				> software_MAXPACKETLENGTH && i > realfirsttic)
+			{
+				lasttictosend = i;
+				break;
+			}
+			numslots = slots;
+			textsize = newtextsize;
+		}
+
+		netbuffer->packettype = PT_SERVERTICS;
+		netbuffer->u.serverpak.starttic = (UINT8)realfirsttic;
+		netbuffer->u.serverpak.numtics = (UINT8)(lasttictosend - realfirsttic);
+		netbuffer->u.serverpak.numslots = numslots;
+		bufpos = (UINT8 *)&netbuffer->u.serverpak.cmds;
+
+		for (i = realfirsttic; i < lasttictosend; i++)
+		{
+			const relaytic_t *rt = &relaytics[i % RELAYBACKUPTICS];
+			M_Memcpy(bufpos, rt->cmds, rt->numslots * sizeof (ticcmd_t));
+			memset(bufpos + rt->numslots * sizeof (ticcmd_t), 0, (numslots - rt->numslots) * sizeof (ticcmd_t));
+			bufpos += numslots * sizeof (ticcmd_t);
+		}
+		for (i = realfirsttic; i < lasttictosend; i++)
+		{
+			const relaytic_t *rt = &relaytics[i % RELAYBACKUPTICS];
+			if (rt->textcmds)
+			{
+				M_Memcpy(bufpos, rt->textcmds, rt->textsize);
+				bufpos += rt->textsize;
+			}
+			else
+				WRITEUINT8(bufpos, 0);
+		}
+		packsize = bufpos - (UINT8 *)&(netbuffer->u);
+
+		HSendPacket(n, false, 0, packsize);
+		if (lasttictosend-doomcom->extratics > realfirsttic)
+			supposedtics[n] = lasttictosend-doomcom->extratics;
+		else
+			supposedtics[n] = lasttictosend;
+		if (supposedtics[n] < nettics[n]) supposedtics[n] = nettics[n];
+	}
+}
+
+static void CL_RelayTicker(void)
+{
+	INT32 n;
+
+	if (cl_mode != CL_CONNECTED)
+		return;
+
+	for (n = 1; n < MAXNETNODES; n++)
+		if (nodeingame[n] && n != servernode && freezetimeout[n] < I_GetTime())
+			Net_ConnectionTimeout(n);
+
+	CL_RelaySendTics();
+}
+
+/** Passes the packet just received from the server on to every watcher
+  *
+  * \param length Length of the packet's data
+  *
+  */
+static void CL_RelayPacket(size_t length)
+{
+	INT32 n;
+
+	for (n = 1; n < MAXNETNODES; n++)
+		if (nodeingame[n] && n != servernode)
+			HSendPacket(n, true, 0, length);
+}
+#endif
+
 //
 // TryRunTics
 //
@@ -4607,10 +5087,204 @@ void TryRunTics(tic_t realtics)
 				ExtraDataTicker();
 				gametic++;
 				consistancy[gametic%BACKUPTICS] = Consistancy();
+				CL_CheckViewPrediction();
 			}
 	}
 }
 
+// -----------------------------------------------------------------
+// View prediction
+//
+// A client only runs the tics the server has confirmed, so the view
+// trails its own input by the whole round trip. Re-running the game
+// ahead of the server and rolling it back would mean saving and
+// reloading the level every frame, and P_PlayerThink fires specials,
+// the RNG and Lua hooks which must only run once per real tic.
+// Instead the local player's view is pushed along its momentum by
+// the number of tics we have sent but not yet seen come back, and
+// put back right after rendering. Each guess is kept until its tic
+// is run for real so we can tell how far off it was.
+// -----------------------------------------------------------------
+#define MAXPREDICTIONTICS (TICRATE/3)
+#define PREDICTIONBACKUP 32
+#define PREDICTIONSNAP (256*FRACUNIT) // more than this is a teleport, not a miss
+
+typedef struct
+{
+	tic_t tic;
+	mobj_t *mo;
+	fixed_t x, y, z;
+} viewprediction_t;
+
+static viewprediction_t viewpredictions[PREDICTIONBACKUP];
+
+static boolean predictionapplied = false;
+static fixed_t predictdx, predictdy, predictdz;
+static boolean predictcamera;
+
+fixed_t predictionerror = 0;
+tic_t predictiontics = 0;
+
+static void CL_ClearViewPredictions(void)
+{
+	memset(viewpredictions, 0, sizeof (viewpredictions));
+}
+
+static boolean CL_CanPredictView(void)
+{
+	player_t *player = &players[consoleplayer];
+
+	if (!cv_netprediction.value || !netgame || server || demoplayback)
+		return false;
+	if (gamestate != GS_LEVEL || paused || player_joining || cl_mode != CL_CONNECTED)
+		return false;
+	if (displayplayer != consoleplayer || !playeringame[consoleplayer])
+		return false;
+	if (!player->mo || player->playerstate != PST_LIVE || player->awayviewtics)
+		return false;
+	return true;
+}
+
+/** Moves the local player's view ahead by the tics still in flight
+  * Must be paired with CL_RestoreViewPrediction once the view is drawn.
+  *
+  * \sa CL_RestoreViewPrediction
+  */
+void CL_ApplyViewPrediction(void)
+{
+	player_t *player = &players[consoleplayer];
+	mobj_t *mo;
+	sector_t *sector;
+	fixed_t x, y, z, floorz, ceilingz;
+	tic_t ahead;
+	viewprediction_t *guess;
+
+	predictionapplied = false;
+	predictiontics = 0;
+
+	if (!CL_CanPredictView())
+		return;
+
+	ahead = maketic - gametic;
+	if (!ahead || ahead > (tic_t)INT32_MAX)
+		return;
+	if (ahead > MAXPREDICTIONTICS)
+		ahead = MAXPREDICTIONTICS;
+
+	mo = player->mo;
+	x = mo->x + mo->momx*(INT32)ahead;
+	y = mo->y + mo->momy*(INT32)ahead;
+	z = mo->z + mo->momz*(INT32)ahead;
+
+	// Don't walk the view through walls or up ledges the player
+	// couldn't have stepped onto; keep the vertical part only.
+	sector = R_PointInSubsector(x, y)->sector;
+	floorz = P_GetFloorZ(mo, sector, x, y, NULL);
+	ceilingz = P_GetCeilingZ(mo, sector, x, y, NULL);
+	if (floorz > mo->z + MAXSTEPMOVE || ceilingz - floorz < mo->height)
+	{
+		x = mo->x;
+		y = mo->y;
+		floorz = mo->floorz;
+		ceilingz = mo->ceilingz;
+	}
+	if (z < floorz)
+		z = floorz;
+	if (z > ceilingz - mo->height)
+		z = ceilingz - mo->height;
+
+	guess = &viewpredictions[(gametic + ahead) % PREDICTIONBACKUP];
+	guess->tic = gametic + ahead;
+	guess->mo = mo;
+	guess->x = x;
+	guess->y = y;
+	guess->z = z;
+
+	predictdx = x - mo->x;
+	predictdy = y - mo->y;
+	predictdz = z - mo->z;
+	predictiontics = ahead;
+	if (!predictdx && !predictdy && !predictdz)
+		return;
+
+	mo->x += predictdx;
+	mo->y += predictdy;
+	mo->z += predictdz;
+	player->viewz += predictdz;
+
+	predictcamera = (camera.chase && cv_chasecam.value);
+	if (predictcamera)
+	{
+		camera.x += predictdx;
+		camera.y += predictdy;
+		camera.z += predictdz;
+	}
+
+	predictionapplied = true;
+}
+
+/** Puts back what CL_ApplyViewPrediction moved
+  */
+void CL_RestoreViewPrediction(void)
+{
+	player_t *player = &players[consoleplayer];
+
+	if (!predictionapplied)
+		return;
+	predictionapplied = false;
+
+	if (player->mo)
+	{
+		player->mo->x -= predictdx;
+		player->mo->y -= predictdy;
+		player->mo->z -= predictdz;
+	}
+	player->viewz -= predictdz;
+
+	if (predictcamera)
+	{
+		camera.x -= predictdx;
+		camera.y -= predictdy;
+		camera.z -= predictdz;
+	}
+}
+
+/** Compares the guess made for the tic that just ran with where
+  * the local player really ended up
+  */
+static void CL_CheckViewPrediction(void)
+{
+	viewprediction_t *guess = &viewpredictions[gametic % PREDICTIONBACKUP];
+	mobj_t *mo = players[consoleplayer].mo;
+	fixed_t error;
+
+	if (!cv_netprediction.value || server)
+		return;
+	if (guess->tic != gametic || !guess->mo)
+		return;
+
+	// Respawned or changed maps since the guess was made
+	if (guess->mo != mo || !mo)
+	{
+		CL_ClearViewPredictions();
+		return;
+	}
+
+	error = P_AproxDistance(P_AproxDistance(mo->x - guess->x, mo->y - guess->y), mo->z - guess->z);
+	guess->mo = NULL;
+
+	// Teleported, or the guesses are from before a resynch;
+	// nothing left in the history is worth comparing against.
+	if (error > PREDICTIONSNAP)
+	{
+		CONS_Debug(DBG_NETPLAY, "View prediction off by %d units on tic %u, dropping history\n", error>>FRACBITS, gametic);
+		CL_ClearViewPredictions();
+		return;
+	}
+
+	predictionerror = (predictionerror*7 + error)/8;
+}
+
 #ifdef NEWPING
 static inline void PingUpdate(void)
 {
@@ -4727,6 +5401,10 @@ FILESTAMP
 		if (!resynch_local_inprogress)
 			CL_SendClientCmd(); // Send tic cmd
 		hu_resynching = resynch_local_inprogress;
+#ifndef NONET
+		if (relaying)
+			CL_RelayTicker();
+#endif
 	}
 	else
 	{
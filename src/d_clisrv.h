@@ -472,7 +472,7 @@ extern UINT32 realpingtable[MAXPLAYERS];
 extern UINT32 playerpingtable[MAXPLAYERS];
 #endif
 
-extern consvar_t cv_joinnextround, cv_allownewplayer, cv_maxplayers, cv_resynchattempts, cv_blamecfail, cv_maxsend, cv_noticedownload, cv_downloadspeed;
+extern consvar_t cv_joinnextround, cv_allownewplayer, cv_maxplayers, cv_resynchattempts, cv_blamecfail, cv_maxsend, cv_noticedownload, cv_downloadspeed, cv_netprediction, cv_allowwatchers;
 
 // Used in d_net, the only dependence
 tic_t ExpandTics(INT32 low);
@@ -506,6 +506,12 @@ void D_QuitNetGame(void);
 //? How many ticks to run?
 void TryRunTics(tic_t realtic);
 
+// Draw the local player ahead of confirmed tics
+void CL_ApplyViewPrediction(void);
+void CL_RestoreViewPrediction(void);
+extern fixed_t predictionerror;
+extern tic_t predictiontics;
+
 // extra data for lmps
 // these functions scare me. they contain magic.
 /*boolean AddLmpExtradata(UINT8 **demo_p, INT32 playernum);
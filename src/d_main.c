@@ -384,6 +384,7 @@ static void D_Display(void)
 			{
 				topleft = screens[0] + viewwindowy*vid.width + viewwindowx;
 				objectsdrawn = 0;
+				CL_ApplyViewPrediction();
 #ifdef HWRENDER
 				if (rendermode != render_soft)
 					HWR_RenderPlayerView(0, &players[displayplayer]);
@@ -391,6 +392,7 @@ static void D_Display(void)
 #endif
 				if (rendermode != render_none)
 					R_RenderPlayerView(&players[displayplayer]);
+				CL_RestoreViewPrediction();
 			}
 
 			// render the second screen
@@ -514,6 +516,11 @@ static void D_Display(void)
 			V_DrawRightAlignedString(BASEVIDWIDTH, BASEVIDHEIGHT-ST_HEIGHT-20, V_YELLOWMAP, s);
 			snprintf(s, sizeof s - 1, "SysMiss %.2f%%", lostpercent);
 			V_DrawRightAlignedString(BASEVIDWIDTH, BASEVIDHEIGHT-ST_HEIGHT-10, V_YELLOWMAP, s);
+			if (cv_netprediction.value && !server)
+			{
+				snprintf(s, sizeof s - 1, "Predict %u tics, err %d", predictiontics, predictionerror>>FRACBITS);
+				V_DrawRightAlignedString(BASEVIDWIDTH, BASEVIDHEIGHT-ST_HEIGHT-50, V_YELLOWMAP, s);
+			}
 		}
 
 		I_FinishUpdate(); // page flip or blit buffer
@@ -526,9 +533,155 @@ static void D_Display(void)
 
 tic_t rendergametic;
 
+// =========================================================================
+// Frame pacing
+// =========================================================================
+
+// One tic's worth of wall-clock time, in microseconds.
+#define FRAMEBUDGET (1000000/TICRATE)
+
+static CV_PossibleValue_t fpscap_cons_t[] = {{0, "MIN"}, {TICRATE, "MAX"}, {0, NULL}};
+consvar_t cv_fpscap = {"fpscap", "0", CV_SAVE, fpscap_cons_t, NULL, 0, NULL, NULL, 0, 0, NULL};
+static CV_PossibleValue_t frameskip_cons_t[] = {{0, "MIN"}, {TICRATE/2, "MAX"}, {0, NULL}};
+consvar_t cv_frameskip = {"frameskip", "4", CV_SAVE, frameskip_cons_t, NULL, 0, NULL, NULL, 0, 0, NULL};
+
+static struct
+{
+	UINT32 frames;  // frames drawn
+	UINT32 skipped; // frames dropped so tics could stay on time
+	UINT32 capped;  // frames withheld by fpscap
+	UINT32 late;    // loops whose tic + draw time overran FRAMEBUDGET
+
+	UINT64 tictime, rendertime; // accumulated microseconds
+	UINT32 ticpeak, renderpeak;
+	UINT32 ticruns;             // loops that ran TryRunTics
+
+	UINT64 jitter;      // accumulated change between consecutive frame intervals
+	UINT32 lastframe;   // timestamp of the last drawn frame
+	UINT32 lastinterval;
+
+	UINT32 renderavg;  // running estimate of what a draw costs
+	UINT32 nextframe;  // fpscap schedule
+	UINT8 skiprun;     // consecutive skipped frames
+} framestats;
+
+/** Decides whether this loop can afford to draw a frame.
+  * Rendering is dropped when the game has already fallen behind the tic
+  * clock, so listen servers keep running and sending tics on time, but
+  * never for more than cv_frameskip frames in a row. cv_fpscap then limits
+  * how many of the remaining frames are drawn, independently of vsync.
+  *
+  * \param entertic  The tic the loop started on.
+  * \param realtics  How many tics were due this loop.
+  * \param ticcost   Microseconds spent in TryRunTics this loop.
+  * \return true if D_Display should be called.
+  */
+static boolean D_FramePacing(tic_t entertic, tic_t realtics, UINT32 ticcost)
+{
+	UINT32 now;
+
+	// Never drop frames that are being recorded or timed.
+	if (lastdraw || singletics || moviemode || takescreenshot || timingdemo)
+		return true;
+
+	if (framestats.skiprun < cv_frameskip.value
+	 && (I_GetTime() != entertic // the next tic is already due
+	 || (realtics > 1 && ticcost + framestats.renderavg > FRAMEBUDGET))) // still catching up
+	{
+		framestats.skiprun++;
+		framestats.skipped++;
+		return false;
+	}
+
+	if (cv_fpscap.value)
+	{
+		const UINT32 interval = 1000000/cv_fpscap.value;
+
+		now = I_GetTimeMicros();
+
+		// Frames only happen on tic boundaries, so let one through if it's
+		// at least half a tic close to schedule.
+		if ((INT32)(framestats.nextframe - now) > FRAMEBUDGET/2)
+		{
+			framestats.capped++;
+			return false;
+		}
+
+		if ((INT32)(now - framestats.nextframe) > (INT32)interval)
+			framestats.nextframe = now + interval; // fell far behind, resync
+		else
+			framestats.nextframe += interval;
+	}
+
+	framestats.skiprun = 0;
+	return true;
+}
+
+/** Draws a frame and records how long it took.
+  */
+static void D_DrawFrame(void)
+{
+	UINT32 start = I_GetTimeMicros(), cost, interval;
+
+	// Update display, next frame, with current state.
+	D_Display();
+
+	if (moviemode)
+		M_SaveFrame();
+	if (takescreenshot) // Only take screenshots after drawing.
+		M_DoScreenShot();
+
+	cost = I_GetTimeMicros() - start;
+
+	framestats.frames++;
+	framestats.rendertime += cost;
+	if (cost > framestats.renderpeak)
+		framestats.renderpeak = cost;
+	framestats.renderavg = (framestats.renderavg*7 + cost)/8;
+
+	if (framestats.frames > 1)
+	{
+		interval = start - framestats.lastframe;
+		if (framestats.frames > 2)
+			framestats.jitter += (interval > framestats.lastinterval)
+				? interval - framestats.lastinterval
+				: framestats.lastinterval - interval;
+		framestats.lastinterval = interval;
+	}
+	framestats.lastframe = start;
+}
+
+/** Prints frame pacing statistics gathered by D_SRB2Loop.
+  * "framestats reset" clears them.
+  */
+void Command_Framestats_f(void)
+{
+	if (COM_Argc() > 1 && !stricmp(COM_Argv(1), "reset"))
+	{
+		memset(&framestats, 0, sizeof (framestats));
+		CONS_Printf(M_GetText("Frame statistics reset.\n"));
+		return;
+	}
+
+	CONS_Printf(M_GetText("Frames drawn: %u, skipped: %u, capped: %u\n"),
+		framestats.frames, framestats.skipped, framestats.capped);
+	CONS_Printf(M_GetText("Late frames: %u (budget %u us)\n"), framestats.late, FRAMEBUDGET);
+
+	if (framestats.ticruns)
+		CONS_Printf(M_GetText("Tic time: avg %u us, peak %u us\n"),
+			(UINT32)(framestats.tictime / framestats.ticruns), framestats.ticpeak);
+	if (framestats.frames)
+		CONS_Printf(M_GetText("Render time: avg %u us, peak %u us\n"),
+			(UINT32)(framestats.rendertime / framestats.frames), framestats.renderpeak);
+	if (framestats.frames > 2)
+		CONS_Printf(M_GetText("Frame jitter: avg %u us\n"),
+			(UINT32)(framestats.jitter / (framestats.frames - 2)));
+}
+
 void D_SRB2Loop(void)
 {
 	tic_t oldentertics = 0, entertic = 0, realtics = 0, rendertimeout = INFTICS;
+	UINT32 loopstart, ticcost;
 
 	if (dedicated)
 		server = true;
@@ -594,7 +747,9 @@ void D_SRB2Loop(void)
 
 		if (!realtics && !singletics)
 		{
-			I_Sleep();
+			// Spare time goes to encoding movie frames
+			if (!M_EncodeMovieFrame())
+				I_Sleep();
 			continue;
 		}
 
@@ -608,20 +763,22 @@ void D_SRB2Loop(void)
 			realtics = 1;
 
 		// process tics (but maybe not if realtic == 0)
+		loopstart = I_GetTimeMicros();
 		TryRunTics(realtics);
+		ticcost = I_GetTimeMicros() - loopstart;
+
+		framestats.ticruns++;
+		framestats.tictime += ticcost;
+		if (ticcost > framestats.ticpeak)
+			framestats.ticpeak = ticcost;
 
 		if (lastdraw || singletics || gametic > rendergametic)
 		{
 			rendergametic = gametic;
 			rendertimeout = entertic+TICRATE/17;
 
-			// Update display, next frame, with current state.
-			D_Display();
-
-			if (moviemode)
-				M_SaveFrame();
-			if (takescreenshot) // Only take screenshots after drawing.
-				M_DoScreenShot();
+			if (D_FramePacing(entertic, realtics, ticcost))
+				D_DrawFrame();
 		}
 		else if (rendertimeout < entertic) // in case the server hang or netsplit
 		{
@@ -633,14 +790,14 @@ void D_SRB2Loop(void)
 				if (camera.chase)
 					P_MoveChaseCamera(&players[displayplayer], &camera, false);
 			}
-			D_Display();
 
-			if (moviemode)
-				M_SaveFrame();
-			if (takescreenshot) // Only take screenshots after drawing.
-				M_DoScreenShot();
+			if (D_FramePacing(entertic, realtics, ticcost))
+				D_DrawFrame();
 		}
 
+		if (I_GetTimeMicros() - loopstart > FRAMEBUDGET)
+			framestats.late++;
+
 		// consoleplayer -> displayplayer (hear sounds from viewpoint)
 		S_UpdateSounds(); // move positional sounds
 
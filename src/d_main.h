@@ -16,6 +16,7 @@
 
 #include "d_event.h"
 #include "w_wad.h"   // for MAX_WADFILES
+#include "command.h" // for consvar_t
 
 extern boolean advancedemo;
 
@@ -27,6 +28,10 @@ extern boolean usehome; //Alam: which path?
 extern const char *pandf; //Alam: how to path?
 extern char srb2path[256]; //Alam: SRB2's Home
 
+// frame pacing controls for D_SRB2Loop()
+extern consvar_t cv_fpscap, cv_frameskip;
+void Command_Framestats_f(void);
+
 // the infinite loop of D_SRB2Loop() called from win_main for windows version
 void D_SRB2Loop(void) FUNCNORETURN;
 
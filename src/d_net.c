@@ -310,6 +310,29 @@ INT32 Net_GetFreeAcks(boolean urgent)
 	return n;
 }
 
+/** Counts the reliable packets a node hasn't acknowledged yet
+  *
+  * \param node    The node
+  * \param resent  Set to true if any of them had to be resent
+  * \return The number of packets waiting for an ack
+  *
+  */
+INT32 Net_GetPendingAcks(INT32 node, boolean *resent)
+{
+	INT32 i, n = 0;
+
+	*resent = false;
+	for (i = 0; i < MAXACKPACKETS; i++)
+		if (ackpak[i].acknum && ackpak[i].destinationnode == node)
+		{
+			n++;
+			if (ackpak[i].resentnum)
+				*resent = true;
+		}
+
+	return n;
+}
+
 // Get a ack to send in the queue of this node
 static UINT8 GetAcktosend(INT32 node)
 {
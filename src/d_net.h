@@ -41,6 +41,7 @@ extern UINT8 playerpernode[MAXNETNODES]; // Used specially for splitscreen
 extern boolean nodeingame[MAXNETNODES]; // Set false as nodes leave game
 
 INT32 Net_GetFreeAcks(boolean urgent);
+INT32 Net_GetPendingAcks(INT32 node, boolean *resent);
 void Net_AckTicker(void);
 
 // If reliable return true if packet sent, 0 else
@@ -106,6 +106,8 @@ static void Fishcake_OnChange(void);
 static void Command_Playdemo_f(void);
 static void Command_Timedemo_f(void);
 static void Command_Stopdemo_f(void);
+static void Command_Demoseek_f(void);
+static void Command_Demorewind_f(void);
 static void Command_StartMovie_f(void);
 static void Command_StopMovie_f(void);
 static void Command_Map_f(void);
@@ -554,6 +556,8 @@ void D_RegisterServerCommands(void)
 	CV_RegisterVar(&cv_maxsend);
 	CV_RegisterVar(&cv_noticedownload);
 	CV_RegisterVar(&cv_downloadspeed);
+	CV_RegisterVar(&cv_netprediction);
+	CV_RegisterVar(&cv_allowwatchers);
 
 	COM_AddCommand("ping", Command_Ping_f);
 	CV_RegisterVar(&cv_nettimeout);
@@ -599,12 +603,22 @@ void D_RegisterClientCommands(void)
 	COM_AddCommand("numthinkers", Command_Numthinkers_f);
 	COM_AddCommand("countmobjs", Command_CountMobjs_f);
 
+	// d_main
+	CV_RegisterVar(&cv_fpscap);
+	CV_RegisterVar(&cv_frameskip);
+	COM_AddCommand("framestats", Command_Framestats_f);
+	COM_AddCommand("sightstats", Command_Sightstats_f);
+	COM_AddCommand("texturestats", Command_Texturestats_f);
+
 	COM_AddCommand("changeteam", Command_Teamchange_f);
 	COM_AddCommand("changeteam2", Command_Teamchange2_f);
 
 	COM_AddCommand("playdemo", Command_Playdemo_f);
 	COM_AddCommand("timedemo", Command_Timedemo_f);
 	COM_AddCommand("stopdemo", Command_Stopdemo_f);
+	COM_AddCommand("demoseek", Command_Demoseek_f);
+	COM_AddCommand("demorewind", Command_Demorewind_f);
+	CV_RegisterVar(&cv_demokeyframes);
 	COM_AddCommand("playintro", Command_Playintro_f);
 
 	COM_AddCommand("resetcamera", Command_ResetCamera_f);
@@ -1098,6 +1112,10 @@ static void SendNameAndColor(void)
 	XBOXSTATIC char buf[MAXPLAYERNAME+2];
 	char *p;
 
+	// a watcher has no player to rename
+	if (playerless)
+		return;
+
 	p = buf;
 
 	// normal player colors
@@ -1515,6 +1533,53 @@ static void Command_Stopdemo_f(void)
 	CONS_Printf(M_GetText("Stopped demo.\n"));
 }
 
+// jump to a point in the demo being played back
+// eg: demoseek 4:30 or demoseek 270
+static void Command_Demoseek_f(void)
+{
+	const char *arg, *colon;
+	INT32 seconds;
+
+	if (COM_Argc() != 2)
+	{
+		CONS_Printf(M_GetText("demoseek <seconds or mm:ss>: jump to a point in the demo\n"));
+		return;
+	}
+
+	arg = COM_Argv(1);
+	colon = strchr(arg, ':');
+	if (colon)
+		seconds = atoi(arg)*60 + atoi(colon+1);
+	else
+		seconds = atoi(arg);
+
+	if (seconds < 0)
+		seconds = 0;
+
+	G_SeekDemo((tic_t)seconds*TICRATE);
+}
+
+static void Command_Demorewind_f(void)
+{
+	INT32 seconds = 10;
+	tic_t tics;
+
+	if (COM_Argc() > 2)
+	{
+		CONS_Printf(M_GetText("demorewind [seconds]: go back in the demo, 10 seconds by default\n"));
+		return;
+	}
+
+	if (COM_Argc() == 2)
+		seconds = atoi(COM_Argv(1));
+
+	if (seconds <= 0)
+		return;
+
+	tics = (tic_t)seconds*TICRATE;
+	G_SeekDemo(demotic > tics ? demotic - tics : 0);
+}
+
 static void Command_StartMovie_f(void)
 {
 	M_StartMovie();
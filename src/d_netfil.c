@@ -63,7 +63,7 @@
 #include <errno.h>
 
 // Prototypes
-static boolean SV_SendFile(INT32 node, const char *filename, UINT8 fileid);
+static boolean SV_SendFile(INT32 node, const char *filename, UINT8 fileid, UINT32 position);
 
 // Sender structure
 typedef struct filetx_s
@@ -74,6 +74,7 @@ typedef struct filetx_s
 		char *ram; // Pointer to the data in RAM
 	} id;
 	UINT32 size; // Size of the file
+	UINT32 startposition; // Where to start sending from, when resuming a download
 	UINT8 fileid;
 	INT32 node; // Destination
 	struct filetx_s *next; // Next file in the list
@@ -85,6 +86,8 @@ typedef struct filetran_s
 	filetx_t *txlist; // Linked list of all files for the node
 	UINT32 position; // The current position in the file
 	FILE *currentfile; // The file currently being sent/received
+	INT32 window; // How many packets the node may have unacknowledged, 0 when idle
+	tic_t lastshrink; // When the window was last cut because packets were lost
 } filetran_t;
 static filetran_t transfer[MAXNETNODES];
 
@@ -164,6 +167,7 @@ void D_ParseFileneeded(INT32 fileneedednum_parm, UINT8 *fileneededstr)
 		fileneeded[i].willsend = (UINT8)(filestatus >> 4);
 		fileneeded[i].totalsize = READUINT32(p); // The four next bytes are the file size
 		fileneeded[i].file = NULL; // The file isn't open yet
+		fileneeded[i].currentsize = 0;
 		READSTRINGN(p, fileneeded[i].filename, MAX_WADPATH); // The next bytes are the file name
 		READMEM(p, fileneeded[i].md5sum, 16); // The last 16 bytes are the file checksum
 	}
@@ -173,8 +177,9 @@ void CL_PrepareDownloadSaveGame(const char *tmpsave)
 {
 	fileneedednum = 1;
 	fileneeded[0].status = FS_REQUESTED;
-	fileneeded[0].totalsize = UINT32_MAX;
+	fileneeded[0].totalsize = UINT32_MAX; // also means it can't be resumed
 	fileneeded[0].file = NULL;
+	fileneeded[0].currentsize = 0;
 	memset(fileneeded[0].md5sum, 0, 16);
 	strcpy(fileneeded[0].filename, tmpsave);
 }
@@ -245,16 +250,110 @@ boolean CL_CheckDownloadable(void)
 	return false;
 }
 
+// Files being downloaded are written to <name>.part. If the download is
+// interrupted, <name>.resume records the file's MD5 and how much of the
+// start of it arrived, so that the next request can ask for the rest.
+#define RESUMABLE(file) ((file)->totalsize != UINT32_MAX)
+
+static void CL_PartFileName(char *buf, const fileneeded_t *file, const char *ext)
+{
+	snprintf(buf, MAX_WADPATH+8, "%s.%s", file->filename, ext);
+	buf[MAX_WADPATH+7] = '\0';
+}
+
+static UINT32 CL_ResumePosition(const fileneeded_t *file)
+{
+	char partname[MAX_WADPATH+8], resumename[MAX_WADPATH+8];
+	UINT8 resume[20], *p = resume + 16;
+	UINT32 position = 0;
+	FILE *f;
+
+	CL_PartFileName(partname, file, "part");
+	CL_PartFileName(resumename, file, "resume");
+
+	f = fopen(resumename, "rb");
+	if (!f)
+		return 0;
+	if (fread(resume, 1, sizeof resume, f) == sizeof resume && !memcmp(resume, file->md5sum, 16))
+		position = READUINT32(p);
+	fclose(f);
+
+	if (position && position < file->totalsize)
+	{
+		f = fopen(partname, "rb");
+		if (f && !fseek(f, 0, SEEK_END) && ftell(f) >= (long)position)
+		{
+			fclose(f);
+			return position;
+		}
+		if (f)
+			fclose(f);
+	}
+
+	// Not the same file any more, or nothing to resume from
+	remove(resumename);
+	remove(partname);
+	return 0;
+}
+
+static void CL_MarkFragment(fileneeded_t *file, UINT32 pos, UINT16 size, boolean last)
+{
+	UINT32 n;
+
+	if (!RESUMABLE(file) || pos < file->resumeposition)
+		return;
+	pos -= file->resumeposition;
+
+	// All fragments but the last are the same size
+	if (!file->fragmentsize && !last && size)
+	{
+		file->fragmentsize = size;
+		file->numfragments = (file->totalsize - file->resumeposition + size - 1) / size;
+		file->fragments = calloc((file->numfragments + 7) / 8, 1);
+		if (!file->fragments)
+			file->fragmentsize = 0;
+	}
+	if (!file->fragmentsize || pos % file->fragmentsize)
+		return;
+
+	n = pos / file->fragmentsize;
+	if (n < file->numfragments)
+		file->fragments[n >> 3] |= (UINT8)(1 << (n & 7));
+}
+
+// How much of the start of the file has arrived without gaps
+static UINT32 CL_ContiguousSize(const fileneeded_t *file)
+{
+	UINT32 n = 0;
+
+	if (!file->fragments)
+		return file->resumeposition;
+
+	while (n < file->numfragments && (file->fragments[n >> 3] & (1 << (n & 7))))
+		n++;
+	return min(file->resumeposition + n * file->fragmentsize, file->totalsize);
+}
+
+static void CL_FreeFragments(fileneeded_t *file)
+{
+	free(file->fragments);
+	file->fragments = NULL;
+	file->fragmentsize = file->numfragments = 0;
+}
+
 /** Sends requests for files in the ::fileneeded table with a status of
   * ::FS_NOTFOUND.
   *
+  * As many as fit in one textcmd are asked for; the rest are left as
+  * they are, to be asked for once these have arrived.
+  *
   * \return True if the packet was successfully sent
   * \note Sends a PT_REQUESTFILE packet
   *
   */
 boolean CL_SendRequestFile(void)
 {
-	char *p;
+	char *p, *end;
 	INT32 i;
 	INT64 totalfreespaceneeded = 0, availablefreespace;
 
@@ -272,15 +371,24 @@ boolean CL_SendRequestFile(void)
 
 	netbuffer->packettype = PT_REQUESTFILE;
 	p = (char *)netbuffer->u.textcmd;
+	end = p + MAXTEXTCMD - 1; // leave room for the 0xFF
 	for (i = 0; i < fileneedednum; i++)
 		if ((fileneeded[i].status == FS_NOTFOUND || fileneeded[i].status == FS_MD5SUMBAD))
 		{
-			totalfreespaceneeded += fileneeded[i].totalsize;
 			nameonly(fileneeded[i].filename);
+			// fileid, name and position; ask for the rest next time
+			if (p != (char *)netbuffer->u.textcmd
+				&& p + 1 + strlen(fileneeded[i].filename) + 1 + 4 > end)
+				break;
+			totalfreespaceneeded += fileneeded[i].totalsize;
 			WRITEUINT8(p, i); // fileid
-			WRITESTRINGN(p, fileneeded[i].filename, MAX_WADPATH);
+			WRITESTRINGN(p, fileneeded[i].filename, MAXTEXTCMD - 1 - 1 - 4);
 			// put it in download dir
 			strcatbf(fileneeded[i].filename, downloaddir, "/");
+			// pick up where an interrupted download left off
+			fileneeded[i].currentsize = CL_ResumePosition(&fileneeded[i]);
+			WRITEUINT32(p, fileneeded[i].currentsize);
+			totalfreespaceneeded -= fileneeded[i].currentsize;
 			fileneeded[i].status = FS_REQUESTED;
 		}
 	WRITEUINT8(p, 0xFF);
@@ -302,13 +410,20 @@ boolean Got_RequestFilePak(INT32 node)
 	char wad[MAX_WADPATH+1];
 	UINT8 *p = netbuffer->u.textcmd;
 	UINT8 id;
+	UINT32 position;
 	while (p < netbuffer->u.textcmd + MAXTEXTCMD-1) // Don't allow hacked client to overflow
 	{
 		id = READUINT8(p);
 		if (id == 0xFF)
 			break;
 		READSTRINGN(p, wad, MAX_WADPATH);
-		if (!SV_SendFile(node, wad, id))
+		if (p + 4 > netbuffer->u.textcmd + MAXTEXTCMD)
+		{
+			SV_AbortSendFiles(node);
+			return false; // hacked client
+		}
+		position = READUINT32(p);
+		if (!SV_SendFile(node, wad, id, position))
 		{
 			SV_AbortSendFiles(node);
 			return false; // don't read the rest of the files
@@ -464,10 +579,11 @@ static INT32 filestosend = 0;
   * \param node The node to send the file to
   * \param filename The file to send
   * \param fileid ???
+  * \param position Where to start from, if the node already has part of the file
   * \sa SV_SendRam
   *
   */
-static boolean SV_SendFile(INT32 node, const char *filename, UINT8 fileid)
+static boolean SV_SendFile(INT32 node, const char *filename, UINT8 fileid, UINT32 position)
 {
 	filetx_t **q; // A pointer to the "next" field of the last file in the list
 	filetx_t *p; // The new file request
@@ -542,6 +658,7 @@ static boolean SV_SendFile(INT32 node, const char *filename, UINT8 fileid)
 	DEBFILE(va("Sending file %s (id=%d) to %d\n", filename, fileid, node));
 	p->ram = SF_FILE; // It's a file, we need to close it and free its name once we're done sending it
 	p->fileid = fileid;
+	p->startposition = position;
 	p->next = NULL; // End of list
 	filestosend++;
 	return true;
@@ -621,17 +738,27 @@ static void SV_EndFileSend(INT32 node)
 
 	// Indicate that the transmission is over
 	transfer[node].currentfile = NULL;
+	if (!transfer[node].txlist)
+		transfer[node].window = 0;
 
 	filestosend--;
 }
 
 #define PACKETPERTIC net_bandwidth/(TICRATE*software_MAXPACKETLENGTH)
 
+// Each node gets a window of packets it may have in flight. It grows by one
+// every tic the node keeps it full, and halves when packets have to be
+// resent, at most once per FILEWINDOWSHRINKTIME.
+#define FILEWINDOWSTART 4
+#define FILEWINDOWMAX 64
+#define FILEWINDOWSHRINKTIME (TICRATE/2)
+
 /** Handles file transmission
   *
-  * \todo Use an acknowledging method more adapted to file transmission
-  *       The current download speed suffers from lack of ack packets,
-  *       especially when the one downloading has high latency
+  * The number of packets sent each tic is capped by cv_downloadspeed (or
+  * the old bandwidth-based rate) and by the free acks, and each node is
+  * further held to its congestion window, so a slow or lossy node doesn't
+  * use up the acks everyone else needs.
   *
   */
 void SV_FileSendTicker(void)
@@ -642,6 +769,7 @@ void SV_FileSendTicker(void)
 	filetx_t *f;
 	INT32 packetsent, ram, i, j;
 	INT32 maxpacketsent;
+	INT32 inflight[MAXNETNODES];
 
 	if (!filestosend) // No file to send
 		return;
@@ -665,6 +793,32 @@ void SV_FileSendTicker(void)
 			packetsent = 1;
 	}
 
+	// Grow or shrink each node's window from what happened to its packets
+	for (i = 0; i < MAXNETNODES; i++)
+	{
+		boolean resent = false;
+
+		inflight[i] = 0;
+		if (!transfer[i].txlist)
+			continue;
+
+		if (!transfer[i].window)
+			transfer[i].window = FILEWINDOWSTART;
+#ifndef NONET
+		inflight[i] = Net_GetPendingAcks(i, &resent);
+#endif
+		if (resent)
+		{
+			if (I_GetTime() - transfer[i].lastshrink >= FILEWINDOWSHRINKTIME)
+			{
+				transfer[i].window = max(transfer[i].window / 2, 1);
+				transfer[i].lastshrink = I_GetTime();
+			}
+		}
+		else if (inflight[i] >= transfer[i].window - 1 && transfer[i].window < FILEWINDOWMAX)
+			transfer[i].window++;
+	}
+
 	netbuffer->packettype = PT_FILEFRAGMENT;
 
 	// (((sendbytes-nowsentbyte)*TICRATE)/(I_GetTime()-starttime)<(UINT32)net_bandwidth)
@@ -673,11 +827,11 @@ void SV_FileSendTicker(void)
 		for (i = currentnode, j = 0; j < MAXNETNODES;
 			i = (i+1) % MAXNETNODES, j++)
 		{
-			if (transfer[i].txlist)
+			if (transfer[i].txlist && inflight[i] < transfer[i].window)
 				goto found;
 		}
-		// no transfer to do
-		I_Error("filestosend=%d but no file to send found\n", filestosend);
+		// every node has a full window
+		break;
 	found:
 		currentnode = (i+1) % MAXNETNODES;
 		f = transfer[i].txlist;
@@ -697,6 +851,9 @@ void SV_FileSendTicker(void)
 					I_Error("File %s does not exist",
 						f->id.filename);
 
+				// Read ahead in big blocks rather than a packet at a time
+				setvbuf(transfer[i].currentfile, NULL, _IOFBF, 64*1024);
+
 				fseek(transfer[i].currentfile, 0, SEEK_END);
 				filesize = ftell(transfer[i].currentfile);
 
@@ -708,11 +865,15 @@ void SV_FileSendTicker(void)
 					I_Error("Error getting filesize of %s", f->id.filename);
 
 				f->size = (UINT32)filesize;
-				fseek(transfer[i].currentfile, 0, SEEK_SET);
+
+				// Resuming past the end can only be a confused client
+				if (f->startposition >= f->size)
+					f->startposition = 0;
+				fseek(transfer[i].currentfile, f->startposition, SEEK_SET);
 			}
 			else // Sending RAM
 				transfer[i].currentfile = (FILE *)1; // Set currentfile to a non-null value to indicate that it is open
-			transfer[i].position = 0;
+			transfer[i].position = f->startposition;
 		}
 
 		// Build a packet containing a file fragment
@@ -734,6 +895,7 @@ void SV_FileSendTicker(void)
 		// Send the packet
 		if (HSendPacket(i, true, 0, FILETXHEADER + size)) // Reliable SEND
 		{ // Success
+			inflight[i]++;
 			transfer[i].position = (UINT32)(transfer[i].position + size);
 			if (transfer[i].position == f->size) // Finish?
 				SV_EndFileSend(i);
@@ -774,13 +936,25 @@ void Got_Filetxpak(void)
 
 	if (file->status == FS_REQUESTED)
 	{
+		char partname[MAX_WADPATH+8];
+
 		if (file->file)
 			I_Error("Got_Filetxpak: already open file\n");
-		file->file = fopen(filename, "wb");
+		CL_FreeFragments(file);
+		file->resumeposition = file->currentsize;
+		if (RESUMABLE(file))
+		{
+			CL_PartFileName(partname, file, "part");
+			file->file = fopen(partname, file->resumeposition ? "r+b" : "wb");
+		}
+		else
+			file->file = fopen(filename, "wb");
 		if (!file->file)
 			I_Error("Can't create file %s: %s", filename, strerror(errno));
-		CONS_Printf("\r%s...\n",filename);
-		file->currentsize = 0;
+		if (file->resumeposition)
+			CONS_Printf("\r%s... (resuming from %s KB)\n", filename, sizeu1(file->resumeposition >> 10));
+		else
+			CONS_Printf("\r%s...\n",filename);
 		file->status = FS_DOWNLOADING;
 	}
 
@@ -788,24 +962,39 @@ void Got_Filetxpak(void)
 	{
 		UINT32 pos = LONG(netbuffer->u.filetxpak.position);
 		UINT16 size = SHORT(netbuffer->u.filetxpak.size);
+		boolean last = false;
 		// Use a special trick to know when the file is complete (not always used)
 		// WARNING: file fragments can arrive out of order so don't stop yet!
 		if (pos & 0x80000000)
 		{
 			pos &= ~0x80000000;
 			file->totalsize = pos + size;
+			last = true;
 		}
 		// We can receive packet in the wrong order, anyway all os support gaped file
 		fseek(file->file, pos, SEEK_SET);
 		if (fwrite(netbuffer->u.filetxpak.data,size,1,file->file) != 1)
 			I_Error("Can't write to %s: %s\n",filename, strerror(ferror(file->file)));
 		file->currentsize += size;
+		CL_MarkFragment(file, pos, size, last);
 
 		// Finished?
 		if (file->currentsize == file->totalsize)
 		{
 			fclose(file->file);
 			file->file = NULL;
+			if (RESUMABLE(file))
+			{
+				char partname[MAX_WADPATH+8];
+
+				CL_PartFileName(partname, file, "part");
+				remove(filename); // a copy with the wrong MD5 may be in the way
+				if (rename(partname, filename))
+					I_Error("Can't rename %s to %s: %s\n", partname, filename, strerror(errno));
+				CL_PartFileName(partname, file, "resume");
+				remove(partname);
+				CL_FreeFragments(file);
+			}
 			file->status = FS_FOUND;
 			CONS_Printf(M_GetText("Downloading %s...(done)\n"),
 				filename);
@@ -880,9 +1069,40 @@ void CloseNetFile(void)
 	for (i = 0; i < MAX_WADFILES; i++)
 		if (fileneeded[i].status == FS_DOWNLOADING && fileneeded[i].file)
 		{
-			fclose(fileneeded[i].file);
-			// File is not complete delete it
-			remove(fileneeded[i].filename);
+			fileneeded_t *file = &fileneeded[i];
+			char partname[MAX_WADPATH+8];
+			UINT32 contiguous;
+			UINT8 resume[20], *p = resume + 16;
+			FILE *f;
+
+			fclose(file->file);
+			file->file = NULL;
+
+			if (!RESUMABLE(file))
+			{
+				// File is not complete delete it
+				remove(file->filename);
+				continue;
+			}
+
+			// Keep what arrived so the download can be resumed
+			contiguous = CL_ContiguousSize(file);
+			CL_FreeFragments(file);
+			CL_PartFileName(partname, file, "resume");
+			if (contiguous && (f = fopen(partname, "wb")) != NULL)
+			{
+				M_Memcpy(resume, file->md5sum, 16);
+				WRITEUINT32(p, contiguous);
+				if (fwrite(resume, 1, sizeof resume, f) == sizeof resume)
+				{
+					fclose(f);
+					continue;
+				}
+				fclose(f);
+			}
+			remove(partname);
+			CL_PartFileName(partname, file, "part");
+			remove(partname);
 		}
 
 	// Remove PT_FILEFRAGMENT from acknowledge list
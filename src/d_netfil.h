@@ -43,6 +43,11 @@ typedef struct
 	UINT32 currentsize;
 	UINT32 totalsize;
 	filestatus_t status; // The value returned by recsearch
+	// Used to resume interrupted downloads
+	UINT32 resumeposition; // Where this download started
+	UINT32 fragmentsize; // Size of the server's fragments, 0 until known
+	UINT32 numfragments;
+	UINT8 *fragments; // One bit per fragment received since resumeposition
 } fileneeded_t;
 
 extern INT32 fileneedednum;
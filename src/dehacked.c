@@ -59,10 +59,30 @@ static UINT8 used_spr[(NUMSPRITEFREESLOTS / 8) + 1]; // Bitwise flag for sprite
 memset(FREE_STATES,0,sizeof(char *) * NUMSTATEFREESLOTS);\
 memset(FREE_MOBJS,0,sizeof(char *) * NUMMOBJFREESLOTS);\
 memset(used_spr,0,sizeof(UINT8) * ((NUMSPRITEFREESLOTS / 8) + 1));\
+DEH_ClearConsts();\
 }
 
 // Crazy word-reading stuff
 /// \todo Put these in a seperate file or something.
+
+// Kinds of names in the constant hash table
+typedef enum
+{
+	CONST_STATE,     // value is the statenum_t
+	CONST_MOBJTYPE,  // value is the mobjtype_t
+	CONST_MOBJFLAG,  // value is the bit number
+	CONST_MOBJFLAG2,
+	CONST_MOBJEFLAG,
+	CONST_PLAYERFLAG,
+	CONST_POWER,     // value is the list index
+	CONST_HUDITEM,
+	CONST_SKINCOLOR,
+	CONST_INTEGER    // value is the index in INT_CONST
+} consttype_t;
+
+static void DEH_AddFreeslotConst(consttype_t type, const char *name, INT32 value);
+static void DEH_ClearConsts(void);
+
 static mobjtype_t get_mobjtype(const char *word);
 static statenum_t get_state(const char *word);
 static spritenum_t get_sprite(const char *word);
@@ -663,6 +683,7 @@ static void readfreeslots(MYFILE *f)
 					if (!FREE_STATES[i]) {
 						FREE_STATES[i] = Z_Malloc(strlen(word)+1, PU_STATIC, NULL);
 						strcpy(FREE_STATES[i],word);
+						DEH_AddFreeslotConst(CONST_STATE, FREE_STATES[i], S_FIRSTFREESLOT+i);
 						break;
 					}
 			}
@@ -672,6 +693,7 @@ static void readfreeslots(MYFILE *f)
 					if (!FREE_MOBJS[i]) {
 						FREE_MOBJS[i] = Z_Malloc(strlen(word)+1, PU_STATIC, NULL);
 						strcpy(FREE_MOBJS[i],word);
+						DEH_AddFreeslotConst(CONST_MOBJTYPE, FREE_MOBJS[i], MT_FIRSTFREESLOT+i);
 						break;
 					}
 			}
@@ -6729,6 +6751,7 @@ static const char *const MOBJFLAG2_LIST[] = {
 	"BOSSNOTRAP",	// No Egg Trap after boss
 	"BOSSFLEE",		// Boss is fleeing!
 	"BOSSDEAD",		// Boss is dead! (Not necessarily fleeing, if a fleeing point doesn't exist.)
+	"DORMANT",		// Nothing to do; only the state is cycled until something wakes it.
 	NULL
 };
 
@@ -7447,42 +7470,149 @@ struct {
 	{NULL,0}
 };
 
+// Hashed lookup of the enum name lists above, so that SOC and Lua
+// constants do not have to walk thousands of names. The table is filled
+// from the lists the first time it is needed, and freeslots are added to
+// it as they are allocated. Keys are the names without their prefix, so
+// an entry can point straight into the list it came from.
+
+typedef struct
+{
+	const char *name; // NULL if unused
+	INT32 value;
+	UINT8 type;
+} consthash_t;
+
+#define CONSTHASHSIZE 16384 // more than twice the number of names
+
+static consthash_t *consthash = NULL;
+static size_t numconsts = 0;
+
+static UINT32 DEH_HashConst(consttype_t type, const char *name)
+{
+	UINT32 hash = 2166136261u ^ (UINT32)type;
+	while (*name)
+		hash = (hash ^ (UINT8)*name++) * 16777619u;
+	return hash;
+}
+
+static consthash_t *DEH_ConstSlot(consttype_t type, const char *name)
+{
+	UINT32 i = DEH_HashConst(type, name) & (CONSTHASHSIZE-1);
+
+	while (consthash[i].name && !(consthash[i].type == type && fastcmp(consthash[i].name, name)))
+		i = (i + 1) & (CONSTHASHSIZE-1);
+	return &consthash[i];
+}
+
+static void DEH_AddConst(consttype_t type, const char *name, INT32 value, INT32 firstfreeslot)
+{
+	consthash_t *slot = DEH_ConstSlot(type, name);
+
+	if (slot->name)
+	{
+		// the lists are searched front to back, and freeslots before
+		// the hardcoded names
+		if (slot->value < firstfreeslot)
+			slot->value = value;
+		return;
+	}
+
+	if (++numconsts > CONSTHASHSIZE/2)
+		I_Error("DEH_AddConst: CONSTHASHSIZE is too small");
+
+	slot->name = name;
+	slot->type = (UINT8)type;
+	slot->value = value;
+}
+
+static void DEH_HashConstants(void)
+{
+	INT32 i;
+
+	consthash = Z_Calloc(CONSTHASHSIZE * sizeof (*consthash), PU_STATIC, NULL);
+
+	for (i = 0; i < S_FIRSTFREESLOT; i++)
+		DEH_AddConst(CONST_STATE, STATE_LIST[i]+2, i, 0);
+	for (i = 0; i < MT_FIRSTFREESLOT; i++)
+		DEH_AddConst(CONST_MOBJTYPE, MOBJTYPE_LIST[i]+3, i, 0);
+	for (i = 0; MOBJFLAG_LIST[i]; i++)
+		DEH_AddConst(CONST_MOBJFLAG, MOBJFLAG_LIST[i], i, 0);
+	for (i = 0; MOBJFLAG2_LIST[i]; i++)
+		DEH_AddConst(CONST_MOBJFLAG2, MOBJFLAG2_LIST[i], i, 0);
+	for (i = 0; MOBJEFLAG_LIST[i]; i++)
+		DEH_AddConst(CONST_MOBJEFLAG, MOBJEFLAG_LIST[i], i, 0);
+	for (i = 0; PLAYERFLAG_LIST[i]; i++)
+		DEH_AddConst(CONST_PLAYERFLAG, PLAYERFLAG_LIST[i], i, 0);
+	for (i = 0; i < NUMPOWERS; i++)
+		DEH_AddConst(CONST_POWER, POWERS_LIST[i], i, 0);
+	for (i = 0; i < NUMHUDITEMS; i++)
+		DEH_AddConst(CONST_HUDITEM, HUDITEMS_LIST[i], i, 0);
+	for (i = 0; i < MAXTRANSLATIONS; i++)
+		DEH_AddConst(CONST_SKINCOLOR, COLOR_ENUMS[i], i, 0);
+	for (i = 0; INT_CONST[i].n; i++)
+		DEH_AddConst(CONST_INTEGER, INT_CONST[i].n, i, 0);
+
+	// freeslots allocated before the table existed
+	for (i = 0; i < NUMSTATEFREESLOTS && FREE_STATES[i]; i++)
+		DEH_AddConst(CONST_STATE, FREE_STATES[i], S_FIRSTFREESLOT+i, S_FIRSTFREESLOT);
+	for (i = 0; i < NUMMOBJFREESLOTS && FREE_MOBJS[i]; i++)
+		DEH_AddConst(CONST_MOBJTYPE, FREE_MOBJS[i], MT_FIRSTFREESLOT+i, MT_FIRSTFREESLOT);
+}
+
+// Looks up a name without its prefix, case sensitive like fastcmp
+static boolean DEH_FindConst(consttype_t type, const char *name, INT32 *value)
+{
+	consthash_t *slot;
+
+	if (!consthash)
+		DEH_HashConstants();
+
+	slot = DEH_ConstSlot(type, name);
+	if (!slot->name)
+		return false;
+	*value = slot->value;
+	return true;
+}
+
+// Registers a freeslot name once it has been given its slot
+static void DEH_AddFreeslotConst(consttype_t type, const char *name, INT32 value)
+{
+	if (consthash)
+		DEH_AddConst(type, name, value, type == CONST_STATE ? S_FIRSTFREESLOT : MT_FIRSTFREESLOT);
+}
+
+// Forgets the freeslot names, the table is filled again on the next lookup
+static void DEH_ClearConsts(void)
+{
+	if (consthash)
+		Z_Free(consthash);
+	consthash = NULL;
+	numconsts = 0;
+}
+
 static mobjtype_t get_mobjtype(const char *word)
 { // Returns the vlaue of MT_ enumerations
-	mobjtype_t i;
+	INT32 i;
 	if (*word >= '0' && *word <= '9')
 		return atoi(word);
 	if (fastncmp("MT_",word,3))
 		word += 3; // take off the MT_
-	for (i = 0; i < NUMMOBJFREESLOTS; i++) {
-		if (!FREE_MOBJS[i])
-			break;
-		if (fastcmp(word, FREE_MOBJS[i]))
-			return MT_FIRSTFREESLOT+i;
-	}
-	for (i = 0; i < MT_FIRSTFREESLOT; i++)
-		if (fastcmp(word, MOBJTYPE_LIST[i]+3))
-			return i;
+	if (DEH_FindConst(CONST_MOBJTYPE, word, &i))
+		return i;
 	deh_warning("Couldn't find mobjtype named 'MT_%s'",word);
 	return MT_BLUECRAWLA;
 }
 
 static statenum_t get_state(const char *word)
 { // Returns the value of S_ enumerations
-	statenum_t i;
+	INT32 i;
 	if (*word >= '0' && *word <= '9')
 		return atoi(word);
 	if (fastncmp("S_",word,2))
 		word += 2; // take off the S_
-	for (i = 0; i < NUMSTATEFREESLOTS; i++) {
-		if (!FREE_STATES[i])
-			break;
-		if (fastcmp(word, FREE_STATES[i]))
-			return S_FIRSTFREESLOT+i;
-	}
-	for (i = 0; i < S_FIRSTFREESLOT; i++)
-		if (fastcmp(word, STATE_LIST[i]+2))
-			return i;
+	if (DEH_FindConst(CONST_STATE, word, &i))
+		return i;
 	deh_warning("Couldn't find state named 'S_%s'",word);
 	return S_NULL;
 }
@@ -7559,14 +7689,13 @@ static UINT16 get_mus(const char *word, UINT8 dehacked_mode)
 
 static hudnum_t get_huditem(const char *word)
 { // Returns the value of HUD_ enumerations
-	hudnum_t i;
+	INT32 i;
 	if (*word >= '0' && *word <= '9')
 		return atoi(word);
 	if (fastncmp("HUD_",word,4))
 		word += 4; // take off the HUD_
-	for (i = 0; i < NUMHUDITEMS; i++)
-		if (fastcmp(word, HUDITEMS_LIST[i]))
-			return i;
+	if (DEH_FindConst(CONST_HUDITEM, word, &i))
+		return i;
 	deh_warning("Couldn't find huditem named 'HUD_%s'",word);
 	return HUD_LIVESNAME;
 }
@@ -7574,14 +7703,13 @@ static hudnum_t get_huditem(const char *word)
 #ifndef HAVE_BLUA
 static powertype_t get_power(const char *word)
 { // Returns the vlaue of pw_ enumerations
-	powertype_t i;
+	INT32 i;
 	if (*word >= '0' && *word <= '9')
 		return atoi(word);
 	if (fastncmp("PW_",word,3))
 		word += 3; // take off the pw_
-	for (i = 0; i < NUMPOWERS; i++)
-		if (fastcmp(word, POWERS_LIST[i]))
-			return i;
+	if (DEH_FindConst(CONST_POWER, word, &i))
+		return i;
 	deh_warning("Couldn't find power named 'pw_%s'",word);
 	return pw_invulnerability;
 }
@@ -7683,11 +7811,10 @@ static fixed_t find_const(const char **rword)
 	}
 	if (fastncmp("MF_", word, 3)) {
 		char *p = word+3;
-		for (i = 0; MOBJFLAG_LIST[i]; i++)
-			if (fastcmp(p, MOBJFLAG_LIST[i])) {
-				free(word);
-				return (1<<i);
-			}
+		if (DEH_FindConst(CONST_MOBJFLAG, p, &i)) {
+			free(word);
+			return (1<<i);
+		}
 
 		// Not found error
 		const_warning("mobj flag",word);
@@ -7696,11 +7823,10 @@ static fixed_t find_const(const char **rword)
 	}
 	else if (fastncmp("MF2_", word, 4)) {
 		char *p = word+4;
-		for (i = 0; MOBJFLAG2_LIST[i]; i++)
-			if (fastcmp(p, MOBJFLAG2_LIST[i])) {
-				free(word);
-				return (1<<i);
-			}
+		if (DEH_FindConst(CONST_MOBJFLAG2, p, &i)) {
+			free(word);
+			return (1<<i);
+		}
 
 		// Not found error
 		const_warning("mobj flag2",word);
@@ -7709,11 +7835,10 @@ static fixed_t find_const(const char **rword)
 	}
 	else if (fastncmp("MFE_", word, 4)) {
 		char *p = word+4;
-		for (i = 0; MOBJEFLAG_LIST[i]; i++)
-			if (fastcmp(p, MOBJEFLAG_LIST[i])) {
-				free(word);
-				return (1<<i);
-			}
+		if (DEH_FindConst(CONST_MOBJEFLAG, p, &i)) {
+			free(word);
+			return (1<<i);
+		}
 
 		// Not found error
 		const_warning("mobj eflag",word);
@@ -7722,11 +7847,10 @@ static fixed_t find_const(const char **rword)
 	}
 	else if (fastncmp("PF_", word, 3)) {
 		char *p = word+3;
-		for (i = 0; PLAYERFLAG_LIST[i]; i++)
-			if (fastcmp(p, PLAYERFLAG_LIST[i])) {
-				free(word);
-				return (1<<i);
-			}
+		if (DEH_FindConst(CONST_PLAYERFLAG, p, &i)) {
+			free(word);
+			return (1<<i);
+		}
 		if (fastcmp(p, "FULLSTASIS"))
 			return PF_FULLSTASIS;
 
@@ -7774,20 +7898,18 @@ static fixed_t find_const(const char **rword)
 	}
 	else if (fastncmp("SKINCOLOR_",word,10)) {
 		char *p = word+10;
-		for (i = 0; i < MAXTRANSLATIONS; i++)
-			if (fastcmp(p, COLOR_ENUMS[i])) {
-				free(word);
-				return i;
-			}
+		if (DEH_FindConst(CONST_SKINCOLOR, p, &i)) {
+			free(word);
+			return i;
+		}
 		const_warning("color",word);
 		free(word);
 		return 0;
 	}
-	for (i = 0; INT_CONST[i].n; i++)
-		if (fastcmp(word,INT_CONST[i].n)) {
-			free(word);
-			return INT_CONST[i].v;
-		}
+	if (DEH_FindConst(CONST_INTEGER, word, &i)) {
+		free(word);
+		return INT_CONST[i].v;
+	}
 
 	// Not found error.
 	const_warning("constant",word);
@@ -7918,6 +8040,7 @@ static inline int lib_freeslot(lua_State *L)
 					CONS_Printf("State S_%s allocated.\n",word);
 					FREE_STATES[i] = Z_Malloc(strlen(word)+1, PU_STATIC, NULL);
 					strcpy(FREE_STATES[i],word);
+					DEH_AddFreeslotConst(CONST_STATE, FREE_STATES[i], S_FIRSTFREESLOT+i);
 					lua_pushinteger(L, i);
 					r++;
 					break;
@@ -7933,6 +8056,7 @@ static inline int lib_freeslot(lua_State *L)
 					CONS_Printf("MobjType MT_%s allocated.\n",word);
 					FREE_MOBJS[i] = Z_Malloc(strlen(word)+1, PU_STATIC, NULL);
 					strcpy(FREE_MOBJS[i],word);
+					DEH_AddFreeslotConst(CONST_MOBJTYPE, FREE_MOBJS[i], MT_FIRSTFREESLOT+i);
 					lua_pushinteger(L, i);
 					r++;
 					break;
@@ -7991,31 +8115,28 @@ static inline int lib_getenum(lua_State *L)
 	}
 	else if (fastncmp("MF_", word, 3)) {
 		p = word+3;
-		for (i = 0; MOBJFLAG_LIST[i]; i++)
-			if (fastcmp(p, MOBJFLAG_LIST[i])) {
-				lua_pushinteger(L, ((lua_Integer)1<<i));
-				return 1;
-			}
+		if (DEH_FindConst(CONST_MOBJFLAG, p, &i)) {
+			lua_pushinteger(L, ((lua_Integer)1<<i));
+			return 1;
+		}
 		if (mathlib) return luaL_error(L, "mobjflag '%s' could not be found.\n", word);
 		return 0;
 	}
 	else if (fastncmp("MF2_", word, 4)) {
 		p = word+4;
-		for (i = 0; MOBJFLAG2_LIST[i]; i++)
-			if (fastcmp(p, MOBJFLAG2_LIST[i])) {
-				lua_pushinteger(L, ((lua_Integer)1<<i));
-				return 1;
-			}
+		if (DEH_FindConst(CONST_MOBJFLAG2, p, &i)) {
+			lua_pushinteger(L, ((lua_Integer)1<<i));
+			return 1;
+		}
 		if (mathlib) return luaL_error(L, "mobjflag2 '%s' could not be found.\n", word);
 		return 0;
 	}
 	else if (fastncmp("MFE_", word, 4)) {
 		p = word+4;
-		for (i = 0; MOBJEFLAG_LIST[i]; i++)
-			if (fastcmp(p, MOBJEFLAG_LIST[i])) {
-				lua_pushinteger(L, ((lua_Integer)1<<i));
-				return 1;
-			}
+		if (DEH_FindConst(CONST_MOBJEFLAG, p, &i)) {
+			lua_pushinteger(L, ((lua_Integer)1<<i));
+			return 1;
+		}
 		if (mathlib) return luaL_error(L, "mobjeflag '%s' could not be found.\n", word);
 		return 0;
 	}
@@ -8031,11 +8152,10 @@ static inline int lib_getenum(lua_State *L)
 	}
 	else if (fastncmp("PF_", word, 3)) {
 		p = word+3;
-		for (i = 0; PLAYERFLAG_LIST[i]; i++)
-			if (fastcmp(p, PLAYERFLAG_LIST[i])) {
-				lua_pushinteger(L, ((lua_Integer)1<<i));
-				return 1;
-			}
+		if (DEH_FindConst(CONST_PLAYERFLAG, p, &i)) {
+			lua_pushinteger(L, ((lua_Integer)1<<i));
+			return 1;
+		}
 		if (fastcmp(p, "FULLSTASIS"))
 		{
 			lua_pushinteger(L, (lua_Integer)PF_FULLSTASIS);
@@ -8061,36 +8181,18 @@ static inline int lib_getenum(lua_State *L)
 	}
 	else if (fastncmp("S_",word,2)) {
 		p = word+2;
-		for (i = 0; i < NUMSTATEFREESLOTS; i++) {
-			if (!FREE_STATES[i])
-				break;
-			if (fastcmp(p, FREE_STATES[i])) {
-				lua_pushinteger(L, S_FIRSTFREESLOT+i);
-				return 1;
-			}
+		if (DEH_FindConst(CONST_STATE, p, &i)) {
+			lua_pushinteger(L, i);
+			return 1;
 		}
-		for (i = 0; i < S_FIRSTFREESLOT; i++)
-			if (fastcmp(p, STATE_LIST[i]+2)) {
-				lua_pushinteger(L, i);
-				return 1;
-			}
 		return luaL_error(L, "state '%s' does not exist.\n", word);
 	}
 	else if (fastncmp("MT_",word,3)) {
 		p = word+3;
-		for (i = 0; i < NUMMOBJFREESLOTS; i++) {
-			if (!FREE_MOBJS[i])
-				break;
-			if (fastcmp(p, FREE_MOBJS[i])) {
-				lua_pushinteger(L, MT_FIRSTFREESLOT+i);
-				return 1;
-			}
+		if (DEH_FindConst(CONST_MOBJTYPE, p, &i)) {
+			lua_pushinteger(L, i);
+			return 1;
 		}
-		for (i = 0; i < MT_FIRSTFREESLOT; i++)
-			if (fastcmp(p, MOBJTYPE_LIST[i]+3)) {
-				lua_pushinteger(L, i);
-				return 1;
-			}
 		return luaL_error(L, "mobjtype '%s' does not exist.\n", word);
 	}
 	else if (fastncmp("SPR_",word,4)) {
@@ -8165,30 +8267,27 @@ static inline int lib_getenum(lua_State *L)
 	}
 	else if (mathlib && fastncmp("PW_",word,3)) { // SOCs are ALL CAPS!
 		p = word+3;
-		for (i = 0; i < NUMPOWERS; i++)
-			if (fastcmp(p, POWERS_LIST[i])) {
-				lua_pushinteger(L, i);
-				return 1;
-			}
+		if (DEH_FindConst(CONST_POWER, p, &i)) {
+			lua_pushinteger(L, i);
+			return 1;
+		}
 		return luaL_error(L, "power '%s' could not be found.\n", word);
 	}
 	else if (fastncmp("HUD_",word,4)) {
 		p = word+4;
-		for (i = 0; i < NUMHUDITEMS; i++)
-			if (fastcmp(p, HUDITEMS_LIST[i])) {
-				lua_pushinteger(L, i);
-				return 1;
-			}
+		if (DEH_FindConst(CONST_HUDITEM, p, &i)) {
+			lua_pushinteger(L, i);
+			return 1;
+		}
 		if (mathlib) return luaL_error(L, "huditem '%s' could not be found.\n", word);
 		return 0;
 	}
 	else if (fastncmp("SKINCOLOR_",word,10)) {
 		p = word+10;
-		for (i = 0; i < MAXTRANSLATIONS; i++)
-			if (fastcmp(p, COLOR_ENUMS[i])) {
-				lua_pushinteger(L, i);
-				return 1;
-			}
+		if (DEH_FindConst(CONST_SKINCOLOR, p, &i)) {
+			lua_pushinteger(L, i);
+			return 1;
+		}
 		if (mathlib) return luaL_error(L, "skincolor '%s' could not be found.\n", word);
 		return 0;
 	}
@@ -8234,11 +8333,10 @@ static inline int lib_getenum(lua_State *L)
 		return 0;
 	}
 
-	for (i = 0; INT_CONST[i].n; i++)
-		if (fastcmp(word,INT_CONST[i].n)) {
-			lua_pushinteger(L, INT_CONST[i].v);
-			return 1;
-		}
+	if (DEH_FindConst(CONST_INTEGER, word, &i)) {
+		lua_pushinteger(L, INT_CONST[i].v);
+		return 1;
+	}
 
 	if (mathlib) return luaL_error(L, "constant '%s' could not be parsed.\n", word);
 
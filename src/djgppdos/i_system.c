@@ -326,6 +326,15 @@ tic_t I_GetTime (void)
 	return ticcount;
 }
 
+/*==========================================================================*/
+// I_GetTimeMicros ()
+// only as precise as the timer interrupt
+/*==========================================================================*/
+UINT32 I_GetTimeMicros(void)
+{
+	return ticcount*(1000000/TICRATE);
+}
+
 
 void I_Sleep(void)
 {
@@ -203,6 +203,9 @@ typedef struct
 	INT16 z;
 	UINT8 extrainfo;
 	struct mobj_s *mobj;
+	// where mobj was when the level was loaded, for netgame saves (INT32 is fixed_t)
+	INT32 spawnz, spawnfloorz, spawnceilingz;
+	boolean spawnrecorded;
 } mapthing_t;
 
 #define ZSHIFT 4
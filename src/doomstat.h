@@ -115,6 +115,7 @@ extern boolean gamedataloaded;
 extern INT32 consoleplayer;
 extern INT32 displayplayer;
 extern INT32 secondarydisplayplayer; // for splitscreen
+extern boolean playerless; // in a netgame without a player, consoleplayer is only who we watch
 
 // Maps of special importance
 extern INT16 spstage_start;
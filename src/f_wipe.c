@@ -354,7 +354,8 @@ void F_RunWipe(UINT8 wipetype, boolean drawMenu)
 
 		// wait loop
 		while (!((nowtime = I_GetTime()) - lastwipetic))
-			I_Sleep();
+			if (!M_EncodeMovieFrame())
+				I_Sleep();
 		lastwipetic = nowtime;
 
 #ifdef HWRENDER
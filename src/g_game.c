@@ -45,6 +45,7 @@
 #include "b_bot.h"
 #include "m_cond.h" // condition sets
 #include "md5.h" // demo checksums
+#include "lzf.h" // demo keyframes
 
 gameaction_t gameaction;
 gamestate_t gamestate = GS_NULL;
@@ -68,6 +69,8 @@ static void G_DoCompleted(void);
 static void G_DoStartContinue(void);
 static void G_DoContinued(void);
 static void G_DoWorldDone(void);
+static void G_TakeDemoKeyframe(void);
+static void G_FreeDemoKeyframes(void);
 
 char   mapmusname[7]; // Music name
 UINT16 mapmusflags; // Track and reset bit
@@ -108,6 +111,7 @@ player_t players[MAXPLAYERS];
 INT32 consoleplayer; // player taking events and displaying
 INT32 displayplayer; // view being displayed
 INT32 secondarydisplayplayer; // for splitscreen
+boolean playerless; // watching a netgame, so consoleplayer isn't ours
 
 tic_t gametic;
 tic_t levelstarttic; // gametic at level start
@@ -238,8 +242,27 @@ static UINT8 demoflags;
 static UINT16 demoversion;
 boolean singledemo; // quit after playing a demo from cmdline
 boolean demo_start; // don't start playing demo right away
+tic_t demotic; // tics read from the demo so far, for seeking
 static boolean demosynced = true; // console warning message
 
+// Newer demos keep their tics in compressed chunks after the header, which
+// are read in one at a time as the demo plays.
+typedef struct
+{
+	char path[256]; // file the chunks are read from, or
+	const UINT8 *mem; // the whole demo, for WAD lumps
+	size_t memlen;
+	long chunk; // offset of the chunk in buf
+	long next; // offset of the chunk after it, -1 once there are no more
+	UINT8 *buf, *end; // the chunk, decompressed
+	size_t bufsize;
+	INT32 tag;
+} demostream_t;
+
+static demostream_t demostream; // for demoplayback
+static FILE *demofile = NULL; // for demorecording
+static UINT8 *demobody; // where tics start in demobuffer while recording
+
 boolean metalrecording; // recording as metal sonic
 mobj_t *metalplayback;
 static UINT8 *metalbuffer = NULL;
@@ -267,6 +290,7 @@ typedef struct demoghost {
 	UINT8 checksum[16];
 	UINT8 *buffer, *p, color;
 	UINT16 version;
+	demostream_t stream;
 	mobj_t oldmo, *mo;
 	struct demoghost *next;
 } demoghost;
@@ -352,6 +376,10 @@ static CV_PossibleValue_t joyaxis_cons_t[] = {{0, "None"},
 // it automatically becomes compact with 20+ players, but if you like it, I guess you can turn that on!
 consvar_t cv_compactscoreboard= {"compactscoreboard", "Off", CV_SAVE, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
 
+// seconds of demo between keyframes for demoseek/demorewind; 0 turns them off
+static CV_PossibleValue_t demokeyframes_cons_t[] = {{0, "MIN"}, {600, "MAX"}, {0, NULL}};
+consvar_t cv_demokeyframes = {"demokeyframes", "10", CV_SAVE, demokeyframes_cons_t, NULL, 0, NULL, NULL, 0, 0, NULL};
+
 // chat timer thingy
 static CV_PossibleValue_t chattime_cons_t[] = {{5, "MIN"}, {999, "MAX"}, {0, NULL}};
 consvar_t cv_chattime = {"chattime", "8", CV_SAVE, chattime_cons_t, NULL, 0, NULL, NULL, 0, 0, NULL};
@@ -1024,6 +1052,10 @@ void G_BuildTiccmd(ticcmd_t *cmd, INT32 realtics)
 
 	G_CopyTiccmd(cmd, I_BaseTiccmd(), 1); // empty, or external driver
 
+	// watchers have no player to steer
+	if (playerless)
+		return;
+
 	// why build a ticcmd if we're paused?
 	// Or, for that matter, if we're being reborn.
 	if (paused || P_AutoPause() || (gamestate == GS_LEVEL && player->playerstate == PST_REBORN))
@@ -1962,6 +1994,11 @@ void G_Ticker(boolean run)
 	UINT32 i;
 	INT32 buf;
 
+	// Keyframes are taken before anything else happens this tic,
+	// so that restoring one picks up exactly where it left off.
+	if (demoplayback)
+		G_TakeDemoKeyframe();
+
 	P_MapStart();
 	// do player reborns if needed
 	if (gamestate == GS_LEVEL)
@@ -3777,7 +3814,8 @@ char *G_BuildMapTitle(INT32 mapnum)
 // DEMO RECORDING
 //
 
-#define DEMOVERSION 0x0009
+#define DEMOVERSION 0x000a
+#define DEMOVERSION_CHUNKED 0x000a // first version with compressed tics
 #define DEMOHEADER  "\xF0" "SRB2Replay" "\x0F"
 
 #define DF_GHOST        0x01 // This demo contains ghost data too!
@@ -3819,6 +3857,196 @@ static ticcmd_t oldcmd;
 
 static mobj_t oldmetal, oldghost;
 
+// From DEMOVERSION_CHUNKED on, everything after the header is a series of
+// chunks, each a UINT32 raw length, a UINT32 packed length (0 if the chunk
+// is stored as is) and the data. Chunks only ever hold whole tics, and one
+// with a raw length of 0 ends the file.
+#define DEMOCHUNKSIZE (32*1024) // tics built up before they're written out
+#define DEMOHEADSIZE (64*1024) // most a demo header could need
+#define DEMOBUFSIZE (DEMOHEADSIZE + 2*DEMOCHUNKSIZE)
+
+//
+// G_ReadDemoHead
+// Reads a demo file into memory. Chunked demos are streamed in as they're
+// played, so only as much as the header could need is read for those.
+//
+static size_t G_ReadDemoHead(const char *name, UINT8 **buffer, INT32 tag)
+{
+	FILE *handle = fopen(name, "rb");
+	UINT8 head[16];
+	size_t count, length;
+	UINT8 *buf;
+
+	if (!handle)
+		return 0;
+
+	fseek(handle, 0, SEEK_END);
+	length = ftell(handle);
+	fseek(handle, 0, SEEK_SET);
+
+	if (length > DEMOHEADSIZE && fread(head, 1, 16, handle) == 16
+	&& !memcmp(head, DEMOHEADER, 12) && (head[14] | head[15]<<8) >= DEMOVERSION_CHUNKED)
+		length = DEMOHEADSIZE;
+	fseek(handle, 0, SEEK_SET);
+
+	buf = Z_Malloc(length + 1, tag, NULL);
+	count = fread(buf, 1, length, handle);
+	fclose(handle);
+
+	if (count < length)
+	{
+		Z_Free(buf);
+		return 0;
+	}
+
+	buf[length] = 0;
+	*buffer = buf;
+	return length;
+}
+
+static boolean G_ReadDemoBytes(const demostream_t *s, FILE *handle, long offset, void *dest, size_t length)
+{
+	if (s->mem)
+	{
+		if (offset < 0 || (size_t)offset + length > s->memlen)
+			return false;
+		M_Memcpy(dest, s->mem + offset, length);
+		return true;
+	}
+	return handle && !fseek(handle, offset, SEEK_SET) && fread(dest, 1, length, handle) == length;
+}
+
+//
+// G_ReadDemoChunk
+// Loads the chunk at the given offset. If anything is wrong with it, or
+// there isn't one, the demo simply ends there.
+//
+static void G_ReadDemoChunk(demostream_t *s, long offset)
+{
+	UINT8 head[8], *p = head, *packed;
+	UINT32 rawlen = 0, packedlen = 0;
+	FILE *handle = NULL;
+
+	s->chunk = offset;
+	s->next = -1;
+
+	if (!s->mem)
+		handle = fopen(s->path, "rb");
+
+	if (G_ReadDemoBytes(s, handle, offset, head, 8))
+	{
+		rawlen = READUINT32(p);
+		packedlen = READUINT32(p);
+		if (rawlen > DEMOBUFSIZE || packedlen >= rawlen)
+			rawlen = 0;
+	}
+
+	if (rawlen)
+	{
+		if (rawlen > s->bufsize)
+		{
+			s->buf = Z_Realloc(s->buf, rawlen, s->tag, NULL);
+			s->bufsize = rawlen;
+		}
+
+		if (!packedlen)
+		{
+			if (!G_ReadDemoBytes(s, handle, offset + 8, s->buf, rawlen))
+				rawlen = 0;
+			packedlen = rawlen;
+		}
+		else
+		{
+			packed = Z_Malloc(packedlen, PU_STATIC, NULL);
+			if (!G_ReadDemoBytes(s, handle, offset + 8, packed, packedlen)
+			|| lzf_decompress(packed, packedlen, s->buf, rawlen) != rawlen)
+				rawlen = 0;
+			Z_Free(packed);
+		}
+
+		if (rawlen)
+			s->next = offset + 8 + packedlen;
+	}
+
+	if (handle)
+		fclose(handle);
+
+	if (!rawlen)
+	{
+		if (!s->bufsize)
+		{
+			s->buf = Z_Realloc(s->buf, 1, s->tag, NULL);
+			s->bufsize = 1;
+		}
+		s->buf[0] = DEMOMARKER;
+		rawlen = 1;
+	}
+	s->end = s->buf + rawlen;
+}
+
+// Starts reading chunks at offset, from the file at path or from mem.
+static void G_OpenDemoStream(demostream_t *s, const char *path, const UINT8 *mem, size_t memlen, long offset, INT32 tag)
+{
+	memset(s, 0, sizeof (*s));
+	if (path)
+		strlcpy(s->path, path, sizeof (s->path));
+	s->mem = mem;
+	s->memlen = memlen;
+	s->tag = tag;
+	G_ReadDemoChunk(s, offset);
+}
+
+static void G_CloseDemoStream(demostream_t *s)
+{
+	Z_Free(s->buf);
+	memset(s, 0, sizeof (*s));
+}
+
+// Moves p on to the next chunk once it's read everything in this one.
+static UINT8 *G_FillDemoStream(demostream_t *s, UINT8 *p)
+{
+	if (!s->buf || p < s->end || s->next < 0)
+		return p;
+	G_ReadDemoChunk(s, s->next);
+	return s->buf;
+}
+
+static const char *G_DemoTempName(void)
+{
+	return va("%s"PATHSEP"%s.tmp", srb2home, demoname);
+}
+
+//
+// G_FlushDemoChunk
+// Compresses the tics written since the last flush and adds them to the
+// file being recorded.
+//
+static void G_FlushDemoChunk(void)
+{
+	UINT8 head[8], *p = head;
+	UINT8 *packed;
+	size_t rawlen, packedlen = 0;
+
+	if (!demofile || demo_p <= demobody)
+		return;
+
+	rawlen = demo_p - demobody;
+	packed = malloc(rawlen);
+	if (packed)
+		packedlen = lzf_compress(demobody, rawlen, packed, rawlen - 1);
+
+	WRITEUINT32(p, rawlen);
+	WRITEUINT32(p, packedlen);
+	fwrite(head, 1, 8, demofile);
+	if (packedlen)
+		fwrite(packed, 1, packedlen, demofile);
+	else
+		fwrite(demobody, 1, rawlen, demofile);
+	free(packed);
+
+	demo_p = demobody;
+}
+
 void G_SaveMetal(UINT8 **buffer)
 {
 	I_Assert(buffer != NULL && *buffer != NULL);
@@ -3860,7 +4088,9 @@ void G_ReadDemoTiccmd(ticcmd_t *cmd, INT32 playernum)
 
 	if (!demo_p || !demo_start)
 		return;
+	demo_p = G_FillDemoStream(&demostream, demo_p);
 	ziptic = READUINT8(demo_p);
+	demotic++;
 
 	if (ziptic & ZT_FWD)
 		oldcmd.forwardmove = READSINT8(demo_p);
@@ -3875,6 +4105,8 @@ void G_ReadDemoTiccmd(ticcmd_t *cmd, INT32 playernum)
 
 	G_CopyTiccmd(cmd, &oldcmd, 1);
 
+	if (!(demoflags & DF_GHOST))
+		demo_p = G_FillDemoStream(&demostream, demo_p);
 	if (!(demoflags & DF_GHOST) && *demo_p == DEMOMARKER)
 	{
 		// end of demo data stream
@@ -3930,9 +4162,12 @@ void G_WriteDemoTiccmd(ticcmd_t *cmd, INT32 playernum)
 
 	*ziptic_p = ziptic;
 
+	if (!(demoflags & DF_GHOST) && demo_p - demobody >= DEMOCHUNKSIZE)
+		G_FlushDemoChunk();
+
 	// attention here for the ticcmd size!
 	// latest demos with mouse aiming byte in ticcmd
-	if (!(demoflags & DF_GHOST) && ziptic_p > demoend - 9)
+	if (!(demoflags & DF_GHOST) && demo_p > demoend - 9)
 	{
 		G_CheckDemoStatus(); // no more space
 		return;
@@ -4145,6 +4380,10 @@ void G_WriteGhostTic(mobj_t *ghost)
 
 	*ziptic_p = ziptic;
 
+	// Only whole tics go out, so every chunk can be read on its own.
+	if (demo_p - demobody >= DEMOCHUNKSIZE)
+		G_FlushDemoChunk();
+
 	// attention here for the ticcmd size!
 	// latest demos with mouse aiming byte in ticcmd
 	if (demo_p >= demoend - (13 + 9))
@@ -4275,6 +4514,7 @@ void G_ConsGhostTic(void)
 		testmo->z = oldghost.z;
 	}
 
+	demo_p = G_FillDemoStream(&demostream, demo_p);
 	if (*demo_p == DEMOMARKER)
 	{
 		// end of demo data stream
@@ -4288,8 +4528,11 @@ void G_GhostTicker(void)
 	demoghost *g,*p;
 	for(g = ghosts, p = NULL; g; g = g->next)
 	{
+		UINT8 ziptic;
+
 		// Skip normal demo data.
-		UINT8 ziptic = READUINT8(g->p);
+		g->p = G_FillDemoStream(&g->stream, g->p);
+		ziptic = READUINT8(g->p);
 		if (ziptic & ZT_FWD)
 			g->p++;
 		if (ziptic & ZT_SIDE)
@@ -4459,6 +4702,7 @@ void G_GhostTicker(void)
 		}
 
 		// Demo ends after ghost data.
+		g->p = G_FillDemoStream(&g->stream, g->p);
 		if (*g->p == DEMOMARKER)
 		{
 			g->mo->momx = g->mo->momy = g->mo->momz = 0;
@@ -4466,6 +4710,7 @@ void G_GhostTicker(void)
 				p->next = g->next;
 			else
 				ghosts = g->next;
+			G_CloseDemoStream(&g->stream);
 			Z_Free(g);
 			continue;
 		}
@@ -4685,18 +4930,14 @@ void G_WriteMetalTic(mobj_t *metal)
 //
 void G_RecordDemo(const char *name)
 {
-	INT32 maxsize;
-
 	strcpy(demoname, name);
 	strcat(demoname, ".lmp");
-	maxsize = 1024*1024;
-	if (M_CheckParm("-maxdemo") && M_IsNextParm())
-		maxsize = atoi(M_GetNextParm()) * 1024;
 //	if (demobuffer)
 //		free(demobuffer);
 	demo_p = NULL;
-	demobuffer = malloc(maxsize);
-	demoend = demobuffer + maxsize;
+	// Only the header and the tics not yet written out are kept in memory.
+	demobuffer = malloc(DEMOBUFSIZE);
+	demoend = demobuffer + DEMOBUFSIZE;
 
 	demorecording = true;
 }
@@ -4822,6 +5063,23 @@ void G_BeginRecording(void)
 		if (player->mo->eflags & MFE_VERTICALFLIP)
 			ghostext.flags |= EZT_FLIP;
 	}
+
+	// The header stays in memory so the time and checksum can be filled in
+	// at the end; the tics go out to disk a chunk at a time. They're kept in
+	// a temporary file until then, since a ghost may be playing back from
+	// the file this will replace.
+	demobody = demo_p;
+	demofile = fopen(G_DemoTempName(), "w+b");
+	if (!demofile)
+	{
+		CONS_Alert(CONS_WARNING, M_GetText("Couldn't open %s for recording\n"), G_DemoTempName());
+		free(demobuffer);
+		demobuffer = NULL;
+		demo_p = NULL;
+		demorecording = false;
+		return;
+	}
+	fwrite(demobuffer, 1, demobody - demobuffer, demofile);
 }
 
 void G_BeginMetal(void)
@@ -4888,7 +5146,7 @@ UINT8 G_CmpDemoTime(char *oldname, char *newname)
 
 	// load the new file
 	FIL_DefaultExtension(newname, ".lmp");
-	bufsize = FIL_ReadFile(newname, &buffer);
+	bufsize = G_ReadDemoHead(newname, &buffer, PU_STATIC);
 	I_Assert(bufsize != 0);
 	p = buffer;
 
@@ -4929,7 +5187,7 @@ UINT8 G_CmpDemoTime(char *oldname, char *newname)
 
 	// load old file
 	FIL_DefaultExtension(oldname, ".lmp");
-	if (!FIL_ReadFile(oldname, &buffer))
+	if (!G_ReadDemoHead(oldname, &buffer, PU_STATIC))
 	{
 		CONS_Alert(CONS_ERROR, M_GetText("Failed to read file '%s'.\n"), oldname);
 		return UINT8_MAX;
@@ -4950,6 +5208,7 @@ UINT8 G_CmpDemoTime(char *oldname, char *newname)
 	{
 	case DEMOVERSION: // latest always supported
 	// compatibility available?
+	case 0x0009: // tics not chunked
 	case 0x0008:
 		break;
 	// too old, cannot support.
@@ -5029,6 +5288,7 @@ void G_DoPlayDemo(char *defdemoname)
 	UINT32 randseed;
 	fixed_t actionspd,mindash,maxdash,normalspeed,runspeed,jumpfactor;
 	char msg[1024];
+	size_t lumplength = 0;
 
 	skin[16] = '\0';
 	color[16] = '\0';
@@ -5045,7 +5305,7 @@ void G_DoPlayDemo(char *defdemoname)
 	if (FIL_CheckExtension(defdemoname))
 	{
 		//FIL_DefaultExtension(defdemoname, ".lmp");
-		if (!FIL_ReadFile(defdemoname, &demobuffer))
+		if (!G_ReadDemoHead(defdemoname, &demobuffer, PU_STATIC))
 		{
 			snprintf(msg, 1024, M_GetText("Failed to read file '%s'.\n"), defdemoname);
 			CONS_Alert(CONS_ERROR, "%s", msg);
@@ -5065,7 +5325,10 @@ void G_DoPlayDemo(char *defdemoname)
 		return;
 	}
 	else // it's an internal demo
+	{
 		demobuffer = demo_p = W_CacheLumpNum(l, PU_STATIC);
+		lumplength = W_LumpLength(l);
+	}
 
 	// read demo header
 	gameaction = ga_nothing;
@@ -5090,6 +5353,7 @@ void G_DoPlayDemo(char *defdemoname)
 	{
 	case DEMOVERSION: // latest always supported
 	// compatibility available?
+	case 0x0009: // tics not chunked
 	case 0x0008:
 		break;
 	// too old, cannot support.
@@ -5178,6 +5442,17 @@ void G_DoPlayDemo(char *defdemoname)
 	// net var data
 	CV_LoadNetVars(&demo_p);
 
+	// The rest is read as it's played.
+	G_CloseDemoStream(&demostream);
+	if (demoversion >= DEMOVERSION_CHUNKED)
+	{
+		if (lumplength)
+			G_OpenDemoStream(&demostream, NULL, demobuffer, lumplength, demo_p - demobuffer, PU_STATIC);
+		else
+			G_OpenDemoStream(&demostream, defdemoname, NULL, 0, demo_p - demobuffer, PU_STATIC);
+		demo_p = demostream.buf;
+	}
+
 	// Sigh ... it's an empty demo.
 	if (*demo_p == DEMOMARKER)
 	{
@@ -5185,6 +5460,7 @@ void G_DoPlayDemo(char *defdemoname)
 		CONS_Alert(CONS_ERROR, "%s", msg);
 		M_StartMessage(msg, NULL, MM_NOTHING);
 		Z_Free(pdemoname);
+		G_CloseDemoStream(&demostream);
 		Z_Free(demobuffer);
 		demoplayback = false;
 		titledemo = false;
@@ -5204,6 +5480,8 @@ void G_DoPlayDemo(char *defdemoname)
 
 	// didn't start recording right away.
 	demo_start = false;
+	demotic = 0;
+	G_FreeDemoKeyframes();
 
 #ifdef HAVE_BLUA
 	LUAh_MapChange(gamemap);
@@ -5261,6 +5539,8 @@ void G_AddGhost(char *defdemoname)
 	UINT8 *buffer,*p;
 	mapthing_t *mthing;
 	UINT16 count, ghostversion;
+	size_t lumplength = 0;
+	demostream_t stream;
 
 	name[16] = '\0';
 	skin[16] = '\0';
@@ -5278,7 +5558,7 @@ void G_AddGhost(char *defdemoname)
 	if (FIL_CheckExtension(defdemoname))
 	{
 		//FIL_DefaultExtension(defdemoname, ".lmp");
-		if (!FIL_ReadFileTag(defdemoname, &buffer, PU_LEVEL))
+		if (!G_ReadDemoHead(defdemoname, &buffer, PU_LEVEL))
 		{
 			CONS_Alert(CONS_ERROR, M_GetText("Failed to read file '%s'.\n"), defdemoname);
 			Z_Free(pdemoname);
@@ -5294,7 +5574,10 @@ void G_AddGhost(char *defdemoname)
 		return;
 	}
 	else // it's an internal demo
+	{
 		buffer = p = W_CacheLumpNum(l, PU_LEVEL);
+		lumplength = W_LumpLength(l);
+	}
 
 	// read demo header
 	if (memcmp(p, DEMOHEADER, 12))
@@ -5311,6 +5594,7 @@ void G_AddGhost(char *defdemoname)
 	{
 	case DEMOVERSION: // latest always supported
 	// compatibility available?
+	case 0x0009: // tics not chunked
 	case 0x0008:
 		break;
 	// too old, cannot support.
@@ -5399,10 +5683,26 @@ void G_AddGhost(char *defdemoname)
 		p++;
 	}
 
+	// Only a chunk of the ghost's tics is held at a time.
+	memset(&stream, 0, sizeof (stream));
+	if (ghostversion >= DEMOVERSION_CHUNKED)
+	{
+		if (lumplength)
+			G_OpenDemoStream(&stream, NULL, buffer, lumplength, p - buffer, PU_LEVEL);
+		else
+		{
+			G_OpenDemoStream(&stream, defdemoname, NULL, 0, p - buffer, PU_LEVEL);
+			Z_Free(buffer);
+			buffer = NULL;
+		}
+		p = stream.buf;
+	}
+
 	if (*p == DEMOMARKER)
 	{
 		CONS_Alert(CONS_NOTICE, M_GetText("Failed to add ghost %s: Replay is empty.\n"), pdemoname);
 		Z_Free(pdemoname);
+		G_CloseDemoStream(&stream);
 		Z_Free(buffer);
 		return;
 	}
@@ -5410,6 +5710,7 @@ void G_AddGhost(char *defdemoname)
 	gh = Z_Calloc(sizeof(demoghost), PU_LEVEL, NULL);
 	gh->next = ghosts;
 	gh->buffer = buffer;
+	gh->stream = stream;
 	M_Memcpy(gh->checksum, md5, 16);
 	gh->p = p;
 
@@ -5536,6 +5837,7 @@ void G_DoPlayMetal(void)
 	{
 	case DEMOVERSION: // latest always supported
 	// compatibility available?
+	case 0x0009: // tics not chunked
 	case 0x0008:
 		break;
 	// too old, cannot support.
@@ -5618,6 +5920,8 @@ ATTRNORETURN void FUNCNORETURN G_StopMetalRecording(void)
 // called from stopdemo command, map command, and g_checkdemoStatus.
 void G_StopDemo(void)
 {
+	G_FreeDemoKeyframes();
+	G_CloseDemoStream(&demostream);
 	Z_Free(demobuffer);
 	demobuffer = NULL;
 	demoplayback = false;
@@ -5634,6 +5938,217 @@ void G_StopDemo(void)
 	SV_ResetServer();
 }
 
+// ========================================================================
+//                          DEMO KEYFRAMES
+// ========================================================================
+
+// While a demo plays back, the game state is archived every cv_demokeyframes
+// seconds using the same code that sends the game to joining players.
+// Seeking restores the last keyframe before the wanted tic and runs the game
+// forward from there without drawing anything.
+
+#define DEMOKEYFRAMESIZE (768*1024)
+
+typedef struct
+{
+	tic_t tic; // demotic when it was taken
+	long chunk; // demostream.chunk, or -1 if the demo isn't chunked
+	size_t demopos; // demo_p's offset into the chunk or demobuffer
+	ticcmd_t cmd; // oldcmd
+	mobj_t ghost; // oldghost
+	boolean synced;
+	UINT8 *save; // P_SaveNetGame output
+	size_t savelength;
+	size_t rawlength; // uncompressed length if save is lzf compressed, else 0
+} demokeyframe_t;
+
+static demokeyframe_t *demokeyframes = NULL;
+static size_t numdemokeyframes = 0, maxdemokeyframes = 0;
+
+static void G_FreeDemoKeyframes(void)
+{
+	size_t i;
+	for (i = 0; i < numdemokeyframes; i++)
+		Z_Free(demokeyframes[i].save);
+	Z_Free(demokeyframes);
+	demokeyframes = NULL;
+	numdemokeyframes = maxdemokeyframes = 0;
+}
+
+//
+// G_TakeDemoKeyframe
+// Called at the start of every G_Ticker while a demo is playing back.
+//
+static void G_TakeDemoKeyframe(void)
+{
+	demokeyframe_t *key;
+	UINT8 *keybuf, *compressed;
+	size_t length, compressedlen;
+
+	if (!cv_demokeyframes.value || titledemo || timingdemo || ghosts)
+		return;
+	if (!demo_start || !demo_p || gamestate != GS_LEVEL || gameaction != ga_nothing)
+		return;
+	if (demotic % (cv_demokeyframes.value*TICRATE))
+		return;
+	// Already have this one (paused, or playing through a stretch we rewound over)
+	if (numdemokeyframes && demokeyframes[numdemokeyframes-1].tic >= demotic)
+		return;
+
+	keybuf = Z_Malloc(DEMOKEYFRAMESIZE, PU_STATIC, NULL);
+	save_p = keybuf;
+	P_SaveNetGame();
+	length = save_p - keybuf;
+	save_p = NULL;
+	if (length > DEMOKEYFRAMESIZE)
+		I_Error("Demo keyframe buffer overrun");
+
+	if (numdemokeyframes == maxdemokeyframes)
+	{
+		maxdemokeyframes = maxdemokeyframes ? maxdemokeyframes*2 : 32;
+		demokeyframes = Z_Realloc(demokeyframes, maxdemokeyframes*sizeof(*demokeyframes), PU_STATIC, NULL);
+	}
+	key = &demokeyframes[numdemokeyframes++];
+
+	key->tic = demotic;
+	if (demostream.buf)
+	{
+		key->chunk = demostream.chunk;
+		key->demopos = demo_p - demostream.buf;
+	}
+	else
+	{
+		key->chunk = -1;
+		key->demopos = demo_p - demobuffer;
+	}
+	key->cmd = oldcmd;
+	key->ghost = oldghost;
+	key->synced = demosynced;
+
+	// Most of a keyframe is zeroes and unchanged map data, so it's
+	// well worth compressing; they add up over a long demo.
+	compressed = Z_Malloc(length - 1, PU_STATIC, NULL);
+	if ((compressedlen = lzf_compress(keybuf, length, compressed, length - 1)) != 0)
+	{
+		Z_Free(keybuf);
+		key->save = Z_Realloc(compressed, compressedlen, PU_STATIC, NULL);
+		key->savelength = compressedlen;
+		key->rawlength = length;
+	}
+	else
+	{
+		Z_Free(compressed);
+		key->save = Z_Realloc(keybuf, length, PU_STATIC, NULL);
+		key->savelength = length;
+		key->rawlength = 0;
+	}
+}
+
+static boolean G_RestoreDemoKeyframe(const demokeyframe_t *key)
+{
+	UINT8 *keybuf = key->save;
+	boolean loaded;
+
+	if (key->rawlength)
+	{
+		keybuf = Z_Malloc(key->rawlength, PU_STATIC, NULL);
+		lzf_decompress(key->save, key->savelength, keybuf, key->rawlength);
+	}
+
+	save_p = keybuf;
+	loaded = P_LoadNetGame();
+	save_p = NULL;
+
+	if (key->rawlength)
+		Z_Free(keybuf);
+
+	if (!loaded)
+		return false;
+
+	if (key->chunk >= 0)
+	{
+		G_ReadDemoChunk(&demostream, key->chunk);
+		demo_p = demostream.buf + key->demopos;
+	}
+	else
+		demo_p = demobuffer + key->demopos;
+	oldcmd = key->cmd;
+	oldghost = key->ghost;
+	demosynced = key->synced;
+	demotic = key->tic;
+	return true;
+}
+
+//
+// G_SeekDemo
+// Jumps to the given tic of the demo being played back.
+// Returns false if it can't get there.
+//
+boolean G_SeekDemo(tic_t tic)
+{
+	const demokeyframe_t *key = NULL;
+	boolean waspaused = paused, wasdisabled = sound_disabled;
+	size_t i;
+
+	if (!demoplayback || titledemo || timingdemo || !demo_start || gamestate != GS_LEVEL)
+	{
+		CONS_Printf(M_GetText("You must be watching a demo to do this.\n"));
+		return false;
+	}
+
+	if (ghosts)
+	{
+		CONS_Printf(M_GetText("You can't seek through a demo while ghosts are racing.\n"));
+		return false;
+	}
+
+	for (i = numdemokeyframes; i > 0; i--)
+		if (demokeyframes[i-1].tic <= tic)
+		{
+			key = &demokeyframes[i-1];
+			break;
+		}
+
+	// Going backwards needs a keyframe; going forwards only uses one
+	// if it saves us some tics.
+	if (tic < demotic && !key)
+	{
+		CONS_Printf(M_GetText("There's no keyframe to rewind to. Check demokeyframes.\n"));
+		return false;
+	}
+
+	if (key && (tic < demotic || key->tic > demotic))
+	{
+		if (!G_RestoreDemoKeyframe(key))
+		{
+			CONS_Alert(CONS_ERROR, M_GetText("Failed to restore demo keyframe.\n"));
+			G_CheckDemoStatus();
+			return false;
+		}
+	}
+
+	// Run the rest of the way with no rendering and no sound.
+	paused = false;
+	sound_disabled = true;
+	while (demoplayback && gamestate == GS_LEVEL && demotic < tic)
+	{
+		const tic_t lasttic = demotic;
+		G_Ticker(true);
+		if (demotic == lasttic)
+			break; // autopaused, we're not going to get anywhere
+	}
+	sound_disabled = wasdisabled;
+
+	if (!demoplayback)
+		return false;
+
+	paused = waspaused;
+	S_StopSounds();
+	if (camera.chase)
+		P_ResetCamera(&players[displayplayer], &camera);
+	return true;
+}
+
 boolean G_CheckDemoStatus(void)
 {
 	boolean saved;
@@ -5641,6 +6156,7 @@ boolean G_CheckDemoStatus(void)
 	while (ghosts)
 	{
 		demoghost *next = ghosts->next;
+		G_CloseDemoStream(&ghosts->stream);
 		Z_Free(ghosts);
 		ghosts = next;
 	}
@@ -5684,16 +6200,41 @@ boolean G_CheckDemoStatus(void)
 	if (demorecording)
 	{
 		UINT8 *p = demobuffer+16; // checksum position
+		const UINT8 endchunk[8] = {0};
+		char tempname[256];
 #ifdef NOMD5
 		UINT8 i;
+#endif
 		WRITEUINT8(demo_p, DEMOMARKER); // add the demo end marker
+		G_FlushDemoChunk();
+		fwrite(endchunk, 1, 8, demofile);
+
+		// Now that the time is known, write the header again.
+		fseek(demofile, 0, SEEK_SET);
+		fwrite(demobuffer, 1, demobody - demobuffer, demofile);
+#ifdef NOMD5
 		for (i = 0; i < 16; i++, p++)
 			*p = P_RandomByte(); // This MD5 was chosen by fair dice roll and most likely < 50% correct.
+		p = demobuffer+16;
 #else
-		WRITEUINT8(demo_p, DEMOMARKER); // add the demo end marker
-		md5_buffer((char *)p+16, demo_p - (p+16), p); // make a checksum of everything after the checksum in the file.
+		fflush(demofile);
+		fseek(demofile, 32, SEEK_SET);
+		md5_stream(demofile, p); // make a checksum of everything after the checksum in the file.
 #endif
-		saved = FIL_WriteFile(va(pandf, srb2home, demoname), demobuffer, demo_p - demobuffer); // finally output the file.
+		fseek(demofile, 16, SEEK_SET);
+		fwrite(p, 1, 16, demofile);
+		saved = !ferror(demofile);
+		if (fclose(demofile))
+			saved = false;
+		demofile = NULL;
+
+		// finally put the file in place.
+		strlcpy(tempname, G_DemoTempName(), sizeof tempname);
+		if (saved)
+		{
+			remove(va(pandf, srb2home, demoname));
+			saved = !rename(tempname, va(pandf, srb2home, demoname));
+		}
 		free(demobuffer);
 		demorecording = false;
 
@@ -0,0 +1,390 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 1999-2018 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  hw_batching.c
+/// \brief Polygon batching for the hardware renderer
+///
+///	The BSP walk hands polygons over one at a time, each with its own texture
+///	bind, blend mode and surface colour. Opaque polygons do not care about the
+///	order they are drawn in, so they are recorded, sorted by state, and sent
+///	to the driver as indexed triangle lists: one draw call per run of polygons
+///	that share a texture, polyflags and colour. Everything else (translucency,
+///	decals, coronas...) is replayed afterwards in submission order.
+
+#include "../doomdef.h"
+
+#ifdef HWRENDER
+#include "hw_glob.h"
+#include "hw_drv.h"
+#include "hw_main.h"
+#include "hw_batching.h"
+
+#include "../z_zone.h"
+#include "../console.h"
+
+// Flags that make a polygon depend on what was drawn before it
+#define PF_UNBATCHABLE (PF_Corona|PF_NoDepthTest|PF_Decal|PF_MD2|PF_RemoveYWrap|PF_ForceWrapX|PF_ForceWrapY)
+
+typedef struct
+{
+	FSurfaceInfo surf;
+	boolean hassurf;
+	GLMipmap_t *texture;
+	FBITFIELD polyflags;
+	INT32 fogdensity;
+	INT32 fogcolor;
+	UINT32 firstvert;
+	UINT32 numverts;
+} batchpoly_t;
+
+typedef struct
+{
+	UINT32 polygons;
+	UINT32 vertices;
+	UINT32 drawcalls;
+	UINT32 texturechanges;
+	UINT32 polyflagchanges;
+	UINT32 colorchanges;
+} batchstats_t;
+
+static boolean batching = false; // recording polygons
+static boolean counting = false; // between HWR_StartBatching and HWR_RenderBatches
+
+static batchpoly_t *polys = NULL;
+static UINT32 numpolys = 0, maxpolys = 0;
+
+static FOutVector *verts = NULL;
+static UINT32 numverts = 0, maxverts = 0;
+
+static UINT32 *sortindex = NULL;
+static UINT32 maxsortindex = 0;
+
+// One merged batch: its vertices copied contiguously, and the triangle list
+static FOutVector *batchverts = NULL;
+static UINT32 maxbatchverts = 0;
+static UINT32 *batchindices = NULL;
+static UINT32 maxbatchindices = 0;
+
+// State as the rest of the renderer last set it
+static GLMipmap_t *currenttexture = NULL;
+static INT32 currentfogdensity = 0, currentfogcolor = 0;
+
+static batchstats_t batchstats;
+
+// Grows a batch array to hold at least 'needed' elements
+static void *HWR_GrowArray(void *ptr, UINT32 *max, UINT32 needed, size_t elemsize)
+{
+	UINT32 newmax = *max ? *max : 256;
+
+	if (needed <= *max)
+		return ptr;
+
+	while (newmax < needed)
+		newmax <<= 1;
+
+	*max = newmax;
+	return Z_Realloc(ptr, newmax * elemsize, PU_STATIC, NULL);
+}
+
+/**	\brief Starts recording polygons instead of drawing them
+*/
+void HWR_StartBatching(void)
+{
+	if (batching)
+		HWR_RenderBatches();
+
+	memset(&batchstats, 0, sizeof (batchstats));
+	counting = true;
+
+	// The NDS driver, or an old DLL, may not have indexed drawing
+	if (!cv_grbatching.value || !HWD.pfnDrawIndexedTriangles)
+		return;
+
+	batching = true;
+	numpolys = numverts = 0;
+}
+
+/**	\brief Sets the texture used by the next polygons
+	Textures that were never uploaded are handed to the driver right away, so
+	that their data is still around; binding them is deferred while batching.
+
+	\param	texture	mipmap to bind, or NULL for no texture
+*/
+void HWR_SetCurrentTexture(GLMipmap_t *texture)
+{
+	currenttexture = texture;
+
+	if (!batching || (texture && !texture->downloaded))
+		HWD.pfnSetTexture(texture);
+}
+
+/**	\brief Sets a driver state, keeping track of the per-polygon fog parameters
+*/
+void HWR_SetSpecialState(hwdspecialstate_t IStateType, INT32 Value)
+{
+	if (IStateType == HWD_SET_FOG_DENSITY)
+		currentfogdensity = Value;
+	else if (IStateType == HWD_SET_FOG_COLOR)
+		currentfogcolor = Value;
+	else
+	{
+		HWD.pfnSetSpecialState(IStateType, Value);
+		return;
+	}
+
+	if (!batching)
+		HWD.pfnSetSpecialState(IStateType, Value);
+}
+
+/**	\brief Draws a polygon, or records it for HWR_RenderBatches
+*/
+void HWR_ProcessPolygon(FSurfaceInfo *pSurf, FOutVector *pOutVerts, FUINT iNumPts, FBITFIELD PolyFlags)
+{
+	batchpoly_t *poly;
+
+	if (!batching)
+	{
+		HWD.pfnDrawPolygon(pSurf, pOutVerts, iNumPts, PolyFlags);
+		if (counting)
+		{
+			batchstats.polygons++;
+			batchstats.vertices += iNumPts;
+			batchstats.drawcalls++;
+		}
+		return;
+	}
+
+	if (iNumPts < 3)
+		return;
+
+	polys = HWR_GrowArray(polys, &maxpolys, numpolys + 1, sizeof (*polys));
+	verts = HWR_GrowArray(verts, &maxverts, numverts + iNumPts, sizeof (*verts));
+
+	poly = &polys[numpolys++];
+	poly->hassurf = (pSurf != NULL);
+	if (pSurf)
+		poly->surf = *pSurf;
+	poly->texture = currenttexture;
+	poly->polyflags = PolyFlags;
+	poly->fogdensity = currentfogdensity;
+	poly->fogcolor = currentfogcolor;
+	poly->firstvert = numverts;
+	poly->numverts = iNumPts;
+
+	M_Memcpy(&verts[numverts], pOutVerts, iNumPts * sizeof (*verts));
+	numverts += iNumPts;
+
+	batchstats.polygons++;
+	batchstats.vertices += iNumPts;
+}
+
+static boolean HWR_IsBatchable(const batchpoly_t *poly)
+{
+	FBITFIELD blend = poly->polyflags & PF_Blending;
+
+	if (poly->polyflags & PF_UNBATCHABLE)
+		return false;
+	if (blend && blend != PF_Masked)
+		return false;
+	// The driver keeps the last colour around when it's not given one
+	if ((poly->polyflags & PF_Modulated) && !poly->hassurf)
+		return false;
+	return true;
+}
+
+static int HWR_ComparePolygons(const void *p1, const void *p2)
+{
+	const batchpoly_t *poly1 = &polys[*(const UINT32 *)p1];
+	const batchpoly_t *poly2 = &polys[*(const UINT32 *)p2];
+	UINT32 rgba1, rgba2;
+
+	if (poly1->texture != poly2->texture)
+		return ((size_t)poly1->texture < (size_t)poly2->texture) ? -1 : 1;
+	if (poly1->polyflags != poly2->polyflags)
+		return (poly1->polyflags < poly2->polyflags) ? -1 : 1;
+	if (poly1->hassurf != poly2->hassurf)
+		return poly1->hassurf ? 1 : -1;
+
+	rgba1 = poly1->hassurf ? poly1->surf.FlatColor.rgba : 0;
+	rgba2 = poly2->hassurf ? poly2->surf.FlatColor.rgba : 0;
+	if (rgba1 != rgba2)
+		return (rgba1 < rgba2) ? -1 : 1;
+
+	if (poly1->fogdensity != poly2->fogdensity)
+		return (poly1->fogdensity < poly2->fogdensity) ? -1 : 1;
+	if (poly1->fogcolor != poly2->fogcolor)
+		return (poly1->fogcolor < poly2->fogcolor) ? -1 : 1;
+
+	// Keep submission order within a batch
+	return (*(const UINT32 *)p1 < *(const UINT32 *)p2) ? -1 : 1;
+}
+
+static boolean HWR_SameState(const batchpoly_t *poly1, const batchpoly_t *poly2)
+{
+	return poly1->texture == poly2->texture
+		&& poly1->polyflags == poly2->polyflags
+		&& poly1->hassurf == poly2->hassurf
+		&& (!poly1->hassurf || poly1->surf.FlatColor.rgba == poly2->surf.FlatColor.rgba)
+		&& poly1->fogdensity == poly2->fogdensity
+		&& poly1->fogcolor == poly2->fogcolor;
+}
+
+// Driver state during HWR_RenderBatches
+static GLMipmap_t *boundtexture;
+static FBITFIELD lastpolyflags;
+static UINT32 lastrgba;
+static INT32 boundfogdensity, boundfogcolor;
+
+static void HWR_ApplyState(const batchpoly_t *poly)
+{
+	UINT32 rgba = poly->hassurf ? poly->surf.FlatColor.rgba : 0;
+
+	if (poly->texture != boundtexture)
+	{
+		HWD.pfnSetTexture(poly->texture);
+		boundtexture = poly->texture;
+		batchstats.texturechanges++;
+	}
+	if (poly->polyflags != lastpolyflags)
+	{
+		lastpolyflags = poly->polyflags;
+		batchstats.polyflagchanges++;
+	}
+	if (rgba != lastrgba)
+	{
+		lastrgba = rgba;
+		batchstats.colorchanges++;
+	}
+	if (cv_grfog.value)
+	{
+		if (poly->fogdensity != boundfogdensity)
+		{
+			HWD.pfnSetSpecialState(HWD_SET_FOG_DENSITY, poly->fogdensity);
+			boundfogdensity = poly->fogdensity;
+		}
+		if (poly->fogcolor != boundfogcolor)
+		{
+			HWD.pfnSetSpecialState(HWD_SET_FOG_COLOR, poly->fogcolor);
+			boundfogcolor = poly->fogcolor;
+		}
+	}
+}
+
+// Merges polys[sortindex[first..last-1]] into one indexed triangle list
+static void HWR_DrawBatch(UINT32 first, UINT32 last)
+{
+	batchpoly_t *poly = &polys[sortindex[first]];
+	UINT32 nverts = 0, nindices = 0;
+	UINT32 i, j;
+
+	for (i = first; i < last; i++)
+	{
+		nverts += polys[sortindex[i]].numverts;
+		nindices += (polys[sortindex[i]].numverts - 2) * 3;
+	}
+
+	batchverts = HWR_GrowArray(batchverts, &maxbatchverts, nverts, sizeof (*batchverts));
+	batchindices = HWR_GrowArray(batchindices, &maxbatchindices, nindices, sizeof (*batchindices));
+
+	nverts = nindices = 0;
+	for (i = first; i < last; i++)
+	{
+		const batchpoly_t *p = &polys[sortindex[i]];
+
+		M_Memcpy(&batchverts[nverts], &verts[p->firstvert], p->numverts * sizeof (*batchverts));
+
+		// triangle fan to triangle list
+		for (j = 1; j < p->numverts - 1; j++)
+		{
+			batchindices[nindices++] = nverts;
+			batchindices[nindices++] = nverts + j;
+			batchindices[nindices++] = nverts + j + 1;
+		}
+		nverts += p->numverts;
+	}
+
+	HWR_ApplyState(poly);
+	HWD.pfnDrawIndexedTriangles(poly->hassurf ? &poly->surf : NULL, batchverts, nverts, poly->polyflags, batchindices, nindices);
+	batchstats.drawcalls++;
+}
+
+/**	\brief Draws every polygon recorded since HWR_StartBatching
+*/
+void HWR_RenderBatches(void)
+{
+	UINT32 numsorted = 0, numunsorted;
+	UINT32 i, first;
+
+	counting = false;
+	if (!batching)
+		return;
+	batching = false;
+
+	if (!numpolys)
+		return;
+
+	sortindex = HWR_GrowArray(sortindex, &maxsortindex, numpolys, sizeof (*sortindex));
+
+	// batchable polygons to the front, the rest to the back in their original order
+	numunsorted = 0;
+	for (i = 0; i < numpolys; i++)
+	{
+		if (HWR_IsBatchable(&polys[i]))
+			sortindex[numsorted++] = i;
+		else
+			sortindex[numpolys - ++numunsorted] = i;
+	}
+
+	qsort(sortindex, numsorted, sizeof (*sortindex), HWR_ComparePolygons);
+
+	// force the first polygon to set everything up
+	boundtexture = (GLMipmap_t *)(size_t)-1;
+	lastpolyflags = ~polys[0].polyflags;
+	lastrgba = 0;
+	boundfogdensity = boundfogcolor = -1;
+
+	for (first = 0; first < numsorted; first = i)
+	{
+		for (i = first + 1; i < numsorted; i++)
+			if (!HWR_SameState(&polys[sortindex[first]], &polys[sortindex[i]]))
+				break;
+		HWR_DrawBatch(first, i);
+	}
+
+	for (i = numpolys; i-- > numpolys - numunsorted;)
+	{
+		batchpoly_t *poly = &polys[sortindex[i]];
+
+		HWR_ApplyState(poly);
+		HWD.pfnDrawPolygon(poly->hassurf ? &poly->surf : NULL, &verts[poly->firstvert], poly->numverts, poly->polyflags);
+		batchstats.drawcalls++;
+	}
+
+	// leave the driver the way the renderer thinks it is
+	if (boundtexture != currenttexture)
+		HWD.pfnSetTexture(currenttexture);
+	if (cv_grfog.value)
+	{
+		HWD.pfnSetSpecialState(HWD_SET_FOG_DENSITY, currentfogdensity);
+		HWD.pfnSetSpecialState(HWD_SET_FOG_COLOR, currentfogcolor);
+	}
+}
+
+/**	\brief Prints the polygon and state change counts of the last view rendered
+*/
+void HWR_PrintBatchingStats(void)
+{
+	CONS_Printf(M_GetText("Batching          : %s\n"), (cv_grbatching.value && HWD.pfnDrawIndexedTriangles) ? "On" : "Off");
+	CONS_Printf(M_GetText("Polygons          : %7u (%u vertices)\n"), batchstats.polygons, batchstats.vertices);
+	CONS_Printf(M_GetText("Draw calls        : %7u\n"), batchstats.drawcalls);
+	CONS_Printf(M_GetText("Texture changes   : %7u\n"), batchstats.texturechanges);
+	CONS_Printf(M_GetText("Polyflag changes  : %7u\n"), batchstats.polyflagchanges);
+	CONS_Printf(M_GetText("Colour changes    : %7u\n"), batchstats.colorchanges);
+}
+
+#endif // HWRENDER
@@ -0,0 +1,29 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 1999-2018 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  hw_batching.h
+/// \brief Polygon batching for the hardware renderer
+
+#ifndef __HWR_BATCHING_H__
+#define __HWR_BATCHING_H__
+
+#include "hw_defs.h"
+#include "hw_data.h"
+
+// Polygons recorded between HWR_StartBatching and HWR_RenderBatches are
+// drawn grouped by texture, render mode and surface colour instead of in
+// BSP order. Outside of that window everything goes straight to the driver.
+
+void HWR_StartBatching(void);
+void HWR_SetCurrentTexture(GLMipmap_t *texture);
+void HWR_SetSpecialState(hwdspecialstate_t IStateType, INT32 Value);
+void HWR_ProcessPolygon(FSurfaceInfo *pSurf, FOutVector *pOutVerts, FUINT iNumPts, FBITFIELD PolyFlags);
+void HWR_RenderBatches(void);
+void HWR_PrintBatchingStats(void);
+
+#endif
@@ -22,6 +22,7 @@
 #ifdef HWRENDER
 #include "hw_glob.h"
 #include "hw_drv.h"
+#include "hw_batching.h"
 
 #include "../doomstat.h"    //gamemode
 #include "../i_video.h"     //rendermode
@@ -649,7 +650,7 @@ GLTexture_t *HWR_GetTexture(INT32 tex)
 	if (!grtex->mipmap.grInfo.data && !grtex->mipmap.downloaded)
 		HWR_GenerateTexture(tex, grtex);
 
-	HWD.pfnSetTexture(&grtex->mipmap);
+	HWR_SetCurrentTexture(&grtex->mipmap);
 
 	// The system-memory data can be purged now.
 	Z_ChangeTag(grtex->mipmap.grInfo.data, PU_HWRCACHE_UNLOCKED);
@@ -714,7 +715,7 @@ void HWR_GetFlat(lumpnum_t flatlumpnum)
 	if (!grmip->downloaded && !grmip->grInfo.data)
 		HWR_CacheFlat(grmip, flatlumpnum);
 
-	HWD.pfnSetTexture(grmip);
+	HWR_SetCurrentTexture(grmip);
 
 	// The system-memory data can be purged now.
 	Z_ChangeTag(grmip->grInfo.data, PU_HWRCACHE_UNLOCKED);
@@ -734,7 +735,7 @@ static void HWR_LoadMappedPatch(GLMipmap_t *grmip, GLPatch_t *gpatch)
 		Z_Free(patch);
 	}
 
-	HWD.pfnSetTexture(grmip);
+	HWR_SetCurrentTexture(grmip);
 
 	// The system-memory data can be purged now.
 	Z_ChangeTag(grmip->grInfo.data, PU_HWRCACHE_UNLOCKED);
@@ -758,19 +759,26 @@ void HWR_GetPatch(GLPatch_t *gpatch)
 		Z_Free(ptr);
 	}
 
-	HWD.pfnSetTexture(&gpatch->mipmap);
+	HWR_SetCurrentTexture(&gpatch->mipmap);
 
 	// The system-memory patch data can be purged now.
 	Z_ChangeTag(gpatch->mipmap.grInfo.data, PU_HWRCACHE_UNLOCKED);
 }
 
 
+// Most recoloured copies of one patch kept at once. Translation colormaps
+// are shared (see R_GetTranslationColormap), so this is only reached with
+// a lot of different skincolors on screen; the least recently used copy
+// is thrown out to make room.
+#define MAXMAPPEDMIPMAPS MAXTRANSLATIONS
+
 // -------------------+
 // HWR_GetMappedPatch : Same as HWR_GetPatch for sprite color
 // -------------------+
 void HWR_GetMappedPatch(GLPatch_t *gpatch, const UINT8 *colormap)
 {
-	GLMipmap_t *grmip, *newmip;
+	GLMipmap_t *grmip, *prev, *lastprev = NULL, *newmip;
+	INT32 nummips = 0;
 
 	if (colormap == colormaps || colormap == NULL)
 	{
@@ -781,26 +789,48 @@ void HWR_GetMappedPatch(GLPatch_t *gpatch, const UINT8 *colormap)
 
 	// search for the mimmap
 	// skip the first (no colormap translated)
-	for (grmip = &gpatch->mipmap; grmip->nextcolormap; )
+	for (prev = &gpatch->mipmap; (grmip = prev->nextcolormap) != NULL; lastprev = prev, prev = grmip)
 	{
-		grmip = grmip->nextcolormap;
 		if (grmip->colormap == colormap)
 		{
+			// Keep the list in most recently used order
+			if (prev != &gpatch->mipmap)
+			{
+				prev->nextcolormap = grmip->nextcolormap;
+				grmip->nextcolormap = gpatch->mipmap.nextcolormap;
+				gpatch->mipmap.nextcolormap = grmip;
+			}
 			HWR_LoadMappedPatch(grmip, gpatch);
 			return;
 		}
+		nummips++;
 	}
 	// not found, create it!
 	// If we are here, the sprite with the current colormap is not already in hardware memory
 
-	//BP: WARNING: don't free it manually without clearing the cache of harware renderer
-	//              (it have a liste of mipmap)
-	//    this malloc is cleared in HWR_FreeTextureCache
-	//    (...) unfortunately z_malloc fragment alot the memory :(so malloc is better
-	newmip = calloc(1, sizeof (*newmip));
-	if (newmip == NULL)
-		I_Error("%s: Out of memory", "HWR_GetMappedPatch");
-	grmip->nextcolormap = newmip;
+	if (nummips >= MAXMAPPEDMIPMAPS && HWD.pfnDeleteTexture)
+	{
+		// Reuse the least recently used one, at the end of the list
+		newmip = prev;
+		lastprev->nextcolormap = NULL;
+
+		HWD.pfnDeleteTexture(newmip);
+		if (newmip->grInfo.data)
+			Z_Free(newmip->grInfo.data);
+		memset(newmip, 0, sizeof (*newmip));
+	}
+	else
+	{
+		//BP: WARNING: don't free it manually without clearing the cache of harware renderer
+		//              (it have a liste of mipmap)
+		//    this malloc is cleared in HWR_FreeTextureCache
+		//    (...) unfortunately z_malloc fragment alot the memory :(so malloc is better
+		newmip = calloc(1, sizeof (*newmip));
+		if (newmip == NULL)
+			I_Error("%s: Out of memory", "HWR_GetMappedPatch");
+	}
+	newmip->nextcolormap = gpatch->mipmap.nextcolormap;
+	gpatch->mipmap.nextcolormap = newmip;
 
 	newmip->colormap = colormap;
 	HWR_LoadMappedPatch(newmip, gpatch);
@@ -975,7 +1005,7 @@ GLPatch_t *HWR_GetPic(lumpnum_t lumpnum)
 		grpatch->max_s = (float)newwidth  / (float)blockwidth;
 		grpatch->max_t = (float)newheight / (float)blockheight;
 	}
-	HWD.pfnSetTexture(&grpatch->mipmap);
+	HWR_SetCurrentTexture(&grpatch->mipmap);
 	//CONS_Debug(DBG_RENDER, "picloaded at %x as texture %d\n",grpatch->mipmap.grInfo.data, grpatch->mipmap.downloaded);
 
 	return grpatch;
@@ -1099,7 +1129,7 @@ void HWR_GetFadeMask(lumpnum_t fademasklumpnum)
 	if (!grmip->downloaded && !grmip->grInfo.data)
 		HWR_CacheFadeMask(grmip, fademasklumpnum);
 
-	HWD.pfnSetTexture(grmip);
+	HWR_SetCurrentTexture(grmip);
 
 	// The system-memory data can be purged now.
 	Z_ChangeTag(grmip->grInfo.data, PU_HWRCACHE_UNLOCKED);
@@ -61,6 +61,7 @@ typedef struct
 typedef struct
 {
 	poly_t *planepoly;  // the generated convex polygon
+	struct grplanecache_s *planecache; // flats built from planepoly, one per plane drawn here
 } extrasubsector_t;
 
 // needed for sprite rendering
@@ -77,6 +78,7 @@ typedef struct gr_vissprite_s
 	boolean flip;
 	UINT8 translucency;       //alpha level 0-255
 	mobj_t *mobj;
+	precipmobj_t *precipmobj; // set instead of mobj when precip is true
 	boolean precip; // Tails 08-25-2002
 	boolean vflip;
    //Hurdler: 25/04/2000: now support colormap in hardware mode
@@ -24,6 +24,7 @@
 #include "hw_glob.h"
 #include "hw_light.h"
 #include "hw_drv.h"
+#include "hw_batching.h"
 
 #include "../i_video.h" // for rendermode == render_glide
 #include "../v_video.h"
@@ -124,10 +125,12 @@ consvar_t cv_granisotropicmode = {"gr_anisotropicmode", "1", CV_CALL, granisotro
 //static consvar_t cv_grzbuffer = {"gr_zbuffer", "On", 0, CV_OnOff};
 consvar_t cv_grcorrecttricks = {"gr_correcttricks", "Off", 0, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
 consvar_t cv_grsolvetjoin = {"gr_solvetjoin", "On", 0, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
+consvar_t cv_grbatching = {"gr_batching", "On", 0, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
+consvar_t cv_grstaticgeometry = {"gr_staticgeometry", "On", 0, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
 
 static void CV_FogDensity_ONChange(void)
 {
-	HWD.pfnSetSpecialState(HWD_SET_FOG_DENSITY, cv_grfogdensity.value);
+	HWR_SetSpecialState(HWD_SET_FOG_DENSITY, cv_grfogdensity.value);
 }
 
 static void CV_filtermode_ONChange(void)
@@ -467,9 +470,9 @@ UINT32 HWR_Lighting(INT32 light, UINT32 color, UINT32 fadecolor, boolean fogbloc
 
 			// Set the fog options.
 			if (cv_grsoftwarefog.value == 1 && plane) // With floors, software draws them way darker for their distance
-				HWD.pfnSetSpecialState(HWD_SET_FOG_DENSITY, (INT32)(CALCFOGDENSITYFLOOR(light)));
+				HWR_SetSpecialState(HWD_SET_FOG_DENSITY, (INT32)(CALCFOGDENSITYFLOOR(light)));
 			else // everything else is drawn like walls
-				HWD.pfnSetSpecialState(HWD_SET_FOG_DENSITY, (INT32)(CALCFOGDENSITY(light)));
+				HWR_SetSpecialState(HWD_SET_FOG_DENSITY, (INT32)(CALCFOGDENSITY(light)));
 		}
 		else
 		{
@@ -481,10 +484,10 @@ UINT32 HWR_Lighting(INT32 light, UINT32 color, UINT32 fadecolor, boolean fogbloc
 
 			// Set the fog options.
 			light = (UINT8)(CALCLIGHT(light,(255-fogalpha)));
-			HWD.pfnSetSpecialState(HWD_SET_FOG_DENSITY, (INT32)(cv_grfogdensity.value-(cv_grfogdensity.value*(float)light/255.0f)));
+			HWR_SetSpecialState(HWD_SET_FOG_DENSITY, (INT32)(cv_grfogdensity.value-(cv_grfogdensity.value*(float)light/255.0f)));
 		}
 
-		HWD.pfnSetSpecialState(HWD_SET_FOG_COLOR, (fogcolor.s.red*0x10000)+(fogcolor.s.green*0x100)+fogcolor.s.blue);
+		HWR_SetSpecialState(HWD_SET_FOG_COLOR, (fogcolor.s.red*0x10000)+(fogcolor.s.green*0x100)+fogcolor.s.blue);
 		HWD.pfnSetSpecialState(HWD_SET_FOG_MODE, 1);
 	}
 	return surfcolor.rgba;
@@ -512,6 +515,136 @@ static UINT8 HWR_FogBlockAlpha(INT32 light, UINT32 color) // Let's see if this c
 	return surfcolor.s.alpha;
 }
 
+// ==========================================================================
+//                                                     STATIC GEOMETRY CACHE
+// ==========================================================================
+
+// Flats and walls only depend on their sectors' heights, flats and offsets,
+// so they are built once and kept until one of those changes. Lighting is
+// not part of the cached data and is still computed each time it's drawn.
+
+// flat vertices of one plane of a subsector
+typedef struct grplanecache_s
+{
+	sector_t *sector; // where the offsets come from
+	boolean isceiling;
+	fixed_t fixedheight;
+	lumpnum_t lumpnum;
+	UINT32 version; // sector->grgeomversion it was built for
+	boolean built; // verts were filled in for the values above
+	INT32 numverts;
+	FOutVector *verts;
+	struct grplanecache_s *next;
+} grplanecache_t;
+
+static UINT32 gr_geomframe = 0; // bumped for every view rendered
+
+//
+// HWR_StaticSector
+// Sectors whose geometry only depends on their own fields.
+// R_FakeFlat copies, 3D floors, light lists and moving slopes are rebuilt every frame.
+//
+static boolean HWR_StaticSector(sector_t *sector)
+{
+	if (!cv_grstaticgeometry.value || !sector)
+		return false;
+	if (sector < sectors || sector >= sectors + numsectors)
+		return false;
+	if (sector->ffloors || sector->numlights || sector->heightsec != -1)
+		return false;
+#ifdef ESLOPE
+	if (sector->f_slope && !(sector->f_slope->flags & SL_NODYNAMIC))
+		return false;
+	if (sector->c_slope && !(sector->c_slope->flags & SL_NODYNAMIC))
+		return false;
+#endif
+	return true;
+}
+
+//
+// HWR_SectorGeometryVersion
+// Compares the sector against the state its geometry was last built from,
+// once per view, and sets grdirty when it moved, changed flats or scrolled.
+// Returns a number that changes whenever cached geometry must be rebuilt.
+//
+static UINT32 HWR_SectorGeometryVersion(sector_t *sector)
+{
+	grgeomstate_t state;
+
+	if (sector->grgeomframe == gr_geomframe)
+		return sector->grgeomversion;
+	sector->grgeomframe = gr_geomframe;
+
+	memset(&state, 0, sizeof (state));
+	state.floorheight = sector->floorheight;
+	state.ceilingheight = sector->ceilingheight;
+	state.floorpic = sector->floorpic;
+	state.ceilingpic = sector->ceilingpic;
+	state.floor_xoffs = sector->floor_xoffs;
+	state.floor_yoffs = sector->floor_yoffs;
+	state.ceiling_xoffs = sector->ceiling_xoffs;
+	state.ceiling_yoffs = sector->ceiling_yoffs;
+	state.floorpic_angle = sector->floorpic_angle;
+	state.ceilingpic_angle = sector->ceilingpic_angle;
+#ifdef ESLOPE
+	state.f_slope = sector->f_slope;
+	state.c_slope = sector->c_slope;
+#endif
+
+	sector->grdirty = (memcmp(&state, &sector->grgeom, sizeof (state)) != 0);
+	if (sector->grdirty)
+	{
+		M_Memcpy(&sector->grgeom, &state, sizeof (state));
+		sector->grgeomversion++;
+	}
+	return sector->grgeomversion;
+}
+
+//
+// HWR_GetPlaneCache
+// Finds the cached vertices of a plane, or makes room for them.
+// *valid is set when the vertices can be drawn as they are.
+//
+static grplanecache_t *HWR_GetPlaneCache(extrasubsector_t *xsub, sector_t *sector, boolean isceiling,
+                                         fixed_t fixedheight, lumpnum_t lumpnum, boolean *valid)
+{
+	grplanecache_t *pc;
+	UINT32 version;
+
+	*valid = false;
+
+	if (!HWR_StaticSector(sector))
+		return NULL;
+
+	version = HWR_SectorGeometryVersion(sector);
+
+	for (pc = xsub->planecache; pc; pc = pc->next)
+		if (pc->sector == sector && pc->isceiling == isceiling)
+			break;
+
+	if (!pc)
+	{
+		pc = Z_Calloc(sizeof (*pc), PU_LEVEL, NULL);
+		pc->sector = sector;
+		pc->isceiling = isceiling;
+		pc->numverts = xsub->planepoly->numpts;
+		pc->verts = Z_Malloc(pc->numverts * sizeof (*pc->verts), PU_LEVEL, NULL);
+		pc->next = xsub->planecache;
+		xsub->planecache = pc;
+	}
+	else if (pc->built && pc->version == version && pc->fixedheight == fixedheight && pc->lumpnum == lumpnum)
+	{
+		*valid = true;
+		return pc;
+	}
+
+	pc->built = false;
+	pc->version = version;
+	pc->fixedheight = fixedheight;
+	pc->lumpnum = lumpnum;
+	return pc;
+}
+
 // ==========================================================================
 //                                   FLOOR/CEILING GENERATION FROM SUBSECTORS
 // ==========================================================================
@@ -540,6 +673,9 @@ static void HWR_RenderPlane(sector_t *sector, extrasubsector_t *xsub, boolean is
 #ifdef ESLOPE
 	pslope_t *slope = NULL;
 #endif
+	grplanecache_t *pc = NULL;
+	boolean cached = false;
+	FOutVector *verts;
 
 	static FOutVector *planeVerts = NULL;
 	static UINT16 numAllocedPlaneVerts = 0;
@@ -550,6 +686,16 @@ static void HWR_RenderPlane(sector_t *sector, extrasubsector_t *xsub, boolean is
 	if (!xsub->planepoly)
 		return;
 
+	// the slope, flat size and offsets below all come from this sector
+	if (xsub->planepoly->numpts >= 3)
+		pc = HWR_GetPlaneCache(xsub, FOFsector ? FOFsector : gr_frontsector, isceiling, fixedheight, lumpnum, &cached);
+	if (cached)
+	{
+		verts = pc->verts;
+		nrPlaneVerts = pc->numverts;
+		goto lighting;
+	}
+
 #ifdef ESLOPE
 	// Get the slope pointer to simplify future code
 	if (FOFsector)
@@ -586,12 +732,18 @@ static void HWR_RenderPlane(sector_t *sector, extrasubsector_t *xsub, boolean is
 		return;
 	}
 
-	// Allocate plane-vertex buffer if we need to
-	if (!planeVerts || nrPlaneVerts > numAllocedPlaneVerts)
+	if (pc)
+		verts = pc->verts;
+	else
 	{
-		numAllocedPlaneVerts = (UINT16)nrPlaneVerts;
-		Z_Free(planeVerts);
-		Z_Malloc(numAllocedPlaneVerts * sizeof (FOutVector), PU_LEVEL, &planeVerts);
+		// Allocate plane-vertex buffer if we need to
+		if (!planeVerts || nrPlaneVerts > numAllocedPlaneVerts)
+		{
+			numAllocedPlaneVerts = (UINT16)nrPlaneVerts;
+			Z_Free(planeVerts);
+			Z_Malloc(numAllocedPlaneVerts * sizeof (FOutVector), PU_LEVEL, &planeVerts);
+		}
+		verts = planeVerts;
 	}
 
 	len = W_LumpLength(lumpnum);
@@ -633,7 +785,7 @@ static void HWR_RenderPlane(sector_t *sector, extrasubsector_t *xsub, boolean is
 	flatyref = (float)(((fixed_t)pv->y & (~flatflag)) / fflatsize);
 
 	// transform
-	v3d = planeVerts;
+	v3d = verts;
 
 	if (FOFsector != NULL)
 	{
@@ -717,6 +869,10 @@ static void HWR_RenderPlane(sector_t *sector, extrasubsector_t *xsub, boolean is
 #endif
 	}
 
+	if (pc)
+		pc->built = true;
+
+lighting:
 	// only useful for flat coloured triangles
 	//Surf.FlatColor = 0xff804020;
 
@@ -781,11 +937,11 @@ static void HWR_RenderPlane(sector_t *sector, extrasubsector_t *xsub, boolean is
 	else
 		PolyFlags |= PF_Masked|PF_Modulated|PF_Clip;
 
-	HWD.pfnDrawPolygon(&Surf, planeVerts, nrPlaneVerts, PolyFlags);
+	HWR_ProcessPolygon(&Surf, verts, nrPlaneVerts, PolyFlags);
 
 #ifdef ALAM_LIGHTING
 	// add here code for dynamic lighting on planes
-	HWR_PlaneLighting(planeVerts, nrPlaneVerts);
+	HWR_PlaneLighting(verts, nrPlaneVerts);
 #endif
 }
 
@@ -829,7 +985,7 @@ static void HWR_RenderSkyPlane(extrasubsector_t *xsub, fixed_t fixedheight)
 		v3d->z = pv->y;
 	}
 
-	HWD.pfnDrawPolygon(NULL, planeVerts, nrPlaneVerts,
+	HWR_ProcessPolygon(NULL, planeVerts, nrPlaneVerts,
 	 PF_Clip|PF_Invisible|PF_NoTexture|PF_Occlude);
 }
 #endif //polysky
@@ -920,7 +1076,7 @@ static void HWR_DrawSegsSplats(FSurfaceInfo * pSurf)
 				break;
 		}
 
-		HWD.pfnDrawPolygon(&pSurf2, trVerts, 4, i|PF_Modulated|PF_Clip|PF_Decal);
+		HWR_ProcessPolygon(&pSurf2, trVerts, 4, i|PF_Modulated|PF_Clip|PF_Decal);
 	}
 }
 #endif
@@ -953,6 +1109,78 @@ FBITFIELD HWR_TranstableToAlpha(INT32 transtablenum, FSurfaceInfo *pSurf)
 
 static void HWR_AddTransparentWall(wallVert3D *wallVerts, FSurfaceInfo * pSurf, INT32 texnum, FBITFIELD blend, boolean fogwall, INT32 lightlevel, extracolormap_t *wallcolormap);
 
+#ifdef NEWCLIP
+#define MAXWALLCMDS 16 // walls a single seg can make without 3D floors
+
+// one HWR_ProjectWall or HWR_AddTransparentWall call made for a seg
+typedef struct
+{
+	wallVert3D wallVerts[4];
+	FSurfaceInfo Surf;
+	INT32 texnum; // -1 for no texture
+	FBITFIELD blendmode;
+	boolean transparent;
+	boolean sectorlight; // lit by the front sector, not by the values below
+	INT32 lightlevel;
+	extracolormap_t *colormap;
+} grwallcmd_t;
+
+// everything HWR_ProcessSeg reads for a seg with static sectors
+typedef struct
+{
+	sector_t *frontsector, *backsector;
+	UINT32 frontversion, backversion;
+	fixed_t textureoffset, rowoffset;
+	INT32 toptexture, midtexture, bottomtexture; // after animation
+	INT32 repeatcnt;
+	INT32 lineflags, special;
+	INT32 skyflatnum;
+} grwallkey_t;
+
+typedef struct grwallcache_s
+{
+	grwallkey_t key;
+	INT32 numcmds;
+	grwallcmd_t *cmds;
+} grwallcache_t;
+
+static boolean gr_recordwalls = false;
+static boolean gr_wallsoverflow;
+static INT32 gr_numwallcmds;
+static grwallcmd_t gr_wallcmds[MAXWALLCMDS];
+static INT32 gr_walltexnum = -1; // texture bound for the next HWR_ProjectWall
+
+static void HWR_RecordWall(wallVert3D *wallVerts, FSurfaceInfo *pSurf, INT32 texnum, FBITFIELD blendmode,
+                           boolean transparent, INT32 lightlevel, extracolormap_t *colormap)
+{
+	grwallcmd_t *cmd;
+
+	if (gr_numwallcmds == MAXWALLCMDS)
+	{
+		gr_wallsoverflow = true;
+		return;
+	}
+
+	cmd = &gr_wallcmds[gr_numwallcmds++];
+	M_Memcpy(cmd->wallVerts, wallVerts, sizeof (cmd->wallVerts));
+	cmd->Surf = *pSurf;
+	cmd->texnum = texnum;
+	cmd->blendmode = blendmode;
+	cmd->transparent = transparent;
+	cmd->sectorlight = (lightlevel == gr_frontsector->lightlevel && colormap == gr_frontsector->extra_colormap);
+	cmd->lightlevel = lightlevel;
+	cmd->colormap = colormap;
+}
+
+static GLTexture_t *HWR_GetWallTexture(INT32 texnum)
+{
+	gr_walltexnum = texnum;
+	return HWR_GetTexture(texnum);
+}
+#else
+#define HWR_GetWallTexture HWR_GetTexture
+#endif
+
 // -----------------+
 // HWR_ProjectWall  :
 // -----------------+
@@ -970,6 +1198,11 @@ static void HWR_ProjectWall(wallVert3D   * wallVerts,
 	FOutVector  trVerts[4];
 	FOutVector  *wv;
 
+#ifdef NEWCLIP
+	if (gr_recordwalls)
+		HWR_RecordWall(wallVerts, pSurf, gr_walltexnum, blendmode, false, lightlevel, wallcolormap);
+#endif
+
 	// transform
 	wv = trVerts;
 	// it sounds really stupid to do this conversion with the new T&L code
@@ -1011,7 +1244,7 @@ static void HWR_ProjectWall(wallVert3D   * wallVerts,
 		pSurf->FlatColor.rgba = HWR_Lighting(lightlevel, NORMALFOG, FADEFOG, false, false);
 	}
 
-	HWD.pfnDrawPolygon(pSurf, trVerts, 4, blendmode|PF_Modulated|PF_Occlude|PF_Clip);
+	HWR_ProcessPolygon(pSurf, trVerts, 4, blendmode|PF_Modulated|PF_Occlude|PF_Clip);
 
 #ifdef WALLSPLATS
 	if (gr_curline->linedef->splats && cv_splats.value)
@@ -1318,7 +1551,10 @@ static void HWR_SplitWall(sector_t *sector, wallVert3D *wallVerts, INT32 texnum,
 // Draw walls into the depth buffer so that anything behind is culled properly
 static void HWR_DrawSkyWall(wallVert3D *wallVerts, FSurfaceInfo *Surf, fixed_t bottom, fixed_t top)
 {
-	HWD.pfnSetTexture(NULL);
+	HWR_SetCurrentTexture(NULL);
+#ifdef NEWCLIP
+	gr_walltexnum = -1;
+#endif
 	// no texture
 	wallVerts[3].t = wallVerts[2].t = 0;
 	wallVerts[0].t = wallVerts[1].t = 0;
@@ -1484,7 +1720,7 @@ static void HWR_StoreWallRange(double startfrac, double endfrac)
 			{
 				fixed_t texturevpegtop; // top
 
-				grTex = HWR_GetTexture(gr_toptexture);
+				grTex = HWR_GetWallTexture(gr_toptexture);
 
 				// PEGGING
 				if (gr_linedef->flags & ML_DONTPEGTOP)
@@ -1564,7 +1800,7 @@ static void HWR_StoreWallRange(double startfrac, double endfrac)
 			{
 				fixed_t texturevpegbottom = 0; // bottom
 
-				grTex = HWR_GetTexture(gr_bottomtexture);
+				grTex = HWR_GetWallTexture(gr_bottomtexture);
 
 				// PEGGING
 #ifdef ESLOPE
@@ -1763,7 +1999,7 @@ static void HWR_StoreWallRange(double startfrac, double endfrac)
 				else
 					texturevpeg = polytop - h;
 
-				grTex = HWR_GetTexture(gr_midtexture);
+				grTex = HWR_GetWallTexture(gr_midtexture);
 
 				wallVerts[3].t = wallVerts[2].t = texturevpeg * grTex->scaleY;
 				wallVerts[0].t = wallVerts[1].t = (h - l + texturevpeg) * grTex->scaleY;
@@ -2011,7 +2247,7 @@ static void HWR_StoreWallRange(double startfrac, double endfrac)
 					// top of texture at top
 					texturevpeg = gr_sidedef->rowoffset;
 
-				grTex = HWR_GetTexture(gr_midtexture);
+				grTex = HWR_GetWallTexture(gr_midtexture);
 
 				wallVerts[3].t = wallVerts[2].t = texturevpeg * grTex->scaleY;
 				wallVerts[0].t = wallVerts[1].t = (texturevpeg + gr_frontsector->ceilingheight - gr_frontsector->floorheight) * grTex->scaleY;
@@ -2165,7 +2401,7 @@ static void HWR_StoreWallRange(double startfrac, double endfrac)
 #endif
 					}
 
-					grTex = HWR_GetTexture(texnum);
+					grTex = HWR_GetWallTexture(texnum);
 
 #ifdef ESLOPE
 					if (!slopeskew) // no skewing
@@ -2305,7 +2541,7 @@ static void HWR_StoreWallRange(double startfrac, double endfrac)
 				}
 				else
 				{
-					grTex = HWR_GetTexture(texnum);
+					grTex = HWR_GetWallTexture(texnum);
 
 					if (newline)
 					{
@@ -2768,6 +3004,104 @@ static void HWR_ClearClipSegs(void)
 // Notes            : gr_cursectorlight is set to the current subsector -> sector -> light value
 //                  : (it may be mixed with the wall's own flat colour in the future ...)
 // -----------------+
+#ifdef NEWCLIP
+//
+// HWR_ProcessStaticSeg
+// Draws the walls of gr_curline again from its cache when neither its sectors
+// nor its sidedef changed, otherwise builds them with HWR_ProcessSeg and
+// records them for the next frames.
+//
+static void HWR_ProcessStaticSeg(void)
+{
+	grwallcache_t *wc = gr_curline->grwallcache;
+	grwallkey_t key;
+	INT32 i;
+
+	if (gr_curline->polyseg || !HWR_StaticSector(gr_frontsector)
+		|| (gr_backsector && !HWR_StaticSector(gr_backsector)))
+	{
+		HWR_ProcessSeg();
+		return;
+	}
+
+	memset(&key, 0, sizeof (key));
+	key.frontsector = gr_frontsector;
+	key.frontversion = HWR_SectorGeometryVersion(gr_frontsector);
+	if (gr_backsector)
+	{
+		key.backsector = gr_backsector;
+		key.backversion = HWR_SectorGeometryVersion(gr_backsector);
+	}
+	key.textureoffset = gr_curline->sidedef->textureoffset;
+	key.rowoffset = gr_curline->sidedef->rowoffset;
+	key.toptexture = R_GetTextureNum(gr_curline->sidedef->toptexture);
+	key.midtexture = R_GetTextureNum(gr_curline->sidedef->midtexture);
+	key.bottomtexture = R_GetTextureNum(gr_curline->sidedef->bottomtexture);
+	key.repeatcnt = gr_curline->sidedef->repeatcnt;
+	key.lineflags = gr_curline->linedef->flags;
+	key.special = gr_curline->linedef->special;
+	key.skyflatnum = skyflatnum;
+
+	if (wc && !memcmp(&wc->key, &key, sizeof (key)))
+	{
+		gr_sidedef = gr_curline->sidedef;
+		gr_linedef = gr_curline->linedef;
+
+		for (i = 0; i < wc->numcmds; i++)
+		{
+			grwallcmd_t *cmd = &wc->cmds[i];
+			wallVert3D wallVerts[4];
+			FSurfaceInfo Surf;
+			INT32 lightlevel = cmd->sectorlight ? gr_frontsector->lightlevel : cmd->lightlevel;
+			extracolormap_t *colormap = cmd->sectorlight ? gr_frontsector->extra_colormap : cmd->colormap;
+
+			M_Memcpy(wallVerts, cmd->wallVerts, sizeof (wallVerts));
+			Surf = cmd->Surf;
+
+			if (cmd->transparent)
+				HWR_AddTransparentWall(wallVerts, &Surf, cmd->texnum, cmd->blendmode, false, lightlevel, colormap);
+			else
+			{
+				if (cmd->texnum == -1)
+					HWR_SetCurrentTexture(NULL);
+				else
+					HWR_GetTexture(cmd->texnum);
+				HWR_ProjectWall(wallVerts, &Surf, cmd->blendmode, lightlevel, colormap);
+			}
+		}
+		return;
+	}
+
+	gr_recordwalls = true;
+	gr_wallsoverflow = false;
+	gr_numwallcmds = 0;
+	gr_walltexnum = -1;
+
+	HWR_ProcessSeg();
+
+	gr_recordwalls = false;
+
+	if (gr_wallsoverflow)
+	{
+		if (wc)
+			wc->key.frontsector = NULL; // never matches
+		return;
+	}
+
+	if (!wc)
+		wc = gr_curline->grwallcache = Z_Calloc(sizeof (*wc), PU_LEVEL, NULL);
+	if (wc->numcmds != gr_numwallcmds)
+	{
+		Z_Free(wc->cmds);
+		wc->cmds = gr_numwallcmds ? Z_Malloc(gr_numwallcmds * sizeof (*wc->cmds), PU_LEVEL, NULL) : NULL;
+		wc->numcmds = gr_numwallcmds;
+	}
+	if (gr_numwallcmds)
+		M_Memcpy(wc->cmds, gr_wallcmds, gr_numwallcmds * sizeof (*wc->cmds));
+	M_Memcpy(&wc->key, &key, sizeof (key));
+}
+#endif
+
 static void HWR_AddLine(seg_t * line)
 {
 	angle_t angle1, angle2;
@@ -2913,7 +3247,7 @@ static void HWR_AddLine(seg_t * line)
 			return;
     }
 
-	HWR_ProcessSeg(); // Doesn't need arguments because they're defined globally :D
+	HWR_ProcessStaticSeg(); // Doesn't need arguments because they're defined globally :D
 	return;
 #else
 	// Single sided line?
@@ -3307,7 +3641,7 @@ static void HWR_RenderPolyObjectPlane(polyobj_t *polysector, boolean isceiling,
 	else
 		blendmode |= PF_Masked|PF_Modulated|PF_Clip;
 
-	HWD.pfnDrawPolygon(&Surf, planeVerts, nrPlaneVerts, blendmode);
+	HWR_ProcessPolygon(&Surf, planeVerts, nrPlaneVerts, blendmode);
 }
 
 static void HWR_AddPolyObjectPlanes(void)
@@ -4242,7 +4576,7 @@ static void HWR_DrawSpriteShadow(gr_vissprite_t *spr, GLPatch_t *gpatch, float t
 	if (sSurf.FlatColor.s.alpha > floorheight/4)
 	{
 		sSurf.FlatColor.s.alpha = (UINT8)(sSurf.FlatColor.s.alpha - floorheight/4);
-		HWD.pfnDrawPolygon(&sSurf, swallVerts, 4, PF_Translucent|PF_Modulated|PF_Clip);
+		HWR_ProcessPolygon(&sSurf, swallVerts, 4, PF_Translucent|PF_Modulated|PF_Clip);
 	}
 }
 
@@ -4496,7 +4830,7 @@ static void HWR_SplitSprite(gr_vissprite_t *spr)
 
 		Surf.FlatColor.s.alpha = alpha;
 
-		HWD.pfnDrawPolygon(&Surf, wallVerts, 4, blend|PF_Modulated|PF_Clip);
+		HWR_ProcessPolygon(&Surf, wallVerts, 4, blend|PF_Modulated|PF_Clip);
 
 		top = bot;
 #ifdef ESLOPE
@@ -4538,7 +4872,7 @@ static void HWR_SplitSprite(gr_vissprite_t *spr)
 
 	Surf.FlatColor.s.alpha = alpha;
 
-	HWD.pfnDrawPolygon(&Surf, wallVerts, 4, blend|PF_Modulated|PF_Clip);
+	HWR_ProcessPolygon(&Surf, wallVerts, 4, blend|PF_Modulated|PF_Clip);
 }
 
 // -----------------+
@@ -4698,7 +5032,7 @@ static void HWR_DrawSprite(gr_vissprite_t *spr)
 			blend = PF_Translucent|PF_Occlude;
 		}
 
-		HWD.pfnDrawPolygon(&Surf, wallVerts, 4, blend|PF_Modulated|PF_Clip);
+		HWR_ProcessPolygon(&Surf, wallVerts, 4, blend|PF_Modulated|PF_Clip);
 	}
 }
 
@@ -4711,10 +5045,10 @@ static inline void HWR_DrawPrecipitationSprite(gr_vissprite_t *spr)
 	GLPatch_t *gpatch; // sprite patch converted to hardware
 	FSurfaceInfo Surf;
 
-	if (!spr->mobj)
+	if (!spr->precipmobj)
 		return;
 
-	if (!spr->mobj->subsector)
+	if (!spr->precipmobj->subsector)
 		return;
 
 	// cache sprite graphics
@@ -4749,7 +5083,7 @@ static inline void HWR_DrawPrecipitationSprite(gr_vissprite_t *spr)
 
 	// colormap test
 	{
-		sector_t *sector = spr->mobj->subsector->sector;
+		sector_t *sector = spr->precipmobj->subsector->sector;
 		UINT8 lightlevel = 255;
 		extracolormap_t *colormap = sector->extra_colormap;
 
@@ -4757,9 +5091,9 @@ static inline void HWR_DrawPrecipitationSprite(gr_vissprite_t *spr)
 		{
 			INT32 light;
 
-			light = R_GetPlaneLight(sector, spr->mobj->z + spr->mobj->height, false); // Always use the light at the top instead of whatever I was doing before
+			light = R_GetPlaneLight(sector, spr->precipmobj->z + spr->precipmobj->height, false); // Always use the light at the top instead of whatever I was doing before
 
-			if (!(spr->mobj->frame & FF_FULLBRIGHT))
+			if (!(spr->precipmobj->frame & FF_FULLBRIGHT))
 				lightlevel = *sector->lightlist[light].lightlevel;
 
 			if (sector->lightlist[light].extra_colormap)
@@ -4767,7 +5101,7 @@ static inline void HWR_DrawPrecipitationSprite(gr_vissprite_t *spr)
 		}
 		else
 		{
-			if (!(spr->mobj->frame & FF_FULLBRIGHT))
+			if (!(spr->precipmobj->frame & FF_FULLBRIGHT))
 				lightlevel = sector->lightlevel;
 
 			if (sector->extra_colormap)
@@ -4780,13 +5114,8 @@ static inline void HWR_DrawPrecipitationSprite(gr_vissprite_t *spr)
 			Surf.FlatColor.rgba = HWR_Lighting(lightlevel, NORMALFOG, FADEFOG, false, false);
 	}
 
-	if (spr->mobj->flags2 & MF2_SHADOW)
-	{
-		Surf.FlatColor.s.alpha = 0x40;
-		blend = PF_Translucent;
-	}
-	else if (spr->mobj->frame & FF_TRANSMASK)
-		blend = HWR_TranstableToAlpha((spr->mobj->frame & FF_TRANSMASK)>>FF_TRANSSHIFT, &Surf);
+	if (spr->precipmobj->frame & FF_TRANSMASK)
+		blend = HWR_TranstableToAlpha((spr->precipmobj->frame & FF_TRANSMASK)>>FF_TRANSSHIFT, &Surf);
 	else
 	{
 		// BP: i agree that is little better in environement but it don't
@@ -4797,7 +5126,7 @@ static inline void HWR_DrawPrecipitationSprite(gr_vissprite_t *spr)
 		blend = PF_Translucent|PF_Occlude;
 	}
 
-	HWD.pfnDrawPolygon(&Surf, wallVerts, 4, blend|PF_Modulated|PF_Clip);
+	HWR_ProcessPolygon(&Surf, wallVerts, 4, blend|PF_Modulated|PF_Clip);
 }
 #endif
 
@@ -5635,7 +5964,8 @@ static void HWR_ProjectPrecipitationSprite(precipmobj_t *thing)
 	vis->dispoffset = 0; // Monster Iestyn: 23/11/15: HARDWARE SUPPORT AT LAST
 	vis->patchlumpnum = sprframe->lumppat[rot];
 	vis->flip = flip;
-	vis->mobj = (mobj_t *)thing;
+	vis->mobj = NULL;
+	vis->precipmobj = thing;
 
 	vis->colormap = colormaps;
 
@@ -5726,7 +6056,7 @@ static void HWR_DrawSkyBackground(void)
 		v[0].tow = v[1].tow -= ((float) angle / angleturn);
 	}
 
-	HWD.pfnDrawPolygon(NULL, v, 4, 0);
+	HWR_ProcessPolygon(NULL, v, 4, 0);
 }
 
 
@@ -5907,12 +6237,15 @@ if (0)
 	HWD.pfnSetTransform(&atransform);
 
 	validcount++;
+	gr_geomframe++;
+
+	HWR_StartBatching();
 
 	HWR_RenderBSPNode((INT32)numnodes-1);
 
 #ifndef NEWCLIP
 	// Make a viewangle int so we can render things based on mouselook
-	if (player == &players[consoleplayer])
+	if (player == &players[consoleplayer] && !playerless)
 		viewangle = localaiming;
 	else if (splitscreen && player == &players[secondarydisplayplayer])
 		viewangle = localaiming2;
@@ -5939,6 +6272,8 @@ if (0)
 	}
 #endif
 
+	HWR_RenderBatches();
+
 	// Check for new console commands.
 	NetUpdate();
 
@@ -6124,12 +6459,15 @@ if (0)
 	HWD.pfnSetTransform(&atransform);
 
 	validcount++;
+	gr_geomframe++;
+
+	HWR_StartBatching();
 
 	HWR_RenderBSPNode((INT32)numnodes-1);
 
 #ifndef NEWCLIP
 	// Make a viewangle int so we can render things based on mouselook
-	if (player == &players[consoleplayer])
+	if (player == &players[consoleplayer] && !playerless)
 		viewangle = localaiming;
 	else if (splitscreen && player == &players[secondarydisplayplayer])
 		viewangle = localaiming2;
@@ -6156,6 +6494,8 @@ if (0)
 	}
 #endif
 
+	HWR_RenderBatches();
+
 	// Check for new console commands.
 	NetUpdate();
 
@@ -6248,8 +6588,8 @@ static UINT32 atohex(const char *s)
 
 static void HWR_FoggingOn(void)
 {
-	HWD.pfnSetSpecialState(HWD_SET_FOG_COLOR, atohex(cv_grfogcolor.string));
-	HWD.pfnSetSpecialState(HWD_SET_FOG_DENSITY, cv_grfogdensity.value);
+	HWR_SetSpecialState(HWD_SET_FOG_COLOR, atohex(cv_grfogcolor.string));
+	HWR_SetSpecialState(HWD_SET_FOG_DENSITY, cv_grfogdensity.value);
 	HWD.pfnSetSpecialState(HWD_SET_FOG_MODE, 1);
 }
 
@@ -6271,6 +6611,7 @@ static void Command_GrStats_f(void)
 	CONS_Printf(M_GetText("Patch info headers: %7s kb\n"), sizeu1(Z_TagUsage(PU_HWRPATCHINFO)>>10));
 	CONS_Printf(M_GetText("3D Texture cache  : %7s kb\n"), sizeu1(Z_TagUsage(PU_HWRCACHE)>>10));
 	CONS_Printf(M_GetText("Plane polygon     : %7s kb\n"), sizeu1(Z_TagUsage(PU_HWRPLANE)>>10));
+	HWR_PrintBatchingStats();
 }
 
 
@@ -6305,6 +6646,8 @@ static inline void HWR_AddEngineCommands(void)
 	// - usage may vary from version to version..
 	CV_RegisterVar(&cv_gralpha);
 	CV_RegisterVar(&cv_grbeta);
+	CV_RegisterVar(&cv_grbatching);
+	CV_RegisterVar(&cv_grstaticgeometry);
 
 	// engine commands
 	COM_AddCommand("gr_stats", Command_GrStats_f);
@@ -6494,6 +6837,16 @@ static void HWR_AddTransparentWall(wallVert3D *wallVerts, FSurfaceInfo *pSurf, I
 {
 	static size_t allocedwalls = 0;
 
+#ifdef NEWCLIP
+	if (gr_recordwalls)
+	{
+		if (fogwall) // only 3D floors make these
+			gr_wallsoverflow = true;
+		else
+			HWR_RecordWall(wallVerts, pSurf, texnum, blend, true, lightlevel, wallcolormap);
+	}
+#endif
+
 	// Force realloc if buffer has been freed
 	if (!wallinfo)
 		allocedwalls = 0;
@@ -6591,9 +6944,9 @@ static void HWR_RenderWall(wallVert3D   *wallVerts, FSurfaceInfo *pSurf, FBITFIE
 	pSurf->FlatColor.s.alpha = alpha; // put the alpha back after lighting
 
 	if (blend & PF_Environment)
-		HWD.pfnDrawPolygon(pSurf, trVerts, 4, blend|PF_Modulated|PF_Clip|PF_Occlude); // PF_Occlude must be used for solid objects
+		HWR_ProcessPolygon(pSurf, trVerts, 4, blend|PF_Modulated|PF_Clip|PF_Occlude); // PF_Occlude must be used for solid objects
 	else
-		HWD.pfnDrawPolygon(pSurf, trVerts, 4, blend|PF_Modulated|PF_Clip); // No PF_Occlude means overlapping (incorrect) transparency
+		HWR_ProcessPolygon(pSurf, trVerts, 4, blend|PF_Modulated|PF_Clip); // No PF_Occlude means overlapping (incorrect) transparency
 
 #ifdef WALLSPLATS
 	if (gr_curline->linedef->splats && cv_splats.value)
@@ -6647,7 +7000,7 @@ void HWR_DoPostProcessor(player_t *player)
 
 		Surf.FlatColor.s.alpha = 0xc0; // match software mode
 
-		HWD.pfnDrawPolygon(&Surf, v, 4, PF_Modulated|PF_Additive|PF_NoTexture|PF_NoDepthTest|PF_Clip|PF_NoZClip);
+		HWR_ProcessPolygon(&Surf, v, 4, PF_Modulated|PF_Additive|PF_NoTexture|PF_NoDepthTest|PF_Clip|PF_NoZClip);
 	}
 
 	// Capture the screen for intermission and screen waving
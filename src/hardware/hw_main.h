@@ -95,6 +95,8 @@ extern consvar_t cv_grcorrecttricks;
 extern consvar_t cv_voodoocompatibility;
 extern consvar_t cv_grfovchange;
 extern consvar_t cv_grsolvetjoin;
+extern consvar_t cv_grbatching;
+extern consvar_t cv_grstaticgeometry;
 
 extern float gr_viewwidth, gr_viewheight, gr_baseviewwindowy;
 
@@ -1147,51 +1147,50 @@ static void HWR_CreateBlendedTexture(GLPatch_t *gpatch, GLPatch_t *blendgpatch,
 	return;
 }
 
-static void HWR_GetBlendedTexture(GLPatch_t *gpatch, GLPatch_t *blendgpatch, const UINT8 *colormap, skincolors_t color)
+static void HWR_GetBlendedTexture(md2_t *md2, GLPatch_t *gpatch, GLPatch_t *blendgpatch, const UINT8 *colormap, skincolors_t color)
 {
-	// mostly copied from HWR_GetMappedPatch, hence the similarities and comment
-	GLMipmap_t *grmip, *newmip;
+	GLMipmap_t *grmip;
 
-	if (colormap == colormaps || colormap == NULL)
+	if (colormap == colormaps || colormap == NULL || color >= MAXTRANSLATIONS)
 	{
 		// Don't do any blending
 		HWD.pfnSetTexture(&gpatch->mipmap);
 		return;
 	}
 
-	// search for the mimmap
-	// skip the first (no colormap translated)
-	for (grmip = &gpatch->mipmap; grmip->nextcolormap; )
+	// The blend only depends on the model and the skin colour, so each
+	// model keeps one texture per colour, however many colormaps use it.
+	// They live as long as the model; flushing the driver cache only
+	// clears 'downloaded', and then the texture is blended again.
+	if (!md2->blendmipmaps)
 	{
-		grmip = grmip->nextcolormap;
-		if (grmip->colormap == colormap)
-		{
-			if (grmip->downloaded && grmip->grInfo.data)
-			{
-				HWD.pfnSetTexture(grmip); // found the colormap, set it to the correct texture
-				Z_ChangeTag(grmip->grInfo.data, PU_HWRCACHE_UNLOCKED);
-				return;
-			}
-		}
+		md2->blendmipmaps = calloc(MAXTRANSLATIONS, sizeof (GLMipmap_t));
+		if (!md2->blendmipmaps)
+			I_Error("%s: Out of memory", "HWR_GetBlendedTexture");
 	}
+	grmip = &((GLMipmap_t *)md2->blendmipmaps)[color];
 
-	// If here, the blended texture has not been created
-	// So we create it
+	if (grmip->downloaded)
+	{
+		HWD.pfnSetTexture(grmip);
+		return;
+	}
 
-	//BP: WARNING: don't free it manually without clearing the cache of harware renderer
-	//              (it have a liste of mipmap)
-	//    this malloc is cleared in HWR_FreeTextureCache
-	//    (...) unfortunately z_malloc fragment alot the memory :(so malloc is better
-	newmip = calloc(1, sizeof (*newmip));
-	if (newmip == NULL)
-		I_Error("%s: Out of memory", "HWR_GetMappedPatch");
-	grmip->nextcolormap = newmip;
-	newmip->colormap = colormap;
+	if (!gpatch->mipmap.grInfo.data || !blendgpatch->mipmap.grInfo.data)
+	{
+		// the source images were purged, draw it unblended until they reload
+		HWD.pfnSetTexture(&gpatch->mipmap);
+		return;
+	}
 
-	HWR_CreateBlendedTexture(gpatch, blendgpatch, newmip, color);
+	grmip->colormap = colormap;
+	HWR_CreateBlendedTexture(gpatch, blendgpatch, grmip, color);
 
-	HWD.pfnSetTexture(newmip);
-	Z_ChangeTag(newmip->grInfo.data, PU_HWRCACHE_UNLOCKED);
+	HWD.pfnSetTexture(grmip);
+
+	// the driver has its own copy now
+	Z_Free(grmip->grInfo.data);
+	grmip->grInfo.data = NULL;
 }
 
 
@@ -1339,7 +1338,7 @@ void HWR_DrawMD2(gr_vissprite_t *spr)
 				md2->blendgrpatch && ((GLPatch_t *)md2->blendgrpatch)->mipmap.grInfo.format
 				&& gpatch->width == ((GLPatch_t *)md2->blendgrpatch)->width && gpatch->height == ((GLPatch_t *)md2->blendgrpatch)->height)
 			{
-				HWR_GetBlendedTexture(gpatch, (GLPatch_t *)md2->blendgrpatch, spr->colormap, (skincolors_t)spr->mobj->color);
+				HWR_GetBlendedTexture(md2, gpatch, (GLPatch_t *)md2->blendgrpatch, spr->colormap, (skincolors_t)spr->mobj->color);
 			}
 			else
 			{
@@ -126,6 +126,7 @@ typedef struct
 	md2_model_t *model;
 	void        *grpatch;
 	void        *blendgrpatch;
+	void        *blendmipmaps; // GLMipmap_t[MAXTRANSLATIONS], skin colour blends
 	boolean     notfound;
 	INT32       skin;
 	boolean     error;
@@ -246,6 +246,14 @@ FUNCPRINTF void DBG_Printf(const char *lpFmt, ...)
 #define pglColor4fv glColor4fv
 #define pglTexCoord2f glTexCoord2f
 
+/* Vertex arrays */
+#define pglEnableClientState glEnableClientState
+#define pglDisableClientState glDisableClientState
+#define pglVertexPointer glVertexPointer
+#define pglTexCoordPointer glTexCoordPointer
+#define pglNormalPointer glNormalPointer
+#define pglDrawElements glDrawElements
+
 /* Lighting */
 #define pglShadeModel glShadeModel
 #define pglLightfv glLightfv
@@ -358,6 +366,20 @@ static PFNglColor4fv pglColor4fv;
 typedef void (APIENTRY * PFNglTexCoord2f) (GLfloat s, GLfloat t);
 static PFNglTexCoord2f pglTexCoord2f;
 
+/* Vertex arrays */
+typedef void (APIENTRY * PFNglEnableClientState) (GLenum cap);
+static PFNglEnableClientState pglEnableClientState;
+typedef void (APIENTRY * PFNglDisableClientState) (GLenum cap);
+static PFNglDisableClientState pglDisableClientState;
+typedef void (APIENTRY * PFNglVertexPointer) (GLint size, GLenum type, GLsizei stride, const GLvoid *pointer);
+static PFNglVertexPointer pglVertexPointer;
+typedef void (APIENTRY * PFNglTexCoordPointer) (GLint size, GLenum type, GLsizei stride, const GLvoid *pointer);
+static PFNglTexCoordPointer pglTexCoordPointer;
+typedef void (APIENTRY * PFNglNormalPointer) (GLenum type, GLsizei stride, const GLvoid *pointer);
+static PFNglNormalPointer pglNormalPointer;
+typedef void (APIENTRY * PFNglDrawElements) (GLenum mode, GLsizei count, GLenum type, const GLvoid *indices);
+static PFNglDrawElements pglDrawElements;
+
 /* Lighting */
 typedef void (APIENTRY * PFNglShadeModel) (GLenum mode);
 static PFNglShadeModel pglShadeModel;
@@ -410,6 +432,38 @@ typedef void (APIENTRY *PFNglActiveTexture) (GLenum);
 static PFNglActiveTexture pglActiveTexture;
 typedef void (APIENTRY *PFNglMultiTexCoord2f) (GLenum, GLfloat, GLfloat);
 static PFNglMultiTexCoord2f pglMultiTexCoord2f;
+
+/* 1.5 functions for buffer objects */
+typedef void (APIENTRY *PFNglGenBuffers) (GLsizei n, GLuint *buffers);
+static PFNglGenBuffers pglGenBuffers;
+typedef void (APIENTRY *PFNglBindBuffer) (GLenum target, GLuint buffer);
+static PFNglBindBuffer pglBindBuffer;
+typedef void (APIENTRY *PFNglBufferData) (GLenum target, ptrdiff_t size, const GLvoid *data, GLenum usage);
+static PFNglBufferData pglBufferData;
+typedef void (APIENTRY *PFNglDeleteBuffers) (GLsizei n, const GLuint *buffers);
+static PFNglDeleteBuffers pglDeleteBuffers;
+
+static boolean gl15 = false; // whether vertex buffer objects are available
+static GLuint batch_vbo = 0; // streamed vertices for DrawIndexedTriangles
+
+/* GL_ARB_vertex_program, for MD2 frame interpolation */
+typedef void (APIENTRY *PFNglGenProgramsARB) (GLsizei n, GLuint *programs);
+static PFNglGenProgramsARB pglGenProgramsARB;
+typedef void (APIENTRY *PFNglBindProgramARB) (GLenum target, GLuint program);
+static PFNglBindProgramARB pglBindProgramARB;
+typedef void (APIENTRY *PFNglProgramStringARB) (GLenum target, GLenum format, GLsizei len, const GLvoid *string);
+static PFNglProgramStringARB pglProgramStringARB;
+typedef void (APIENTRY *PFNglProgramEnvParameter4fARB) (GLenum target, GLuint index, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+static PFNglProgramEnvParameter4fARB pglProgramEnvParameter4fARB;
+typedef void (APIENTRY *PFNglVertexAttribPointerARB) (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const GLvoid *pointer);
+static PFNglVertexAttribPointerARB pglVertexAttribPointerARB;
+typedef void (APIENTRY *PFNglEnableVertexAttribArrayARB) (GLuint index);
+static PFNglEnableVertexAttribArrayARB pglEnableVertexAttribArrayARB;
+typedef void (APIENTRY *PFNglDisableVertexAttribArrayARB) (GLuint index);
+static PFNglDisableVertexAttribArrayARB pglDisableVertexAttribArrayARB;
+
+static boolean glvp = false; // whether MD2 models can be drawn from vertex buffers
+static GLuint md2_program = 0; // 0: not compiled yet, (GLuint)-1: failed
 #endif
 
 #ifndef MINI_GL_COMPATIBILITY
@@ -433,6 +487,31 @@ static PFNglMultiTexCoord2f pglMultiTexCoord2f;
 #define GL_TEXTURE1 0x84C1
 #endif
 
+/* 1.5 buffer objects */
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#endif
+#ifndef GL_STREAM_DRAW
+#define GL_STREAM_DRAW 0x88E0
+#endif
+#ifndef GL_STATIC_DRAW
+#define GL_STATIC_DRAW 0x88E4
+#endif
+#ifndef GL_ELEMENT_ARRAY_BUFFER
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#endif
+
+/* GL_ARB_vertex_program */
+#ifndef GL_VERTEX_PROGRAM_ARB
+#define GL_VERTEX_PROGRAM_ARB 0x8620
+#endif
+#ifndef GL_PROGRAM_FORMAT_ASCII_ARB
+#define GL_PROGRAM_FORMAT_ASCII_ARB 0x8875
+#endif
+#ifndef GL_PROGRAM_ERROR_POSITION_ARB
+#define GL_PROGRAM_ERROR_POSITION_ARB 0x864B
+#endif
+
 #endif
 
 #ifdef MINI_GL_COMPATIBILITY
@@ -496,6 +575,13 @@ boolean SetupGLfunc(void)
 	GETOPENGLFUNC(pglColor4fv , glColor4fv)
 	GETOPENGLFUNC(pglTexCoord2f , glTexCoord2f)
 
+	GETOPENGLFUNC(pglEnableClientState , glEnableClientState)
+	GETOPENGLFUNC(pglDisableClientState , glDisableClientState)
+	GETOPENGLFUNC(pglVertexPointer , glVertexPointer)
+	GETOPENGLFUNC(pglTexCoordPointer , glTexCoordPointer)
+	GETOPENGLFUNC(pglNormalPointer , glNormalPointer)
+	GETOPENGLFUNC(pglDrawElements , glDrawElements)
+
 	GETOPENGLFUNC(pglShadeModel , glShadeModel)
 	GETOPENGLFUNC(pglLightfv, glLightfv)
 	GETOPENGLFUNC(pglLightModelfv , glLightModelfv)
@@ -525,6 +611,324 @@ boolean SetupGLfunc(void)
 	return true;
 }
 
+#ifndef MINI_GL_COMPATIBILITY
+// ==========================================================================
+//                                                         MD2 VERTEX BUFFERS
+// ==========================================================================
+
+// MD2 frames are uploaded once into static vertex buffers, and DrawMD2Ex
+// blends two of them in a vertex program instead of lerping every vertex
+// itself. The glcommand strips and fans of a model are flattened into one
+// triangle list over "draw vertices", which are the distinct
+// (texture coordinate, MD2 vertex) pairs the commands use.
+
+#define MD2BUFFER_HASH 64
+
+typedef struct md2framebuffer_s
+{
+	md2_frame_t *frame;
+	GLuint vbo; // position and normal of each draw vertex
+	struct md2framebuffer_s *next;
+} md2framebuffer_t;
+
+typedef struct md2buffer_s
+{
+	INT32 *gl_cmd_buffer; // identifies the model
+	GLuint texcoords; // (s, t) of each draw vertex
+	GLuint indices; // the triangle list
+	GLsizei numindices;
+	GLsizei numdrawverts;
+	INT32 *vertexindex; // MD2 vertex of each draw vertex
+	md2framebuffer_t *frames[MD2BUFFER_HASH];
+	struct md2buffer_s *next;
+} md2buffer_t;
+
+static md2buffer_t *md2buffers[MD2BUFFER_HASH];
+
+#define MD2BUFFER_KEY(ptr) ((((size_t)(ptr)) >> 4) & (MD2BUFFER_HASH-1))
+
+// blends frame A (position, normal) with frame B (attributes 6 and 7) by
+// env[0].w, scales by env[0].xyz, and lights like GL_LIGHT0 would
+static const char md2_program_text[] =
+	"!!ARBvp1.0\n"
+	"ATTRIB posB = vertex.attrib[6];\n"
+	"ATTRIB normB = vertex.attrib[7];\n"
+	"PARAM lerp = program.env[0];\n"
+	"PARAM mvp[4] = { state.matrix.mvp };\n"
+	"PARAM mv[4] = { state.matrix.modelview };\n"
+	"PARAM mvinv[4] = { state.matrix.modelview.invtrans };\n"
+	"PARAM lightdir = state.light[0].position;\n"
+	"PARAM scene = state.lightmodel.front.scenecolor;\n"
+	"PARAM diffuse = state.lightprod[0].front.diffuse;\n"
+	"PARAM material = state.material.front.diffuse;\n"
+	"TEMP pos, norm, eye;\n"
+	"SUB pos, posB, vertex.position;\n"
+	"MAD pos, lerp.w, pos, vertex.position;\n"
+	"MUL pos.xyz, pos, lerp;\n"
+	"DP4 result.position.x, mvp[0], pos;\n"
+	"DP4 result.position.y, mvp[1], pos;\n"
+	"DP4 result.position.z, mvp[2], pos;\n"
+	"DP4 result.position.w, mvp[3], pos;\n"
+	"SUB norm, normB, vertex.normal;\n"
+	"MAD norm, lerp.w, norm, vertex.normal;\n"
+	"DP3 eye.x, mvinv[0], norm;\n"
+	"DP3 eye.y, mvinv[1], norm;\n"
+	"DP3 eye.z, mvinv[2], norm;\n"
+	"DP3 eye.w, eye, lightdir;\n"
+	"MAX eye.w, eye.w, 0.0;\n"
+	"MAD result.color.xyz, eye.w, diffuse, scene;\n"
+	"MOV result.color.w, material.w;\n"
+	"MOV result.texcoord[0], vertex.texcoord[0];\n"
+	"DP4 eye.z, mv[2], pos;\n"
+	"ABS result.fogcoord.x, eye.z;\n"
+	"END\n";
+
+static boolean CompileMD2Program(void)
+{
+	GLint errorpos = -1;
+
+	if (md2_program == (GLuint)-1)
+		return false;
+	if (md2_program)
+		return true;
+
+	pglGenProgramsARB(1, &md2_program);
+	pglBindProgramARB(GL_VERTEX_PROGRAM_ARB, md2_program);
+	pglProgramStringARB(GL_VERTEX_PROGRAM_ARB, GL_PROGRAM_FORMAT_ASCII_ARB,
+		(GLsizei)(sizeof (md2_program_text) - 1), md2_program_text);
+	pglGetIntegerv(GL_PROGRAM_ERROR_POSITION_ARB, &errorpos);
+	pglBindProgramARB(GL_VERTEX_PROGRAM_ARB, 0);
+
+	if (errorpos != -1)
+	{
+		DBG_Printf("MD2 vertex program failed to compile at %d\n", errorpos);
+		md2_program = (GLuint)-1;
+		return false;
+	}
+	return true;
+}
+
+static void FreeMD2Buffers(void)
+{
+	INT32 i, j;
+
+	for (i = 0; i < MD2BUFFER_HASH; i++)
+	{
+		while (md2buffers[i])
+		{
+			md2buffer_t *buf = md2buffers[i];
+			md2buffers[i] = buf->next;
+
+			for (j = 0; j < MD2BUFFER_HASH; j++)
+			{
+				while (buf->frames[j])
+				{
+					md2framebuffer_t *fb = buf->frames[j];
+					buf->frames[j] = fb->next;
+					free(fb);
+				}
+			}
+			free(buf->vertexindex);
+			free(buf);
+		}
+	}
+}
+
+// Flattens the glcommands of a model into draw vertices and triangles
+static md2buffer_t *GetMD2Buffer(INT32 *gl_cmd_buffer)
+{
+	const size_t key = MD2BUFFER_KEY(gl_cmd_buffer);
+	md2buffer_t *buf;
+	INT32 *cmd, val, count, i, maxindex = 0, numcmdverts = 0, numtris = 0, maxcount = 0;
+	INT32 *first, *nextsame, *cmdverts;
+	GLfloat *st;
+	GLuint *indices;
+
+	for (buf = md2buffers[key]; buf; buf = buf->next)
+		if (buf->gl_cmd_buffer == gl_cmd_buffer)
+			return buf;
+
+	// count what the commands hold
+	for (cmd = gl_cmd_buffer; (val = *cmd++) != 0; cmd += count*3)
+	{
+		count = abs(val);
+		for (i = 0; i < count; i++)
+			if (cmd[i*3+2] > maxindex)
+				maxindex = cmd[i*3+2];
+		numcmdverts += count;
+		if (count > 2)
+			numtris += count - 2;
+		if (count > maxcount)
+			maxcount = count;
+	}
+
+	buf = calloc(1, sizeof (*buf));
+	if (!buf)
+		I_Error_GL("GetMD2Buffer: Out of memory");
+	first = malloc((maxindex + 1) * sizeof (*first));
+	nextsame = malloc((numcmdverts + 1) * sizeof (*nextsame));
+	cmdverts = malloc((maxcount + 1) * sizeof (*cmdverts));
+	st = malloc((numcmdverts + 1) * 2 * sizeof (*st));
+	indices = malloc((numtris + 1) * 3 * sizeof (*indices));
+	buf->vertexindex = malloc((numcmdverts + 1) * sizeof (*buf->vertexindex));
+	if (!first || !nextsame || !cmdverts || !st || !indices || !buf->vertexindex)
+		I_Error_GL("GetMD2Buffer: Out of memory");
+
+	for (i = 0; i <= maxindex; i++)
+		first[i] = -1;
+
+	for (cmd = gl_cmd_buffer; (val = *cmd++) != 0; cmd += count*3)
+	{
+		count = abs(val);
+
+		// find or add the draw vertex of each command vertex
+		for (i = 0; i < count; i++)
+		{
+			const INT32 pindex = cmd[i*3+2];
+			INT32 dv;
+
+			// the texcoords are the command's own floats, so compare their bits
+			for (dv = first[pindex]; dv != -1; dv = nextsame[dv])
+				if (!memcmp(&st[dv*2], &cmd[i*3], 2*sizeof (*st)))
+					break;
+
+			if (dv == -1)
+			{
+				dv = buf->numdrawverts++;
+				memcpy(&st[dv*2], &cmd[i*3], 2*sizeof (*st));
+				buf->vertexindex[dv] = pindex;
+				nextsame[dv] = first[pindex];
+				first[pindex] = dv;
+			}
+			cmdverts[i] = dv;
+		}
+
+		// keep the winding GL gives strips and fans
+		for (i = 2; i < count; i++)
+		{
+			if (val < 0)
+			{
+				indices[buf->numindices++] = cmdverts[0];
+				indices[buf->numindices++] = cmdverts[i-1];
+			}
+			else if (i & 1)
+			{
+				indices[buf->numindices++] = cmdverts[i-1];
+				indices[buf->numindices++] = cmdverts[i-2];
+			}
+			else
+			{
+				indices[buf->numindices++] = cmdverts[i-2];
+				indices[buf->numindices++] = cmdverts[i-1];
+			}
+			indices[buf->numindices++] = cmdverts[i];
+		}
+	}
+
+	pglGenBuffers(1, &buf->texcoords);
+	pglBindBuffer(GL_ARRAY_BUFFER, buf->texcoords);
+	pglBufferData(GL_ARRAY_BUFFER, buf->numdrawverts * 2 * sizeof (*st), st, GL_STATIC_DRAW);
+	pglBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	pglGenBuffers(1, &buf->indices);
+	pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buf->indices);
+	pglBufferData(GL_ELEMENT_ARRAY_BUFFER, buf->numindices * sizeof (*indices), indices, GL_STATIC_DRAW);
+	pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	free(first);
+	free(nextsame);
+	free(cmdverts);
+	free(st);
+	free(indices);
+
+	buf->gl_cmd_buffer = gl_cmd_buffer;
+	buf->next = md2buffers[key];
+	md2buffers[key] = buf;
+	return buf;
+}
+
+// Uploads a frame of a model the first time it is drawn
+static GLuint GetMD2FrameBuffer(md2buffer_t *buf, md2_frame_t *frame)
+{
+	const size_t key = MD2BUFFER_KEY(frame);
+	md2framebuffer_t *fb;
+	GLfloat *data;
+	GLsizei i;
+
+	for (fb = buf->frames[key]; fb; fb = fb->next)
+		if (fb->frame == frame)
+			return fb->vbo;
+
+	fb = malloc(sizeof (*fb));
+	data = malloc(buf->numdrawverts * 6 * sizeof (*data));
+	if (!fb || !data)
+		I_Error_GL("GetMD2FrameBuffer: Out of memory");
+
+	for (i = 0; i < buf->numdrawverts; i++)
+	{
+		const md2_triangleVertex_t *v = &frame->vertices[buf->vertexindex[i]];
+		data[i*6  ] = v->vertex[0];
+		data[i*6+1] = v->vertex[1];
+		data[i*6+2] = v->vertex[2];
+		data[i*6+3] = v->normal[0];
+		data[i*6+4] = v->normal[1];
+		data[i*6+5] = v->normal[2];
+	}
+
+	pglGenBuffers(1, &fb->vbo);
+	pglBindBuffer(GL_ARRAY_BUFFER, fb->vbo);
+	pglBufferData(GL_ARRAY_BUFFER, buf->numdrawverts * 6 * sizeof (*data), data, GL_STATIC_DRAW);
+	pglBindBuffer(GL_ARRAY_BUFFER, 0);
+	free(data);
+
+	fb->frame = frame;
+	fb->next = buf->frames[key];
+	buf->frames[key] = fb;
+	return fb->vbo;
+}
+
+// Draws a model from its buffers, blending frame into nextframe by pol
+static void DrawMD2Buffers(INT32 *gl_cmd_buffer, md2_frame_t *frame, md2_frame_t *nextframe, float pol, float scalex, float scaley, float scalez)
+{
+	md2buffer_t *buf = GetMD2Buffer(gl_cmd_buffer);
+	const GLuint vboA = GetMD2FrameBuffer(buf, frame);
+	const GLuint vboB = nextframe ? GetMD2FrameBuffer(buf, nextframe) : vboA;
+
+	pglEnable(GL_VERTEX_PROGRAM_ARB);
+	pglBindProgramARB(GL_VERTEX_PROGRAM_ARB, md2_program);
+	pglProgramEnvParameter4fARB(GL_VERTEX_PROGRAM_ARB, 0, scalex/2.0f, scaley/2.0f, scalez/2.0f, nextframe ? pol : 0.0f);
+
+	pglEnableClientState(GL_VERTEX_ARRAY);
+	pglEnableClientState(GL_NORMAL_ARRAY);
+	pglEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	pglEnableVertexAttribArrayARB(6);
+	pglEnableVertexAttribArrayARB(7);
+
+	pglBindBuffer(GL_ARRAY_BUFFER, buf->texcoords);
+	pglTexCoordPointer(2, GL_FLOAT, 0, NULL);
+	pglBindBuffer(GL_ARRAY_BUFFER, vboA);
+	pglVertexPointer(3, GL_FLOAT, 6 * sizeof (GLfloat), NULL);
+	pglNormalPointer(GL_FLOAT, 6 * sizeof (GLfloat), (const GLvoid *)(3 * sizeof (GLfloat)));
+	pglBindBuffer(GL_ARRAY_BUFFER, vboB);
+	pglVertexAttribPointerARB(6, 3, GL_FLOAT, GL_FALSE, 6 * sizeof (GLfloat), NULL);
+	pglVertexAttribPointerARB(7, 3, GL_FLOAT, GL_FALSE, 6 * sizeof (GLfloat), (const GLvoid *)(3 * sizeof (GLfloat)));
+
+	pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buf->indices);
+	pglDrawElements(GL_TRIANGLES, buf->numindices, GL_UNSIGNED_INT, NULL);
+
+	pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	pglBindBuffer(GL_ARRAY_BUFFER, 0);
+	pglDisableVertexAttribArrayARB(7);
+	pglDisableVertexAttribArrayARB(6);
+	pglDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	pglDisableClientState(GL_NORMAL_ARRAY);
+	pglDisableClientState(GL_VERTEX_ARRAY);
+
+	pglBindProgramARB(GL_VERTEX_PROGRAM_ARB, 0);
+	pglDisable(GL_VERTEX_PROGRAM_ARB);
+}
+#endif
+
 // This has to be done after the context is created so the version number can be obtained
 boolean SetupGLFunc13(void)
 {
@@ -565,6 +969,50 @@ boolean SetupGLFunc13(void)
 	}
 	else
 		DBG_Printf("GL_ARB_multitexture support: disabled\n");
+
+	gl15 = false;
+	batch_vbo = 0; // a new context starts without buffers
+	if (version != NULL && sscanf((const char*)version, "%d.%d", &glmajor, &glminor) == 2
+	 && (glmajor > 1 || glminor >= 5))
+	{
+		pglGenBuffers = GetGLFunc("glGenBuffers");
+		pglBindBuffer = GetGLFunc("glBindBuffer");
+		pglBufferData = GetGLFunc("glBufferData");
+		pglDeleteBuffers = GetGLFunc("glDeleteBuffers");
+	}
+	else if (isExtAvailable("GL_ARB_vertex_buffer_object", gl_extensions))
+	{
+		pglGenBuffers = GetGLFunc("glGenBuffersARB");
+		pglBindBuffer = GetGLFunc("glBindBufferARB");
+		pglBufferData = GetGLFunc("glBufferDataARB");
+		pglDeleteBuffers = GetGLFunc("glDeleteBuffersARB");
+	}
+
+	if (pglGenBuffers && pglBindBuffer && pglBufferData && pglDeleteBuffers)
+	{
+		gl15 = true;
+		DBG_Printf("Vertex buffer object support: enabled\n");
+	}
+	else
+		DBG_Printf("Vertex buffer object support: disabled\n");
+
+	FreeMD2Buffers(); // the new context has none of the old buffers
+	md2_program = 0;
+	glvp = false;
+	if (gl15 && isExtAvailable("GL_ARB_vertex_program", gl_extensions))
+	{
+		pglGenProgramsARB = GetGLFunc("glGenProgramsARB");
+		pglBindProgramARB = GetGLFunc("glBindProgramARB");
+		pglProgramStringARB = GetGLFunc("glProgramStringARB");
+		pglProgramEnvParameter4fARB = GetGLFunc("glProgramEnvParameter4fARB");
+		pglVertexAttribPointerARB = GetGLFunc("glVertexAttribPointerARB");
+		pglEnableVertexAttribArrayARB = GetGLFunc("glEnableVertexAttribArrayARB");
+		pglDisableVertexAttribArrayARB = GetGLFunc("glDisableVertexAttribArrayARB");
+
+		glvp = (pglGenProgramsARB && pglBindProgramARB && pglProgramStringARB && pglProgramEnvParameter4fARB
+			&& pglVertexAttribPointerARB && pglEnableVertexAttribArrayARB && pglDisableVertexAttribArrayARB);
+	}
+	DBG_Printf("GL_ARB_vertex_program support: %s\n", glvp ? "enabled" : "disabled");
 	return true;
 #endif
 }
@@ -874,6 +1322,42 @@ EXPORT void HWRAPI(ClearMipMapCache) (void)
 }
 
 
+// -----------------+
+// DeleteTexture    : Delete one OpenGL texture and take it
+//                  : off the list of downloaded mipmaps
+// -----------------+
+EXPORT void HWRAPI(DeleteTexture) (FTextureInfo *pTexInfo)
+{
+	FTextureInfo *tmp = gr_cachehead, *prev = NULL;
+
+	if (!pTexInfo || !pTexInfo->downloaded)
+		return;
+
+	while (tmp && tmp != pTexInfo)
+	{
+		prev = tmp;
+		tmp = tmp->nextmipmap;
+	}
+
+	if (tmp)
+	{
+		if (prev)
+			prev->nextmipmap = tmp->nextmipmap;
+		else
+			gr_cachehead = tmp->nextmipmap;
+		if (gr_cachetail == tmp)
+			gr_cachetail = prev;
+	}
+
+	if (tex_downloaded == pTexInfo->downloaded)
+		tex_downloaded = 0;
+
+	pglDeleteTextures(1, (GLuint *)&pTexInfo->downloaded);
+	pTexInfo->downloaded = 0;
+	pTexInfo->nextmipmap = NULL;
+}
+
+
 // -----------------+
 // ReadRect         : Read a rectangle region of the truecolor framebuffer
 //                  : store pixels as 16bit 565 RGB
@@ -1595,6 +2079,33 @@ EXPORT void HWRAPI(SetTexture) (FTextureInfo *pTexInfo)
 }
 
 
+// -----------------+
+// SetSurfaceColor  : Mix the surface colour to the texture, for PF_Modulated
+// -----------------+
+static void SetSurfaceColor(FSurfaceInfo *pSurf, GLRGBAFloat *c)
+{
+	if (pal_col)
+	{ // hack for non-palettized mode
+		c->red   = (const_pal_col.red  +byte2float[pSurf->FlatColor.s.red])  /2.0f;
+		c->green = (const_pal_col.green+byte2float[pSurf->FlatColor.s.green])/2.0f;
+		c->blue  = (const_pal_col.blue +byte2float[pSurf->FlatColor.s.blue]) /2.0f;
+		c->alpha = byte2float[pSurf->FlatColor.s.alpha];
+	}
+	else
+	{
+		c->red   = byte2float[pSurf->FlatColor.s.red];
+		c->green = byte2float[pSurf->FlatColor.s.green];
+		c->blue  = byte2float[pSurf->FlatColor.s.blue];
+		c->alpha = byte2float[pSurf->FlatColor.s.alpha];
+	}
+
+#ifdef MINI_GL_COMPATIBILITY
+	pglColor4f(c->red, c->green, c->blue, c->alpha);
+#else
+	pglColor4fv(&c->red);    // is in RGBA float format
+#endif
+}
+
 // -----------------+
 // DrawPolygon      : Render a polygon, set the texture, set render mode
 // -----------------+
@@ -1622,28 +2133,7 @@ EXPORT void HWRAPI(DrawPolygon) (FSurfaceInfo  *pSurf,
 
 	// If Modulated, mix the surface colour to the texture
 	if ((CurrentPolyFlags & PF_Modulated) && pSurf)
-	{
-		if (pal_col)
-		{ // hack for non-palettized mode
-			c.red   = (const_pal_col.red  +byte2float[pSurf->FlatColor.s.red])  /2.0f;
-			c.green = (const_pal_col.green+byte2float[pSurf->FlatColor.s.green])/2.0f;
-			c.blue  = (const_pal_col.blue +byte2float[pSurf->FlatColor.s.blue]) /2.0f;
-			c.alpha = byte2float[pSurf->FlatColor.s.alpha];
-		}
-		else
-		{
-			c.red   = byte2float[pSurf->FlatColor.s.red];
-			c.green = byte2float[pSurf->FlatColor.s.green];
-			c.blue  = byte2float[pSurf->FlatColor.s.blue];
-			c.alpha = byte2float[pSurf->FlatColor.s.alpha];
-		}
-
-#ifdef MINI_GL_COMPATIBILITY
-		pglColor4f(c.red, c.green, c.blue, c.alpha);
-#else
-		pglColor4fv(&c.red);    // is in RGBA float format
-#endif
-	}
+		SetSurfaceColor(pSurf, &c);
 
 	// this test is added for new coronas' code (without depth buffer)
 	// I think I should do a separate function for drawing coronas, so it will be a little faster
@@ -1718,6 +2208,60 @@ EXPORT void HWRAPI(DrawPolygon) (FSurfaceInfo  *pSurf,
 		Clamp2D(GL_TEXTURE_WRAP_T);
 }
 
+// -----------------+
+// DrawIndexedTriangles : Render a batch of triangles that share the current
+//                      : texture, one surface colour and one render mode
+// -----------------+
+EXPORT void HWRAPI(DrawIndexedTriangles) (FSurfaceInfo *pSurf, FOutVector *pOutVerts, FUINT iNumPts, FBITFIELD PolyFlags, UINT32 *IndexArray, FUINT iNumIndices)
+{
+	GLRGBAFloat c = {0,0,0,0};
+
+	SetBlend(PolyFlags);
+
+	if ((CurrentPolyFlags & PF_Modulated) && pSurf)
+		SetSurfaceColor(pSurf, &c);
+
+#ifdef MINI_GL_COMPATIBILITY
+	{
+		FUINT i;
+		(void)iNumPts;
+		pglBegin(GL_TRIANGLES);
+		for (i = 0; i < iNumIndices; i++)
+		{
+			pglTexCoord2f(pOutVerts[IndexArray[i]].sow, pOutVerts[IndexArray[i]].tow);
+			pglVertex3f(pOutVerts[IndexArray[i]].x, pOutVerts[IndexArray[i]].y, pOutVerts[IndexArray[i]].z);
+		}
+		pglEnd();
+	}
+#else
+	pglEnableClientState(GL_VERTEX_ARRAY);
+	pglEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+	if (gl15)
+	{
+		if (!batch_vbo)
+			pglGenBuffers(1, &batch_vbo);
+		pglBindBuffer(GL_ARRAY_BUFFER, batch_vbo);
+		pglBufferData(GL_ARRAY_BUFFER, iNumPts * sizeof (FOutVector), pOutVerts, GL_STREAM_DRAW);
+		pglVertexPointer(3, GL_FLOAT, sizeof (FOutVector), (const GLvoid *)offsetof(FOutVector, x));
+		pglTexCoordPointer(2, GL_FLOAT, sizeof (FOutVector), (const GLvoid *)offsetof(FOutVector, sow));
+	}
+	else
+	{
+		pglVertexPointer(3, GL_FLOAT, sizeof (FOutVector), &pOutVerts[0].x);
+		pglTexCoordPointer(2, GL_FLOAT, sizeof (FOutVector), &pOutVerts[0].sow);
+	}
+
+	pglDrawElements(GL_TRIANGLES, iNumIndices, GL_UNSIGNED_INT, IndexArray);
+
+	if (gl15)
+		pglBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	pglDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	pglDisableClientState(GL_VERTEX_ARRAY);
+#endif
+}
+
 
 // ==========================================================================
 //
@@ -1964,67 +2508,76 @@ static  void DrawMD2Ex(INT32 *gl_cmd_buffer, md2_frame_t *frame, INT32 duration,
 	pglRotatef(pos->angley, 0.0f, -1.0f, 0.0f);
 	pglRotatef(pos->anglex, -1.0f, 0.0f, 0.0f);
 
-	val = *gl_cmd_buffer++;
-
-	while (val != 0)
+#ifndef MINI_GL_COMPATIBILITY
+	// the vertex program replaces fixed function lighting, so it only
+	// covers the lit models
+	if (glvp && color && CompileMD2Program())
+		DrawMD2Buffers(gl_cmd_buffer, frame, nextframe, pol, scalex, scaley, scalez);
+	else
+#endif
 	{
-		if (val < 0)
-		{
-			pglBegin(GL_TRIANGLE_FAN);
-			count = -val;
-		}
-		else
-		{
-			pglBegin(GL_TRIANGLE_STRIP);
-			count = val;
-		}
+		val = *gl_cmd_buffer++;
 
-		while (count--)
+		while (val != 0)
 		{
-			s = *(float *) gl_cmd_buffer++;
-			t = *(float *) gl_cmd_buffer++;
-			pindex = *gl_cmd_buffer++;
-
-			pglTexCoord2f(s, t);
-
-			if (!nextframe || fpclassify(pol) == FP_ZERO)
+			if (val < 0)
 			{
-				pglNormal3f(frame->vertices[pindex].normal[0],
-				            frame->vertices[pindex].normal[1],
-				            frame->vertices[pindex].normal[2]);
-
-				pglVertex3f(frame->vertices[pindex].vertex[0]*scalex/2.0f,
-				            frame->vertices[pindex].vertex[1]*scaley/2.0f,
-				            frame->vertices[pindex].vertex[2]*scalez/2.0f);
+				pglBegin(GL_TRIANGLE_FAN);
+				count = -val;
 			}
 			else
 			{
-				// Interpolate
-				float px1 = frame->vertices[pindex].vertex[0]*scalex/2.0f;
-				float px2 = nextframe->vertices[pindex].vertex[0]*scalex/2.0f;
-				float py1 = frame->vertices[pindex].vertex[1]*scaley/2.0f;
-				float py2 = nextframe->vertices[pindex].vertex[1]*scaley/2.0f;
-				float pz1 = frame->vertices[pindex].vertex[2]*scalez/2.0f;
-				float pz2 = nextframe->vertices[pindex].vertex[2]*scalez/2.0f;
-				float nx1 = frame->vertices[pindex].normal[0];
-				float nx2 = nextframe->vertices[pindex].normal[0];
-				float ny1 = frame->vertices[pindex].normal[1];
-				float ny2 = nextframe->vertices[pindex].normal[1];
-				float nz1 = frame->vertices[pindex].normal[2];
-				float nz2 = nextframe->vertices[pindex].normal[2];
-
-				pglNormal3f((nx1 + pol * (nx2 - nx1)),
-				            (ny1 + pol * (ny2 - ny1)),
-				            (nz1 + pol * (nz2 - nz1)));
-				pglVertex3f((px1 + pol * (px2 - px1)),
-				            (py1 + pol * (py2 - py1)),
-				            (pz1 + pol * (pz2 - pz1)));
+				pglBegin(GL_TRIANGLE_STRIP);
+				count = val;
 			}
-		}
 
-		pglEnd();
+			while (count--)
+			{
+				s = *(float *) gl_cmd_buffer++;
+				t = *(float *) gl_cmd_buffer++;
+				pindex = *gl_cmd_buffer++;
 
-		val = *gl_cmd_buffer++;
+				pglTexCoord2f(s, t);
+
+				if (!nextframe || fpclassify(pol) == FP_ZERO)
+				{
+					pglNormal3f(frame->vertices[pindex].normal[0],
+					            frame->vertices[pindex].normal[1],
+					            frame->vertices[pindex].normal[2]);
+
+					pglVertex3f(frame->vertices[pindex].vertex[0]*scalex/2.0f,
+					            frame->vertices[pindex].vertex[1]*scaley/2.0f,
+					            frame->vertices[pindex].vertex[2]*scalez/2.0f);
+				}
+				else
+				{
+					// Interpolate
+					float px1 = frame->vertices[pindex].vertex[0]*scalex/2.0f;
+					float px2 = nextframe->vertices[pindex].vertex[0]*scalex/2.0f;
+					float py1 = frame->vertices[pindex].vertex[1]*scaley/2.0f;
+					float py2 = nextframe->vertices[pindex].vertex[1]*scaley/2.0f;
+					float pz1 = frame->vertices[pindex].vertex[2]*scalez/2.0f;
+					float pz2 = nextframe->vertices[pindex].vertex[2]*scalez/2.0f;
+					float nx1 = frame->vertices[pindex].normal[0];
+					float nx2 = nextframe->vertices[pindex].normal[0];
+					float ny1 = frame->vertices[pindex].normal[1];
+					float ny2 = nextframe->vertices[pindex].normal[1];
+					float nz1 = frame->vertices[pindex].normal[2];
+					float nz2 = nextframe->vertices[pindex].normal[2];
+
+					pglNormal3f((nx1 + pol * (nx2 - nx1)),
+					            (ny1 + pol * (ny2 - ny1)),
+					            (nz1 + pol * (nz2 - nz1)));
+					pglVertex3f((px1 + pol * (px2 - px1)),
+					            (py1 + pol * (py2 - py1)),
+					            (pz1 + pol * (pz2 - pz1)));
+				}
+			}
+
+			pglEnd();
+
+			val = *gl_cmd_buffer++;
+		}
 	}
 	pglPopMatrix(); // should be the same as glLoadIdentity
 	if (color)
@@ -46,6 +46,12 @@ UINT32 I_GetFreeMem(UINT32 *total);
 */
 tic_t I_GetTime(void);
 
+/**	\brief	Returns a free-running timestamp in microseconds, for measuring
+	frame and tic costs. Only differences between two calls are meaningful;
+	the value wraps around roughly every 71 minutes.
+*/
+UINT32 I_GetTimeMicros(void);
+
 /**	\brief	The I_Sleep function
 
 	\return	void
@@ -33,45 +33,63 @@ typedef UINT8 (*blockmap_func)(lua_State *, INT32, INT32, mobj_t *);
 static boolean blockfuncerror = false; // errors should only print once per search blockmap call
 
 // Helper function for "objects" search
+// Calls the search function on one object
+// returns -1 to carry on, otherwise what lib_searchBlockmap_Objects should return
+static INT32 lib_searchBlockmap_Object(lua_State *L, mobj_t *thing, mobj_t *mobj)
+{
+	lua_pushvalue(L, 1); // push function
+	LUA_PushUserdata(L, thing, META_MOBJ);
+	LUA_PushUserdata(L, mobj, META_MOBJ);
+	if (lua_pcall(gL, 2, 1, 0)) {
+		if (!blockfuncerror || cv_debug & DBG_LUA)
+			CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
+		lua_pop(gL, 1);
+		blockfuncerror = true;
+		return 0; // *shrugs*
+	}
+	if (!lua_isnil(gL, -1))
+	{ // if nil, continue
+		if (lua_toboolean(gL, -1))
+			return 2; // stop whole search
+		else
+			return 1; // stop block search
+	}
+	lua_pop(gL, 1);
+	return -1;
+}
+
 static UINT8 lib_searchBlockmap_Objects(lua_State *L, INT32 x, INT32 y, mobj_t *thing)
 {
-	mobj_t *mobj, *bnext = NULL;
+	blockthings_t *cell;
+	mobj_t *mobj;
+	INT32 ret = 0;
+	size_t i;
 
 	if (x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight)
 		return 0;
 
+	cell = &blockthings[y*bmapwidth + x];
+	P_BeginBlockThings(cell);
+
 	// Check interaction with the objects in the blockmap.
-	for (mobj = blocklinks[y*bmapwidth + x]; mobj; mobj = bnext)
+	// Same walk as P_BlockThingsIterator.
+	for (i = cell->count; i > 0;)
 	{
-		P_SetTarget(&bnext, mobj->bnext); // We want to note our reference to bnext here incase it is MF_NOTHINK and gets removed!
-		if (mobj == thing)
-			continue; // our thing just found itself, so move on
-		lua_pushvalue(L, 1); // push function
-		LUA_PushUserdata(L, thing, META_MOBJ);
-		LUA_PushUserdata(L, mobj, META_MOBJ);
-		if (lua_pcall(gL, 2, 1, 0)) {
-			if (!blockfuncerror || cv_debug & DBG_LUA)
-				CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
-			lua_pop(gL, 1);
-			blockfuncerror = true;
-			return 0; // *shrugs*
-		}
-		if (!lua_isnil(gL, -1))
-		{ // if nil, continue
-			if (lua_toboolean(gL, -1))
-				return 2; // stop whole search
-			else
-				return 1; // stop block search
-		}
-		lua_pop(gL, 1);
-		if (P_MobjWasRemoved(thing) // func just popped our thing, cannot continue.
-		|| (bnext && P_MobjWasRemoved(bnext))) // func just broke blockmap chain, cannot continue.
+		mobj = cell->things[--i];
+		if (!mobj || mobj == thing)
+			continue; // left the cell, or our thing just found itself, so move on
+		if ((ret = lib_searchBlockmap_Object(L, thing, mobj)) >= 0)
+			break;
+		ret = 0;
+		if (P_MobjWasRemoved(thing)) // func just popped our thing, cannot continue.
 		{
-			P_SetTarget(&bnext, NULL);
-			return (P_MobjWasRemoved(thing)) ? 2 : 1;
+			ret = 2;
+			break;
 		}
 	}
-	return 0;
+
+	P_EndBlockThings(cell);
+	return (UINT8)ret;
 }
 
 // Helper function for "lines" search
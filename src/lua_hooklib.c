@@ -281,6 +281,25 @@ boolean LUAh_MobjHook(mobj_t *mo, enum hook which)
 	return hooked;
 }
 
+// Does any hook of this kind apply to this mobj type?
+// Doesn't call anything, so it's cheap enough to ask every tic.
+boolean LUAh_MobjHookExists(mobjtype_t type, enum hook which)
+{
+	hook_p hookp;
+	if (!gL || !(hooksAvailable[which/8] & (1<<(which%8))))
+		return false;
+
+	for (hookp = mobjhooks[MT_NULL]; hookp; hookp = hookp->next)
+		if (hookp->type == which)
+			return true;
+
+	for (hookp = mobjhooks[type]; hookp; hookp = hookp->next)
+		if (hookp->type == which)
+			return true;
+
+	return false;
+}
+
 boolean LUAh_PlayerHook(player_t *plr, enum hook which)
 {
 	hook_p hookp;
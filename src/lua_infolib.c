@@ -24,6 +24,7 @@
 #include "lua_hud.h" // hud_running errors
 
 boolean LUA_CallAction(const char *action, mobj_t *actor);
+boolean LUA_HasAction(const char *action);
 state_t *astate;
 
 enum sfxinfo_read {
@@ -321,6 +322,28 @@ boolean LUA_CallAction(const char *csaction, mobj_t *actor)
 	return true; // action successfully called.
 }
 
+// Has Lua replaced this action? Used by code that wants to skip calling
+// an action without losing a Lua override of it.
+boolean LUA_HasAction(const char *csaction)
+{
+	boolean found;
+	I_Assert(csaction != NULL);
+
+	if (!gL) // Lua isn't loaded,
+		return false; // so nothing's replaced.
+
+	lua_getfield(gL, LUA_REGISTRYINDEX, LREG_ACTIONS);
+	{
+		char *action = Z_StrDup(csaction);
+		strupr(action);
+		lua_getfield(gL, -1, action);
+		Z_Free(action);
+	}
+	found = !lua_isnil(gL, -1);
+	lua_pop(gL, 2); // pop function/nil and LREG_ACTIONS
+	return found;
+}
+
 // state_t *, field -> number
 static int state_get(lua_State *L)
 {
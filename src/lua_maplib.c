@@ -1232,7 +1232,10 @@ static int ffloor_set(lua_State *L)
 		ffloortype_e oldflags = ffloor->flags; // store FOF's old flags
 		ffloor->flags = luaL_checkinteger(L, 3);
 		if (ffloor->flags != oldflags)
+		{
 			ffloor->target->moved = true; // reset target sector's lightlist
+			P_ClearSightCache(); // may have started or stopped blocking sight
+		}
 		break;
 	}
 	case ffloor_alpha:
@@ -388,6 +388,9 @@ static int mobj_set(lua_State *L)
 	if (hud_running)
 		return luaL_error(L, "Do not alter mobj_t in HUD rendering code!");
 
+	// Whatever's being changed, the full thinker should see it.
+	P_WakeMobj(mo);
+
 	switch(field)
 	{
 	case mobj_valid:
@@ -502,7 +505,7 @@ static int mobj_set(lua_State *L)
 		break;
 	}
 	case mobj_flags2:
-		mo->flags2 = (UINT32)luaL_checkinteger(L, 3);
+		mo->flags2 = (UINT32)luaL_checkinteger(L, 3) & ~MF2_DORMANT; // only the thinker decides that
 		break;
 	case mobj_eflags:
 		mo->eflags = (UINT32)luaL_checkinteger(L, 3);
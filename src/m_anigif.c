@@ -31,6 +31,8 @@ static boolean gif_downscale = false; // like changing cvars mid output
 
 static FILE *gif_out = NULL;
 static INT32 gif_frames = 0;
+static tic_t gif_tics = 0; // running length, for frame delays
+static UINT8 *gif_lastframe = NULL; // for GIF_optimizeregion
 static UINT8 gif_writeover = 0;
 
 
@@ -244,13 +246,24 @@ static void GIF_prepareLZW(void)
 	memset(giflzw_hashTable, 0, 16384*sizeof(UINT32));
 }
 
+//
+// GIF_hashPosition
+// spreads keys over the hash table
+// (the code's low bits and the byte both have to count, or
+// every byte following the same code ends up in one long chain)
+//
+static inline UINT32 GIF_hashPosition(UINT32 key)
+{
+	return (key * 2654435761u) >> 18; // top 14 bits
+}
+
 //
 // GIF_searchHash
 // searches the LZW hash table for a match
 //
 static char GIF_searchHash(UINT32 key, UINT32 *pOutput)
 {
-	UINT32 entry, position = (key >> 6) & 0x3FFF;
+	UINT32 entry, position = GIF_hashPosition(key);
 
 	while (giflzw_hashTable[position] != 0)
 	{
@@ -273,7 +286,7 @@ static char GIF_searchHash(UINT32 key, UINT32 *pOutput)
 //
 static void GIF_addHash(UINT32 key, UINT32 value)
 {
-	UINT32 position = (key >> 6) & 0x3FFF;
+	UINT32 position = GIF_hashPosition(key);
 
 	for (;;)
 	{
@@ -456,10 +469,10 @@ static size_t gifframe_size = 8192;
 // GIF_framewrite
 // writes a frame into the file.
 //
-static void GIF_framewrite(void)
+static void GIF_framewrite(UINT8 *screen, tic_t tics)
 {
 	UINT8 *p;
-	UINT8 *movie_screen = screens[2];
+	UINT8 *movie_screen = gif_lastframe;
 	INT32 blitx, blity, blitw, blith;
 
 	if (!gifframe_data)
@@ -472,12 +485,11 @@ static void GIF_framewrite(void)
 	// Compare image data (for optimizing GIF)
 	if (gif_optimize && gif_frames > 0)
 	{
-		// before blit movie_screen points to last frame, cur_screen points to this frame
-		UINT8 *cur_screen = screens[0];
-		GIF_optimizeregion(cur_screen, movie_screen, &blitx, &blity, &blitw, &blith);
+		// before blit movie_screen points to last frame, screen points to this frame
+		GIF_optimizeregion(screen, movie_screen, &blitx, &blity, &blitw, &blith);
 
 		// blit to temp screen
-		I_ReadScreen(movie_screen);
+		M_Memcpy(movie_screen, screen, vid.width * vid.height);
 	}
 	else
 	{
@@ -485,15 +497,15 @@ static void GIF_framewrite(void)
 		blitw = vid.width;
 		blith = vid.height;
 
-		if (gif_frames == 0)
-			I_ReadScreen(movie_screen);
-		movie_screen = screens[0];
+		if (gif_frames == 0 && gif_optimize)
+			M_Memcpy(movie_screen, screen, vid.width * vid.height);
+		movie_screen = screen;
 	}
 
 	// screen regions are handled in GIF_lzw
 	{
-		int d1 = (int)((100.0f/NEWTICRATE)*(gif_frames+1));
-		int d2 = (int)((100.0f/NEWTICRATE)*(gif_frames));
+		int d1 = (int)((100.0f/NEWTICRATE)*(gif_tics+tics));
+		int d2 = (int)((100.0f/NEWTICRATE)*(gif_tics));
 		UINT16 delay = d1-d2;
 		INT32 startline;
 
@@ -561,6 +573,7 @@ static void GIF_framewrite(void)
 	}
 	fwrite(gifframe_data, 1, (p - gifframe_data), gif_out);
 	++gif_frames;
+	gif_tics += tics;
 }
 
 
@@ -589,19 +602,23 @@ INT32 GIF_open(const char *filename)
 
 	gif_optimize = (!!cv_gif_optimize.value);
 	gif_downscale = (!!cv_gif_downscale.value);
+	if (gif_optimize)
+		gif_lastframe = Z_Malloc(vid.width * vid.height, PU_STATIC, NULL);
 	GIF_headwrite();
 	gif_frames = 0;
+	gif_tics = 0;
 	return 1;
 }
 
 //
 // GIF_frame
 // writes a frame into the output gif
+// screen is a linear copy of the screen, shown for tics tics
 //
-void GIF_frame(void)
+void GIF_frame(UINT8 *screen, tic_t tics)
 {
 	// there's not much actually needed here, is there.
-	GIF_framewrite();
+	GIF_framewrite(screen, tics);
 }
 
 //
@@ -630,6 +647,10 @@ INT32 GIF_close(void)
 		Z_Free(giflzw_hashTable);
 	giflzw_hashTable = NULL;
 
+	if (gif_lastframe)
+		Z_Free(gif_lastframe);
+	gif_lastframe = NULL;
+
 	CONS_Printf(M_GetText("Animated gif closed; wrote %d frames\n"), gif_frames);
 	return 1;
 }
@@ -23,7 +23,7 @@
 
 #ifdef HAVE_ANIGIF
 INT32 GIF_open(const char *filename);
-void GIF_frame(void);
+void GIF_frame(UINT8 *screen, tic_t tics);
 INT32 GIF_close(void);
 #endif
 
@@ -892,13 +892,13 @@ static inline boolean M_PNGLib(void)
 #endif
 }
 
-static void M_PNGFrame(png_structp png_ptr, png_infop png_info_ptr, png_bytep png_buf)
+static void M_PNGFrame(png_structp png_ptr, png_infop png_info_ptr, png_bytep png_buf, tic_t tics)
 {
 	png_uint_32 pitch = png_get_rowbytes(png_ptr, png_info_ptr);
 	PNG_CONST png_uint_32 height = vid.height;
 	png_bytepp row_pointers = png_malloc(png_ptr, height* sizeof (png_bytep));
 	png_uint_32 y;
-	png_uint_16 framedelay = (png_uint_16)cv_apng_delay.value;
+	png_uint_16 framedelay = (png_uint_16)(cv_apng_delay.value * tics);
 
 	apng_frames++;
 
@@ -1046,6 +1046,98 @@ static boolean M_SetupaPNG(png_const_charp filename, png_bytep pal)
 //                             MOVIE MODE
 // ==========================================================================
 #if NUMSCREENS > 2
+// Captured GIF and aPNG frames wait here until the main loop has time to
+// spare, so compressing one frame doesn't hold up drawing the next.
+#define MOVIEQUEUESIZE 8
+
+typedef struct
+{
+	UINT8 *data;        // frame to encode
+	UINT8 *buffer;      // software renderer copy of the screen
+	size_t buffersize;
+	INT32 width, height;
+	tic_t tics;         // how long the frame stays up
+} movieframe_t;
+
+static movieframe_t moviequeue[MOVIEQUEUESIZE];
+static INT32 moviequeuehead = 0, moviequeuecount = 0;
+static UINT32 moviedropped = 0; // frames skipped while the encoder caught up
+
+//
+// M_QueueMovieFrame
+// Copies the screen into the queue. If the encoder is too far behind,
+// the newest frame waiting is shown a tic longer instead.
+//
+static void M_QueueMovieFrame(void)
+{
+	movieframe_t *frame;
+
+	if (moviequeuecount == MOVIEQUEUESIZE)
+	{
+		// Nobody's waiting on the clock in singletics, so just catch up
+		if (singletics)
+			M_EncodeMovieFrame();
+		else
+		{
+			if (!moviedropped)
+				CONS_Alert(CONS_WARNING, M_GetText("Movie encoding can't keep up, dropping frames\n"));
+			moviequeue[(moviequeuehead + moviequeuecount - 1) % MOVIEQUEUESIZE].tics++;
+			moviedropped++;
+			return;
+		}
+	}
+
+	frame = &moviequeue[(moviequeuehead + moviequeuecount) % MOVIEQUEUESIZE];
+	frame->width = vid.width;
+	frame->height = vid.height;
+	frame->tics = 1;
+
+	if (rendermode == render_soft)
+	{
+		const size_t size = (size_t)vid.width * vid.height;
+
+		if (frame->buffersize != size)
+		{
+			if (frame->buffer)
+				Z_Free(frame->buffer);
+			frame->buffer = Z_Malloc(size, PU_STATIC, NULL);
+			frame->buffersize = size;
+		}
+
+		// munge planar buffer to linear
+		I_ReadScreen(frame->buffer);
+		frame->data = frame->buffer;
+	}
+#ifdef HWRENDER
+	else
+		frame->data = HWR_GetScreenshot();
+#endif
+
+	if (frame->data)
+		moviequeuecount++;
+}
+
+//
+// M_FreeMovieQueue
+// Throws out anything left in the queue along with its buffers.
+//
+static void M_FreeMovieQueue(void)
+{
+	INT32 i;
+
+	for (i = 0; i < MOVIEQUEUESIZE; i++)
+	{
+		movieframe_t *frame = &moviequeue[i];
+
+		if (frame->data && frame->data != frame->buffer)
+			free(frame->data);
+		if (frame->buffer)
+			Z_Free(frame->buffer);
+		memset(frame, 0, sizeof (*frame));
+	}
+	moviequeuehead = moviequeuecount = 0;
+}
+
 static inline moviemode_t M_StartMovieAPNG(const char *pathname)
 {
 #ifdef USE_APNG
@@ -1148,6 +1240,8 @@ void M_StartMovie(void)
 			return;
 	}
 
+	moviedropped = 0;
+
 	if (moviemode == MM_APNG)
 		CONS_Printf(M_GetText("Movie mode enabled (%s).\n"), "aPNG");
 	else if (moviemode == MM_GIF)
@@ -1176,40 +1270,16 @@ void M_SaveFrame(void)
 			takescreenshot = true;
 			return;
 		case MM_GIF:
-			GIF_frame();
+			M_QueueMovieFrame();
 			return;
 		case MM_APNG:
 #ifdef USE_APNG
+			if (!apng_FILE) // should not happen!!
 			{
-				UINT8 *linear = NULL;
-				if (!apng_FILE) // should not happen!!
-				{
-					moviemode = MM_OFF;
-					return;
-				}
-
-				if (rendermode == render_soft)
-				{
-					// munge planar buffer to linear
-					linear = screens[2];
-					I_ReadScreen(linear);
-				}
-#ifdef HWRENDER
-				else
-					linear = HWR_GetScreenshot();
-#endif
-				M_PNGFrame(apng_ptr, apng_info_ptr, (png_bytep)linear);
-#ifdef HWRENDER
-				if (rendermode != render_soft && linear)
-					free(linear);
-#endif
-
-				if (apng_frames == PNG_UINT_31_MAX)
-				{
-					CONS_Alert(CONS_NOTICE, M_GetText("Max movie size reached\n"));
-					M_StopMovie();
-				}
+				moviemode = MM_OFF;
+				return;
 			}
+			M_QueueMovieFrame();
 #else
 			moviemode = MM_OFF;
 #endif
@@ -1220,9 +1290,67 @@ void M_SaveFrame(void)
 #endif
 }
 
+/** Encodes the oldest frame waiting in the movie queue.
+  * Called whenever the main loop would otherwise sleep.
+  *
+  * \return false if there was nothing to encode.
+  */
+boolean M_EncodeMovieFrame(void)
+{
+#if NUMSCREENS > 2
+	movieframe_t *frame;
+
+	if (!moviequeuecount)
+		return false;
+
+	frame = &moviequeue[moviequeuehead];
+	moviequeuehead = (moviequeuehead + 1) % MOVIEQUEUESIZE;
+	moviequeuecount--;
+
+	// Both formats are fixed to the size the movie started at
+	if (frame->width != vid.width || frame->height != vid.height)
+		moviedropped++;
+	else switch (moviemode)
+	{
+#ifdef HAVE_ANIGIF
+		case MM_GIF:
+			GIF_frame(frame->data, frame->tics);
+			break;
+#endif
+#ifdef USE_APNG
+		case MM_APNG:
+			M_PNGFrame(apng_ptr, apng_info_ptr, (png_bytep)frame->data, frame->tics);
+			if (apng_frames == PNG_UINT_31_MAX)
+			{
+				CONS_Alert(CONS_NOTICE, M_GetText("Max movie size reached\n"));
+				M_StopMovie();
+			}
+			break;
+#endif
+		default:
+			break;
+	}
+
+	if (frame->data != frame->buffer)
+		free(frame->data);
+	frame->data = NULL;
+	return true;
+#else
+	return false;
+#endif
+}
+
 void M_StopMovie(void)
 {
 #if NUMSCREENS > 2
+	// Finish off whatever's still waiting to be encoded
+	if (moviemode == MM_GIF || moviemode == MM_APNG)
+	{
+		while (moviequeuecount && M_EncodeMovieFrame())
+			;
+		M_FreeMovieQueue();
+	}
+
 	switch (moviemode)
 	{
 		case MM_GIF:
@@ -1256,6 +1384,8 @@ void M_StopMovie(void)
 			return;
 	}
 	moviemode = MM_OFF;
+	if (moviedropped)
+		CONS_Printf(M_GetText("%u frames were dropped while encoding.\n"), moviedropped);
 	CONS_Printf(M_GetText("Movie mode disabled.\n"));
 #endif
 }
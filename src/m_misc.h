@@ -37,6 +37,7 @@ extern consvar_t cv_apng_delay;
 
 void M_StartMovie(void);
 void M_SaveFrame(void);
+boolean M_EncodeMovieFrame(void);
 void M_StopMovie(void);
 
 // the file where game vars and settings are saved
@@ -24,6 +24,11 @@ tic_t I_GetTime(void)
 	return ticcount;
 }
 
+UINT32 I_GetTimeMicros(void)
+{
+	return ticcount*(1000000/TICRATE);
+}
+
 void I_Sleep(void){}
 
 void I_GetEvent(void)
@@ -3018,6 +3018,7 @@ void EV_CrumbleChain(sector_t *sec, ffloor_t *rover)
 	rover->flags &= ~FF_EXISTS;
 	rover->master->frontsector->moved = true;
 	sec->moved = true;
+	P_ClearSightCache();
 }
 
 // Used for bobbing platforms on the water
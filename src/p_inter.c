@@ -1939,6 +1939,8 @@ void P_KillMobj(mobj_t *target, mobj_t *inflictor, mobj_t *source)
 	mobjtype_t item;
 	mobj_t *mo;
 
+	P_MobjConsistancyChanged(target);
+
 	if (inflictor && (inflictor->type == MT_SHELL || inflictor->type == MT_FIREBALL))
 		P_SetTarget(&target->tracer, inflictor);
 
@@ -2826,6 +2828,8 @@ boolean P_DamageMobj(mobj_t *target, mobj_t *inflictor, mobj_t *source, INT32 da
 	if (target->health <= 0)
 		return false;
 
+	P_MobjConsistancyChanged(target);
+
 	// Spectator handling
 	if (netgame)
 	{
@@ -469,6 +469,8 @@ static boolean PIT_CheckThing(mobj_t *thing)
 	if (abs(thing->x - tmx) >= blockdist || abs(thing->y - tmy) >= blockdist)
 		return true; // didn't hit it
 
+	P_WakeMobj(thing); // something's touching it, so let it react
+
 #ifdef HAVE_BLUA
 	{
 		UINT8 shouldCollide = LUAh_MobjCollide(thing, tmthing); // checks hook for thing's type
@@ -3221,6 +3223,10 @@ void P_RadiusAttack(mobj_t *spot, mobj_t *source, fixed_t damagedist)
 static boolean crushchange;
 static boolean nofit;
 
+// Bumped whenever a sector's thing list is linked, unlinked or has its
+// visited marks reset, so P_CheckSectorThings knows when to start over.
+static UINT32 thinglistchanges = 0;
+
 //
 // PIT_ChangeSector
 //
@@ -3228,6 +3234,9 @@ static boolean PIT_ChangeSector(mobj_t *thing, boolean realcrush)
 {
 	mobj_t *killer = NULL;
 
+	// The floor or ceiling under it moved, so it has something to think about.
+	P_WakeMobj(thing);
+
 	if (P_ThingHeightClip(thing))
 	{
 		//thing fits, check next thing
@@ -3339,6 +3348,43 @@ static boolean PIT_ChangeSector(mobj_t *thing, boolean realcrush)
 	return true;
 }
 
+//
+// P_CheckSectorThings
+//
+// Runs the non-crushing PIT_ChangeSector on every unvisited thing in the
+// sector, in the same order as killough's restart-from-the-head loop but
+// without rescanning the visited ones each time. Only when something
+// actually changes the list do we go back to the head like that loop did.
+//
+static boolean P_CheckSectorThings(sector_t *sec)
+{
+	msecnode_t *n = sec->touching_thinglist;
+
+	while (n)
+	{
+		if (!n->visited)
+		{
+			n->visited = true; // mark thing as processed
+			if (!(n->m_thing->flags & MF_NOBLOCKMAP)) //jff 4/7/98 don't do these
+			{
+				const UINT32 changes = thinglistchanges;
+
+				if (!PIT_ChangeSector(n->m_thing, false)) // process it
+					return false;
+
+				if (thinglistchanges != changes)
+				{
+					n = sec->touching_thinglist; // start over
+					continue;
+				}
+			}
+		}
+		n = n->m_thinglist_next;
+	}
+
+	return true;
+}
+
 //
 // P_CheckSector
 //
@@ -3348,6 +3394,8 @@ boolean P_CheckSector(sector_t *sector, boolean crunch)
 
 	nofit = false;
 	crushchange = crunch;
+	thinglistchanges++; // a caller further up may be walking one of these lists
+	P_ClearSightCache(); // the sector's floor or ceiling has moved
 
 	// killough 4/4/98: scan list front-to-back until empty or exhausted,
 	// restarting from beginning after each thing is processed. Avoids
@@ -3376,23 +3424,11 @@ boolean P_CheckSector(sector_t *sector, boolean crunch)
 			if (!sector->attachedsolid[i])
 				continue;
 
-			do
+			if (!P_CheckSectorThings(sec))
 			{
-				for (n = sec->touching_thinglist; n; n = n->m_thinglist_next)
-				if (!n->visited)
-				{
-					n->visited = true;
-					if (!(n->m_thing->flags & MF_NOBLOCKMAP))
-					{
-						if (!PIT_ChangeSector(n->m_thing, false))
-						{
-							nofit = true;
-							return nofit;
-						}
-					}
-					break;
-				}
-			} while (n);
+				nofit = true;
+				return nofit;
+			}
 		}
 	}
 
@@ -3402,23 +3438,11 @@ boolean P_CheckSector(sector_t *sector, boolean crunch)
 	for (n = sector->touching_thinglist; n; n = n->m_thinglist_next)
 		n->visited = false;
 
-	do
+	if (!P_CheckSectorThings(sector))
 	{
-		for (n = sector->touching_thinglist; n; n = n->m_thinglist_next) // go through list
-			if (!n->visited) // unprocessed thing found
-			{
-				n->visited = true; // mark thing as processed
-				if (!(n->m_thing->flags & MF_NOBLOCKMAP)) //jff 4/7/98 don't do these
-				{
-					if (!PIT_ChangeSector(n->m_thing, false)) // process it
-					{
-						nofit = true;
-						return nofit;
-					}
-				}
-				break; // exit and start over
-			}
-	} while (n); // repeat from scratch until all things left are marked valid
+		nofit = true;
+		return nofit;
+	}
 
 	// Nothing blocked us, so lets crush for real!
 	if (sector->numattached)
@@ -3433,7 +3457,7 @@ boolean P_CheckSector(sector_t *sector, boolean crunch)
 
 			sec->moved = true;
 
-			P_RecalcPrecipInSector(sec);
+			// Precipitation was already moved by the first pass
 
 			if (!sector->attachedsolid[i])
 				continue;
@@ -3563,6 +3587,7 @@ static msecnode_t *P_AddSecnode(sector_t *s, mobj_t *thing, msecnode_t *nextnode
 	// of the list.
 
 	node = P_GetSecnode();
+	thinglistchanges++;
 
 	// mark new nodes unvisited.
 	node->visited = 0;
@@ -3660,6 +3685,7 @@ static msecnode_t *P_DelSecnode(msecnode_t *node)
 		node->m_sector->touching_thinglist = sn;
 	if (sn)
 		sn->m_thinglist_prev = sp;
+	thinglistchanges++;
 
 	// Return this node to the freelist
 
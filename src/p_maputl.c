@@ -787,6 +787,83 @@ void P_LineOpening(line_t *linedef, mobj_t *mobj)
 // THING POSITION SETTING
 //
 
+//
+// P_FindBlockThing
+// Where thing is in a blockmap cell's array, or cell->count if it isn't.
+// Searches from the top, since that's where things that just moved are.
+//
+static size_t P_FindBlockThing(const blockthings_t *cell, const mobj_t *thing)
+{
+	size_t i = cell->count;
+
+	while (i--)
+		if (cell->things[i] == thing)
+			return i;
+
+	return cell->count;
+}
+
+static void P_LinkBlockThing(mobj_t *thing, blockthings_t *cell)
+{
+	if (cell->count == cell->capacity)
+	{
+		cell->capacity = cell->capacity ? cell->capacity * 2 : 8;
+		cell->things = Z_Realloc(cell->things, sizeof (*cell->things) * cell->capacity, PU_LEVEL, NULL);
+	}
+
+	cell->things[cell->count++] = thing;
+	thing->blockcell = cell;
+}
+
+static void P_UnlinkBlockThing(mobj_t *thing)
+{
+	blockthings_t *cell = thing->blockcell;
+	size_t i = P_FindBlockThing(cell, thing);
+
+	if (i < cell->count)
+	{
+		if (cell->walking)
+		{
+			// don't move anything under a walk's feet
+			cell->things[i] = NULL;
+			cell->holes++;
+		}
+		else
+			cell->things[i] = cell->things[--cell->count];
+	}
+
+	thing->blockcell = NULL;
+}
+
+//
+// P_BeginBlockThings
+// Call before walking a cell's things array. Until the matching
+// P_EndBlockThings, entries keep their places: things that leave the
+// cell become NULL, and things that join it are added past the end.
+//
+void P_BeginBlockThings(blockthings_t *cell)
+{
+	cell->walking++;
+}
+
+//
+// P_EndBlockThings
+// Sweeps out the holes left during the walks once the last one ends.
+//
+void P_EndBlockThings(blockthings_t *cell)
+{
+	size_t i, j;
+
+	if (--cell->walking || !cell->holes)
+		return;
+
+	for (i = j = 0; i < cell->count; i++)
+		if (cell->things[i])
+			cell->things[j++] = cell->things[i];
+	cell->count = j;
+	cell->holes = 0;
+}
+
 //
 // P_UnsetThingPosition
 // Unlinks a thing from block map and sectors.
@@ -847,6 +924,11 @@ void P_UnsetThingPosition(mobj_t *thing)
 		if (bprev && (*bprev = bnext = thing->bnext) != NULL)  // unlink from block map
 			bnext->bprev = bprev;
 	}
+
+	// Not tied to MF_NOBLOCKMAP, so a thing whose flags changed
+	// behind our back can't be left behind in the array.
+	if (thing->blockcell)
+		P_UnlinkBlockThing(thing);
 }
 
 void P_UnsetPrecipThingPosition(precipmobj_t *thing)
@@ -875,6 +957,8 @@ void P_SetThingPosition(mobj_t *thing)
 	I_Assert(thing != NULL);
 	I_Assert(!P_MobjWasRemoved(thing));
 
+	P_MobjConsistancyChanged(thing);
+
 	if (thing->player && thing->z <= thing->floorz && thing->subsector)
 		oldsec = thing->subsector->sector;
 
@@ -931,6 +1015,8 @@ void P_SetThingPosition(mobj_t *thing)
 				bnext->bprev = &thing->bnext;
 			thing->bprev = link;
 			*link = thing;
+
+			P_LinkBlockThing(thing, &blockthings[blocky*bmapwidth + blockx]);
 		}
 		else // thing is off the map
 			thing->bnext = NULL, thing->bprev = NULL;
@@ -1081,27 +1167,39 @@ boolean P_BlockLinesIterator(INT32 x, INT32 y, boolean (*func)(line_t *))
 //
 // P_BlockThingsIterator
 //
+// Visits the things that were in the cell when the walk started and
+// are still there when their turn comes.
+//
 boolean P_BlockThingsIterator(INT32 x, INT32 y, boolean (*func)(mobj_t *))
 {
-	mobj_t *mobj, *bnext = NULL;
+	blockthings_t *cell;
+	mobj_t *mobj;
+	boolean ret = true;
+	size_t i;
 
 	if (x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight)
 		return true;
 
+	cell = &blockthings[y*bmapwidth + x];
+	P_BeginBlockThings(cell);
+
 	// Check interaction with the objects in the blockmap.
-	for (mobj = blocklinks[y*bmapwidth + x]; mobj; mobj = bnext)
+	for (i = cell->count; i > 0;)
 	{
-		P_SetTarget(&bnext, mobj->bnext); // We want to note our reference to bnext here incase it is MF_NOTHINK and gets removed!
+		if ((mobj = cell->things[--i]) == NULL)
+			continue; // left the cell during the walk
+
 		if (!func(mobj))
-			return false;
-		if (P_MobjWasRemoved(tmthing) // func just popped our tmthing, cannot continue.
-		|| (bnext && P_MobjWasRemoved(bnext))) // func just broke blockmap chain, cannot continue.
 		{
-			P_SetTarget(&bnext, NULL);
-			return true;
+			ret = false;
+			break;
 		}
+		if (P_MobjWasRemoved(tmthing)) // func just popped our tmthing, cannot continue.
+			break;
 	}
-	return true;
+
+	P_EndBlockThings(cell);
+	return ret;
 }
 
 //
@@ -61,6 +61,21 @@ extern pslope_t *opentopslope, *openbottomslope;
 
 void P_LineOpening(line_t *plinedef, mobj_t *mobj);
 
+// The things in one blockmap cell, kept in an array so collision checks
+// don't have to chase bnext through every mobj. The order is arbitrary.
+// While the cell is being iterated, things that leave it only have their
+// entry cleared, and the holes are swept up once the last walk ends.
+typedef struct blockthings_s
+{
+	mobj_t **things; // NULL for a thing that left during a walk
+	size_t count, capacity;
+	size_t holes; // NULL entries in things
+	UINT8 walking; // walks in progress, see P_BeginBlockThings
+} blockthings_t;
+
+void P_BeginBlockThings(blockthings_t *cell);
+void P_EndBlockThings(blockthings_t *cell);
+
 boolean P_BlockLinesIterator(INT32 x, INT32 y, boolean(*func)(line_t *));
 boolean P_BlockThingsIterator(INT32 x, INT32 y, boolean(*func)(mobj_t *));
 
@@ -35,6 +35,10 @@
 #include "p_slopes.h"
 #endif
 
+#ifdef HAVE_BLUA
+boolean LUA_HasAction(const char *action);
+#endif
+
 // protos.
 static CV_PossibleValue_t viewheight_cons_t[] = {{16, "MIN"}, {56, "MAX"}, {0, NULL}};
 consvar_t cv_viewheight = {"viewheight", VIEWHEIGHTS, 0, viewheight_cons_t, NULL, 0, NULL, NULL, 0, 0, NULL};
@@ -356,6 +360,8 @@ boolean P_SetMobjState(mobj_t *mobj, statenum_t state)
 		I_Error("P_SetMobjState used for player mobj. Use P_SetPlayerMobjState instead!\n(State called: %d)", state);
 #endif
 
+	P_MobjConsistancyChanged(mobj);
+
 	if (recursion++) // if recursion detected,
 		memset(seenstate = tempstate, 0, sizeof tempstate); // clear state table
 
@@ -427,6 +433,7 @@ boolean P_SetMobjStateNF(mobj_t *mobj, statenum_t state)
 	mobj->sprite = st->sprite;
 	mobj->frame = st->frame;
 	mobj->anim_duration = (UINT16)st->var2; // only used if FF_ANIMATE is set
+	P_MobjConsistancyChanged(mobj);
 
 	return true;
 }
@@ -1639,6 +1646,7 @@ void P_XYMovement(mobj_t *mo)
 
 	I_Assert(mo != NULL);
 	I_Assert(!P_MobjWasRemoved(mo));
+	P_MobjConsistancyChanged(mo);
 
 	// if it's stopped
 	if (!mo->momx && !mo->momy)
@@ -1923,6 +1931,7 @@ static void P_RingXYMovement(mobj_t *mo)
 {
 	I_Assert(mo != NULL);
 	I_Assert(!P_MobjWasRemoved(mo));
+	P_MobjConsistancyChanged(mo);
 
 	if (!P_SceneryTryMove(mo, mo->x + mo->momx, mo->y + mo->momy))
 		P_SlideMove(mo);
@@ -1934,6 +1943,7 @@ static void P_SceneryXYMovement(mobj_t *mo)
 
 	I_Assert(mo != NULL);
 	I_Assert(!P_MobjWasRemoved(mo));
+	P_MobjConsistancyChanged(mo);
 
 	oldx = mo->x;
 	oldy = mo->y;
@@ -2087,6 +2097,7 @@ static void P_RingZMovement(mobj_t *mo)
 {
 	I_Assert(mo != NULL);
 	I_Assert(!P_MobjWasRemoved(mo));
+	P_MobjConsistancyChanged(mo);
 
 	// Intercept the stupid 'fall through 3dfloors' bug
 	if (mo->subsector->sector->ffloors)
@@ -2164,6 +2175,7 @@ static boolean P_ZMovement(mobj_t *mo)
 
 	I_Assert(mo != NULL);
 	I_Assert(!P_MobjWasRemoved(mo));
+	P_MobjConsistancyChanged(mo);
 
 	// Intercept the stupid 'fall through 3dfloors' bug
 	if (mo->subsector->sector->ffloors)
@@ -2618,6 +2630,7 @@ static void P_PlayerZMovement(mobj_t *mo)
 {
 	I_Assert(mo != NULL);
 	I_Assert(!P_MobjWasRemoved(mo));
+	P_MobjConsistancyChanged(mo);
 
 	if (!mo->player)
 		return;
@@ -2929,6 +2942,8 @@ nightsdone:
 
 static boolean P_SceneryZMovement(mobj_t *mo)
 {
+	P_MobjConsistancyChanged(mo);
+
 	// Intercept the stupid 'fall through 3dfloors' bug
 	if (mo->subsector->sector->ffloors)
 		P_AdjustMobjFloorZ_FFloors(mo, mo->subsector->sector, 2);
@@ -4518,6 +4533,7 @@ static void P_Boss4DestroyCage(void)
 						rover->flags &= ~FF_EXISTS;
 						sector->moved = true;
 						rsec->moved = true;
+						P_ClearSightCache();
 					}
 				}
 		}
@@ -6171,6 +6187,154 @@ static void P_KoopaThinker(mobj_t *koopa)
 	}
 }
 
+//
+// Dormant objects
+//
+// Placed rings and resting scenery far outnumber everything else on most
+// maps, and on almost every tic all their full think does is advance the
+// state timer. Once an object of that kind has thought and found nothing
+// to do, it is marked MF2_DORMANT and from then on only its state is
+// cycled. It goes back to the full thinker as soon as anything it would
+// have reacted to shows up: momentum, a fuse, a target, being touched,
+// its sector moving, Lua writing to it, and so on. Every node makes the
+// same decisions from the same state, and MF2_DORMANT is saved with the
+// rest of flags2, so this never affects sync.
+//
+
+static boolean P_AttractShieldInGame(void)
+{
+	INT32 i;
+
+	for (i = 0; i < MAXPLAYERS; i++)
+		if (playeringame[i] && players[i].mo
+		&& (players[i].powers[pw_shield] & SH_NOSTACK) == SH_ATTRACT)
+			return true;
+
+	return false;
+}
+
+#ifdef HAVE_BLUA
+//
+// P_LuaAttractChase
+//
+// True if Lua has replaced A_AttractChase, in which case it has to be
+// called for every ring on every tic. Scripts can define it at any time,
+// so this is looked up again on each tic, but only once per tic.
+//
+static boolean P_LuaAttractChase(void)
+{
+	static tic_t checked = (tic_t)-1;
+	static boolean replaced = false;
+
+	if (checked != gametic)
+	{
+		checked = gametic;
+		replaced = LUA_HasAction("A_AttractChase");
+	}
+	return replaced;
+}
+#endif
+
+//
+// P_MobjCanStayDormant
+//
+// True if the full thinker would do nothing to this object on this tic
+// but cycle its state. Only reads fields, so it is cheap enough to
+// check for every dormant object on every tic.
+//
+static boolean P_MobjCanStayDormant(mobj_t *mobj)
+{
+	if (mobj->momx || mobj->momy || mobj->momz || mobj->pmomz
+	|| mobj->fuse || mobj->target || mobj->tracer
+	|| mobj->health <= 0 || mobj->scale != mobj->destscale
+	|| mobj->flags2 & (MF2_PUSHED|MF2_NIGHTSPULL)
+	|| mobj->eflags & (MFE_SPRUNG|MFE_JUSTHITFLOOR))
+		return false;
+
+	// 970 allows ANY mobj to trigger a linedef exec
+	if (mobj->subsector && GETSECSPECIAL(mobj->subsector->sector->special, 2) == 8)
+		return false;
+
+#ifdef HAVE_BLUA
+	if (LUAh_MobjHookExists(mobj->type, hook_MobjThinker))
+		return false;
+#endif
+
+	if (mobj->flags & MF_SCENERY)
+	{
+		// Still resting where P_SceneryThinker left it?
+		if (!(mobj->eflags & MFE_ONGROUND))
+			return false;
+		if (mobj->eflags & MFE_VERTICALFLIP)
+			return mobj->z + mobj->height == mobj->ceilingz;
+		return mobj->z == mobj->floorz;
+	}
+
+	// Rings: A_AttractChase only does anything with an attraction shield around.
+	if (mobj->flags & MF_NOCLIP || mobj->flags2 & MF2_DONTDRAW)
+		return false;
+#ifdef HAVE_BLUA
+	if (P_LuaAttractChase())
+		return false; // Lua wants to see every call
+#endif
+	return !P_AttractShieldInGame();
+}
+
+//
+// P_TryMobjDormant
+//
+// Called at the end of the full think for objects that are allowed to
+// go dormant, once that think is done.
+//
+static void P_TryMobjDormant(mobj_t *mobj)
+{
+	if (P_MobjWasRemoved(mobj) || !P_MobjCanStayDormant(mobj))
+		return;
+
+	if (mobj->flags & MF_SCENERY
+	&& (mobj->flags & MF_BOXICON || P_IsObjectInGoop(mobj)))
+		return;
+
+	mobj->flags2 |= MF2_DORMANT;
+	P_MobjConsistancyChanged(mobj);
+}
+
+//
+// P_DormantLookForShield
+//
+// Moves lastlook on the way A_AttractChase's P_LookForShield does when
+// nobody has an attraction shield: to the third player in game counting
+// from lastlook, or one before where it started if there aren't three.
+// Dormant rings keep the same lastlook as awake ones would.
+//
+static void P_DormantLookForShield(mobj_t *mobj)
+{
+	INT32 look, stop, c = 0;
+
+	if (mobj->lastlook < 0)
+		mobj->lastlook = P_RandomByte();
+
+	look = mobj->lastlook % MAXPLAYERS;
+	stop = (look - 1) & PLAYERSMASK;
+
+	for (; look != stop; look = (look + 1) & PLAYERSMASK)
+		if (playeringame[look] && c++ == 2)
+			break;
+
+	mobj->lastlook = look;
+}
+
+//
+// P_WakeMobj
+//
+// Puts a dormant object back on its full thinker.
+//
+void P_WakeMobj(mobj_t *mobj)
+{
+	mobj->flags2 &= ~MF2_DORMANT;
+	P_MobjConsistancyChanged(mobj);
+}
+
 //
 // P_MobjThinker
 //
@@ -6182,6 +6346,18 @@ void P_MobjThinker(mobj_t *mobj)
 	if (mobj->flags & MF_NOTHINK)
 		return;
 
+	if (mobj->flags2 & MF2_DORMANT)
+	{
+		if (P_MobjCanStayDormant(mobj))
+		{
+			if (!(mobj->flags & MF_SCENERY))
+				P_DormantLookForShield(mobj);
+			P_CycleMobjState(mobj);
+			return;
+		}
+		P_WakeMobj(mobj);
+	}
+
 	// Remove dead target/tracer.
 	if (mobj->target && P_MobjWasRemoved(mobj->target))
 		P_SetTarget(&mobj->target, NULL);
@@ -6490,7 +6666,9 @@ void P_MobjThinker(mobj_t *mobj)
 						return;
 					}
 				}
-				break;
+				P_SceneryThinker(mobj);
+				P_TryMobjDormant(mobj);
+				return;
 		}
 
 		P_SceneryThinker(mobj);
@@ -7068,7 +7246,10 @@ void P_MobjThinker(mobj_t *mobj)
 			if (mobj->flags2 & MF2_NIGHTSPULL)
 				P_NightsItemChase(mobj);
 			else
+			{
 				A_AttractChase(mobj);
+				P_TryMobjDormant(mobj);
+			}
 			return;
 		// Flung items
 		case MT_FLINGRING:
@@ -7844,7 +8025,12 @@ mobj_t *P_SpawnMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type)
 	}
 
 	if (!(mobj->flags & MF_NOTHINK))
+	{
 		P_AddThinker(&mobj->thinker);
+#ifdef MOBJCONSISTANCY
+		P_UpdateMobjConsistancy(mobj);
+#endif
+	}
 
 	// Call action functions when the state is set
 	if (st->action.acp1 && (mobj->flags & MF_RUNSPAWNFUNC))
@@ -7945,6 +8131,96 @@ static inline precipmobj_t *P_SpawnSnowMobj(fixed_t x, fixed_t y, fixed_t z, mob
 	return mo;
 }
 
+#ifdef MOBJCONSISTANCY
+//
+// Desync check
+//
+// Each mobj remembers what it last added to mobjconsistancy, so the
+// totals only have to be adjusted for the objects whose fields changed
+// instead of being summed over the whole thinker list every tic.
+// Whatever moves an object, changes its state, hurts it or wakes it
+// marks it with P_MobjConsistancyChanged, and P_RunThinkers hashes it
+// again after its next think; player mobjs are hashed after every think.
+// A field changed some other way is picked up the next time the object
+// is marked, which happens at the same point everywhere.
+//
+UINT32 mobjconsistancy[NUMMOBJCONSISTANCY];
+
+#define CONSISTANCYFLAGS (MF_SPECIAL|MF_SOLID|MF_PUSHABLE|MF_BOSS|MF_MISSILE|MF_SPRING|MF_MONITOR|MF_FIRE|MF_ENEMY|MF_PAIN|MF_STICKY)
+#define CONSISTANCYMIX(h, v) h = ((h) ^ (UINT32)(v)) * 16777619u
+
+static UINT32 P_MobjConsistancyHash(mobj_t *mobj)
+{
+	UINT32 h = 2166136261u;
+
+	CONSISTANCYMIX(h, mobj->type);
+	CONSISTANCYMIX(h, mobj->x);
+	CONSISTANCYMIX(h, mobj->y);
+	CONSISTANCYMIX(h, mobj->z);
+	CONSISTANCYMIX(h, mobj->momx);
+	CONSISTANCYMIX(h, mobj->momy);
+	CONSISTANCYMIX(h, mobj->momz);
+	CONSISTANCYMIX(h, mobj->angle);
+	CONSISTANCYMIX(h, mobj->health);
+	CONSISTANCYMIX(h, mobj->flags);
+	CONSISTANCYMIX(h, mobj->flags2);
+	CONSISTANCYMIX(h, mobj->eflags);
+	CONSISTANCYMIX(h, mobj->state - states);
+	CONSISTANCYMIX(h, mobj->tics);
+	CONSISTANCYMIX(h, mobj->sprite);
+	CONSISTANCYMIX(h, mobj->frame);
+	// The target and tracer are counted by their own entries
+	CONSISTANCYMIX(h, (mobj->target != NULL)
+		| ((mobj->tracer && mobj->tracer->type != MT_OVERLAY) << 1));
+
+	return h;
+}
+
+static mobjconsistancy_t P_MobjConsistancyPart(mobj_t *mobj)
+{
+	if (mobj->player)
+		return MCON_PLAYERS;
+	if (mobj->flags & (MF_ENEMY|MF_BOSS))
+		return MCON_ENEMIES;
+	if (mobj->flags & (MF_MISSILE|MF_FIRE))
+		return MCON_MISSILES;
+	if (mobj->flags & (MF_SPECIAL|MF_MONITOR))
+		return MCON_ITEMS;
+	return MCON_OTHER;
+}
+
+//
+// P_UpdateMobjConsistancy
+// Replaces what the mobj added to the desync check with its current state.
+//
+void P_UpdateMobjConsistancy(mobj_t *mobj)
+{
+	mobj->consistancydirty = false;
+	mobjconsistancy[mobj->consistancypart] -= mobj->consistancy;
+
+	if (mobj->flags & CONSISTANCYFLAGS)
+	{
+		mobj->consistancy = P_MobjConsistancyHash(mobj);
+		mobj->consistancypart = (UINT8)P_MobjConsistancyPart(mobj);
+		mobjconsistancy[mobj->consistancypart] += mobj->consistancy;
+	}
+	else
+		mobj->consistancy = 0;
+}
+
+//
+// P_ClearMobjConsistancy
+// Called when the thinker list is emptied.
+//
+void P_ClearMobjConsistancy(void)
+{
+	memset(mobjconsistancy, 0, sizeof (mobjconsistancy));
+}
+
+#undef CONSISTANCYMIX
+#undef CONSISTANCYFLAGS
+#endif
+
 //
 // P_RemoveMobj
 //
@@ -7969,6 +8245,11 @@ void P_RemoveMobj(mobj_t *mobj)
 	I_Assert(!P_MobjWasRemoved(mobj));
 #endif
 
+#ifdef MOBJCONSISTANCY
+	mobjconsistancy[mobj->consistancypart] -= mobj->consistancy;
+	mobj->consistancy = 0;
+#endif
+
 	// Rings only, please!
 	if (mobj->spawnpoint &&
 		(mobj->type == MT_RING
@@ -193,6 +193,7 @@ typedef enum
 	MF2_BOSSNOTRAP     = 1<<25, // No Egg Trap after boss
 	MF2_BOSSFLEE       = 1<<26, // Boss is fleeing!
 	MF2_BOSSDEAD       = 1<<27, // Boss is dead! (Not necessarily fleeing, if a fleeing point doesn't exist.)
+	MF2_DORMANT        = 1<<28, // Nothing to do; only the state is cycled until something wakes it.
 	// free: to and including 1<<31
 } mobjflag2_t;
 
@@ -258,6 +259,12 @@ typedef enum {
 	PCF_THUNK = 32,
 } precipflag_t;
 // Map Object definition.
+//
+// Fields are grouped by how often the movement and collision code reads
+// them rather than by topic. Everything P_XYMovement, P_ZMovement and
+// PIT_CheckThing look at for every object comes first so it shares the
+// first couple of cache lines; state, links and the rarely touched
+// bookkeeping follow.
 typedef struct mobj_s
 {
 	// List: thinker links.
@@ -266,20 +273,6 @@ typedef struct mobj_s
 	// Info for drawing: position.
 	fixed_t x, y, z;
 
-	// More list: links in sector (if needed)
-	struct mobj_s *snext;
-	struct mobj_s **sprev; // killough 8/11/98: change to ptr-to-ptr
-
-	// More drawing info: to determine current sprite.
-	angle_t angle;  // orientation
-	spritenum_t sprite; // used to find patch_t and flip value
-	UINT32 frame; // frame number, plus bits see p_pspr.h
-	UINT16 anim_duration; // for FF_ANIMATE states
-
-	struct msecnode_s *touching_sectorlist; // a linked list of sectors where this object appears
-
-	struct subsector_s *subsector; // Subsector the mobj resides in.
-
 	// The closest interval over all contacted sectors (or things).
 	fixed_t floorz; // Nearest floor below.
 	fixed_t ceilingz; // Nearest ceiling above.
@@ -292,61 +285,82 @@ typedef struct mobj_s
 	fixed_t momx, momy, momz;
 	fixed_t pmomz; // If you're on a moving floor, its "momz" would be here
 
+	UINT32 flags; // flags from mobjinfo tables
+
 	INT32 tics; // state tic counter
+	UINT32 frame; // frame number, plus bits see p_pspr.h
 	state_t *state;
-	UINT32 flags; // flags from mobjinfo tables
-	UINT32 flags2; // MF2_ flags
+	UINT16 anim_duration; // for FF_ANIMATE states
+
+	// Everything above is shared with precipmobj_t.
+
 	UINT16 eflags; // extra flags
+	UINT32 flags2; // MF2_ flags
+	mobjtype_t type;
+	INT32 health; // for player this is rings + 1
+	fixed_t scale;
 
-	void *skin; // overrides 'sprite' when non-NULL (for player bodies to 'remember' the skin)
-	// Player and mobj sprites in multiplayer modes are modified
-	//  using an internal color lookup table for re-indexing.
-	UINT8 color; // This replaces MF_TRANSLATION. Use 0 for default (no translation).
+	fixed_t friction;
+	fixed_t movefactor;
 
 	// Interaction info, by BLOCKMAP.
 	// Links in blocks (if needed).
 	struct mobj_s *bnext;
 	struct mobj_s **bprev; // killough 8/11/98: change to ptr-to-ptr
+	struct blockthings_s *blockcell; // blockthings entry it's in, or NULL
 
-	// Additional pointers for NiGHTS hoops
-	struct mobj_s *hnext;
-	struct mobj_s *hprev;
+#ifdef ESLOPE
+	struct pslope_s *standingslope; // The slope that the object is standing on (shouldn't need synced in savegames, right?)
+#endif
+
+	struct mobj_s *target; // Thing being chased/attacked (or NULL), and originator for missiles.
+	struct mobj_s *tracer; // Thing being chased/attacked for tracers.
+
+	// Additional info record for player avatars only.
+	// Only valid if type == MT_PLAYER
+	struct player_s *player;
 
-	mobjtype_t type;
 	const mobjinfo_t *info; // &mobjinfo[mobj->type]
 
-	INT32 health; // for player this is rings + 1
+	struct subsector_s *subsector; // Subsector the mobj resides in.
+
+	// More list: links in sector (if needed)
+	struct mobj_s *snext;
+	struct mobj_s **sprev; // killough 8/11/98: change to ptr-to-ptr
+
+	struct msecnode_s *touching_sectorlist; // a linked list of sectors where this object appears
+
+	// More drawing info: to determine current sprite.
+	angle_t angle;  // orientation
+	spritenum_t sprite; // used to find patch_t and flip value
+
+	void *skin; // overrides 'sprite' when non-NULL (for player bodies to 'remember' the skin)
+	// Player and mobj sprites in multiplayer modes are modified
+	//  using an internal color lookup table for re-indexing.
+	UINT8 color; // This replaces MF_TRANSLATION. Use 0 for default (no translation).
+
+	// Additional pointers for NiGHTS hoops
+	struct mobj_s *hnext;
+	struct mobj_s *hprev;
 
 	// Movement direction, movement generation (zig-zagging).
 	angle_t movedir; // dirtype_t 0-7; also used by Deton for up/down angle
 	INT32 movecount; // when 0, select a new dir
 
-	struct mobj_s *target; // Thing being chased/attacked (or NULL), and originator for missiles.
-
 	INT32 reactiontime; // If not 0, don't attack yet.
 
 	INT32 threshold; // If >0, the target will be chased no matter what.
 
-	// Additional info record for player avatars only.
-	// Only valid if type == MT_PLAYER
-	struct player_s *player;
-
 	INT32 lastlook; // Player number last looked for.
 
 	mapthing_t *spawnpoint; // Used for CTF flags, objectplace, and a handful other applications.
 
-	struct mobj_s *tracer; // Thing being chased/attacked for tracers.
-
-	fixed_t friction;
-	fixed_t movefactor;
-
 	INT32 fuse; // Does something in P_MobjThinker on reaching 0.
 	fixed_t watertop; // top of the water FOF the mobj is in
 	fixed_t waterbottom; // bottom of the water FOF the mobj is in
 
 	UINT32 mobjnum; // A unique number for this mobj. Used for restoring pointers on save games.
 
-	fixed_t scale;
 	fixed_t destscale;
 	fixed_t scalespeed;
 
@@ -359,8 +373,12 @@ typedef struct mobj_s
 	INT32 cusval;
 	INT32 cvmem;
 
-#ifdef ESLOPE
-	struct pslope_s *standingslope; // The slope that the object is standing on (shouldn't need synced in savegames, right?)
+#ifdef MOBJCONSISTANCY
+	// What this object last added to the desync check, and where.
+	// Rebuilt from the rest of the mobj, so never saved.
+	UINT32 consistancy;
+	UINT8 consistancypart;
+	boolean consistancydirty; // something it hashes may have changed since
 #endif
 
 	// WARNING: New fields must be added separately to savegame and Lua.
@@ -369,9 +387,9 @@ typedef struct mobj_s
 //
 // For precipitation
 //
-// Sometimes this is casted to a mobj_t,
-// so please keep the start of the
-// structure the same.
+// P_SnowThinker and P_RainThinker cast this to a mobj_t
+// for P_CycleStateAnimation, so please keep the start of
+// the structure the same, up to anim_duration.
 //
 typedef struct precipmobj_s
 {
@@ -381,20 +399,6 @@ typedef struct precipmobj_s
 	// Info for drawing: position.
 	fixed_t x, y, z;
 
-	// More list: links in sector (if needed)
-	struct precipmobj_s *snext;
-	struct precipmobj_s **sprev; // killough 8/11/98: change to ptr-to-ptr
-
-	// More drawing info: to determine current sprite.
-	angle_t angle;  // orientation
-	spritenum_t sprite; // used to find patch_t and flip value
-	UINT32 frame; // frame number, plus bits see p_pspr.h
-	UINT16 anim_duration; // for FF_ANIMATE states
-
-	struct mprecipsecnode_s *touching_sectorlist; // a linked list of sectors where this object appears
-
-	struct subsector_s *subsector; // Subsector the mobj resides in.
-
 	// The closest interval over all contacted sectors (or things).
 	fixed_t floorz; // Nearest floor below.
 	fixed_t ceilingz; // Nearest ceiling above.
@@ -407,9 +411,24 @@ typedef struct precipmobj_s
 	fixed_t momx, momy, momz;
 	fixed_t precipflags; // fixed_t so it uses the same spot as "pmomz" even as we use precipflags_t for it
 
+	INT32 flags; // flags from mobjinfo tables
+
 	INT32 tics; // state tic counter
+	UINT32 frame; // frame number, plus bits see p_pspr.h
 	state_t *state;
-	INT32 flags; // flags from mobjinfo tables
+	UINT16 anim_duration; // for FF_ANIMATE states
+
+	struct subsector_s *subsector; // Subsector the mobj resides in.
+
+	// More list: links in sector (if needed)
+	struct precipmobj_s *snext;
+	struct precipmobj_s **sprev; // killough 8/11/98: change to ptr-to-ptr
+
+	struct mprecipsecnode_s *touching_sectorlist; // a linked list of sectors where this object appears
+
+	// More drawing info: to determine current sprite.
+	angle_t angle;  // orientation
+	spritenum_t sprite; // used to find patch_t and flip value
 } precipmobj_t;
 
 typedef struct actioncache_s
@@ -456,4 +475,28 @@ extern mapthing_t *huntemeralds[MAXHUNTEMERALDS];
 extern INT32 numhuntemeralds;
 extern boolean runemeraldmanager;
 extern INT32 numstarposts;
+
+#ifdef MOBJCONSISTANCY
+// Running totals for the netgame desync check, split up
+// so a synch failure can be traced to one kind of object.
+typedef enum
+{
+	MCON_PLAYERS,
+	MCON_ENEMIES,
+	MCON_MISSILES,
+	MCON_ITEMS,
+	MCON_OTHER,
+	NUMMOBJCONSISTANCY
+} mobjconsistancy_t;
+
+extern UINT32 mobjconsistancy[NUMMOBJCONSISTANCY];
+
+void P_UpdateMobjConsistancy(mobj_t *mobj);
+void P_ClearMobjConsistancy(void);
+
+// Marks the mobj to be hashed again after the next time it thinks
+#define P_MobjConsistancyChanged(mobj) ((mobj)->consistancydirty = true)
+#else
+#define P_MobjConsistancyChanged(mobj) (void)0
+#endif
 #endif
@@ -14,6 +14,7 @@
 #include "doomdef.h"
 #include "byteptr.h"
 #include "d_main.h"
+#include "d_netcmd.h" // netvars that decide what P_LoadThings spawns
 #include "doomstat.h"
 #include "g_game.h"
 #include "m_random.h"
@@ -944,12 +945,11 @@ typedef enum
 	MD2_EXTVAL1     = 1<<5,
 	MD2_EXTVAL2     = 1<<6,
 	MD2_HNEXT       = 1<<7,
-#ifdef ESLOPE
 	MD2_HPREV       = 1<<8,
-	MD2_SLOPE       = 1<<9
-#else
-	MD2_HPREV       = 1<<8
+#ifdef ESLOPE
+	MD2_SLOPE       = 1<<9,
 #endif
+	MD2_SPAWNZ      = 1<<10
 } mobj_diff2_t;
 
 typedef enum
@@ -1019,6 +1019,60 @@ static inline UINT32 SavePlayer(const player_t *player)
 	return 0xFFFFFFFF;
 }
 
+// Netvars and game state that change which map things P_LoadThings
+// spawns; collected tokens and emeralds aren't spawned again. A joiner
+// loads the level with their current values, so the base snapshot is
+// only any use while they're the same as when the level was loaded.
+#define NUMSPAWNEDTHINGSVARS 6
+static INT32 spawnedthingsvars[NUMSPAWNEDTHINGSVARS];
+static boolean savespawnedthings; // set while saving if the snapshot is usable
+
+static void P_GetSpawnedThingsVars(INT32 *vars)
+{
+	vars[0] = cv_specialrings.value;
+	vars[1] = cv_powerstones.value;
+	vars[2] = cv_matchboxes.value;
+	vars[3] = cv_competitionboxes.value;
+	vars[4] = (INT32)tokenlist;
+	vars[5] = emeralds;
+}
+
+//
+// P_RecordSpawnedThings
+//
+// Remembers where the level put each map thing's mobj, so that netgame
+// saves can leave out the heights of things that are still there.
+//
+void P_RecordSpawnedThings(void)
+{
+	size_t i;
+	mapthing_t *mt = mapthings;
+
+	P_GetSpawnedThingsVars(spawnedthingsvars);
+
+	for (i = 0; i < nummapthings; i++, mt++)
+	{
+		mt->spawnrecorded = (mt->mobj != NULL);
+		if (!mt->mobj)
+			continue;
+		mt->spawnz = mt->mobj->z;
+		mt->spawnfloorz = mt->mobj->floorz;
+		mt->spawnceilingz = mt->mobj->ceilingz;
+	}
+}
+
+static UINT32 P_SpawnedThingsChecksum(void)
+{
+	size_t i;
+	UINT32 sum = 0;
+	const mapthing_t *mt = mapthings;
+
+	for (i = 0; i < nummapthings; i++, mt++)
+		if (mt->spawnrecorded)
+			sum = (sum << 5 | sum >> 27) ^ (UINT32)(i + mt->spawnz + 3*mt->spawnfloorz + 5*mt->spawnceilingz);
+	return sum;
+}
+
 //
 // SaveMobjThinker
 //
@@ -1144,6 +1198,14 @@ static void SaveMobjThinker(const thinker_t *th, const UINT8 type)
 	if (mobj->standingslope)
 		diff2 |= MD2_SLOPE;
 #endif
+	// Things that haven't moved from where the level put them, such as
+	// rings, don't need their heights saved: the joiner has loaded the
+	// same level.
+	if (savespawnedthings && (diff & MD_SPAWNPOINT) && mobj->spawnpoint->mobj == mobj && mobj->spawnpoint->spawnrecorded
+		&& mobj->z == mobj->spawnpoint->spawnz
+		&& mobj->floorz == mobj->spawnpoint->spawnfloorz
+		&& mobj->ceilingz == mobj->spawnpoint->spawnceilingz)
+		diff2 |= MD2_SPAWNZ;
 	if (diff2 != 0)
 		diff |= MD_MORE;
 
@@ -1156,24 +1218,20 @@ static void SaveMobjThinker(const thinker_t *th, const UINT8 type)
 	if (diff & MD_MORE)
 		WRITEUINT16(save_p, diff2);
 
-	// save pointer, at load time we will search this pointer to reinitilize pointers
-	WRITEUINT32(save_p, (size_t)mobj);
-
-	WRITEFIXED(save_p, mobj->z); // Force this so 3dfloor problems don't arise.
-	WRITEFIXED(save_p, mobj->floorz);
-	WRITEFIXED(save_p, mobj->ceilingz);
-
 	if (diff & MD_SPAWNPOINT)
 	{
-		size_t z;
-
-		for (z = 0; z < nummapthings; z++)
-			if (&mapthings[z] == mobj->spawnpoint)
-				WRITEUINT16(save_p, z);
+		WRITEUINT16(save_p, mobj->spawnpoint - mapthings);
 		if (mobj->type == MT_HOOPCENTER)
 			return;
 	}
 
+	if (!(diff2 & MD2_SPAWNZ))
+	{
+		WRITEFIXED(save_p, mobj->z); // Force this so 3dfloor problems don't arise.
+		WRITEFIXED(save_p, mobj->floorz);
+		WRITEFIXED(save_p, mobj->ceilingz);
+	}
+
 	if (diff & MD_TYPE)
 		WRITEUINT32(save_p, mobj->type);
 	if (diff & MD_POS)
@@ -1264,7 +1322,7 @@ static void SaveMobjThinker(const thinker_t *th, const UINT8 type)
 		WRITEUINT16(save_p, mobj->standingslope->id);
 #endif
 
-	WRITEUINT32(save_p, mobj->mobjnum);
+	// mobjnum isn't written, it's the same as the order mobjs are saved in.
 }
 
 //
@@ -1676,8 +1734,15 @@ static void P_NetArchiveThinkers(void)
 {
 	const thinker_t *th;
 	UINT32 numsaved = 0;
+	INT32 vars[NUMSPAWNEDTHINGSVARS];
+
+	// If the netvars have changed since the level was loaded, a joiner
+	// won't spawn the same things, so write every height out in full.
+	P_GetSpawnedThingsVars(vars);
+	savespawnedthings = !memcmp(vars, spawnedthingsvars, sizeof (vars));
 
 	WRITEUINT32(save_p, ARCHIVEBLOCK_THINKERS);
+	WRITEUINT32(save_p, savespawnedthings ? P_SpawnedThingsChecksum() : 0);
 
 	// save off the current thinkers
 	for (th = thinkercap.next; th != &thinkercap; th = th->next)
@@ -1928,6 +1993,28 @@ static inline player_t *LoadPlayer(UINT32 player)
 	return &players[player];
 }
 
+// Mobjs are numbered in the order they were saved, see P_SaveNetGame.
+static UINT32 loadedmobjnum;
+
+//
+// P_GuessSpawnHeights
+//
+// For a thing saved without heights that our copy of the level didn't
+// spawn: puts it on its map thing's floor or ceiling, as flags respawn.
+//
+static void P_GuessSpawnHeights(mobj_t *mobj)
+{
+	const mapthing_t *mt = mobj->spawnpoint;
+	const sector_t *sector = R_PointInSubsector(mobj->x, mobj->y)->sector;
+
+	mobj->floorz = sector->floorheight;
+	mobj->ceilingz = sector->ceilingheight;
+	if (mt->options & MTF_OBJECTFLIP)
+		mobj->z = mobj->ceilingz - mobj->info->height - ((mt->options >> ZSHIFT) << FRACBITS);
+	else
+		mobj->z = mobj->floorz + ((mt->options >> ZSHIFT) << FRACBITS);
+}
+
 //
 // LoadMobjThinker
 //
@@ -1935,7 +2022,6 @@ static inline player_t *LoadPlayer(UINT32 player)
 //
 static void LoadMobjThinker(actionf_p1 thinker)
 {
-	thinker_t *next;
 	mobj_t *mobj;
 	UINT32 diff;
 	UINT16 diff2;
@@ -1948,12 +2034,6 @@ static void LoadMobjThinker(actionf_p1 thinker)
 	else
 		diff2 = 0;
 
-	next = (void *)(size_t)READUINT32(save_p);
-
-	z = READFIXED(save_p); // Force this so 3dfloor problems don't arise.
-	floorz = READFIXED(save_p);
-	ceilingz = READFIXED(save_p);
-
 	if (diff & MD_SPAWNPOINT)
 	{
 		UINT16 spawnpointnum = READUINT16(save_p);
@@ -1972,6 +2052,20 @@ static void LoadMobjThinker(actionf_p1 thinker)
 	else
 		mobj = Z_Calloc(sizeof (*mobj), PU_LEVEL, NULL);
 
+	if (diff2 & MD2_SPAWNZ)
+	{
+		// if our level didn't spawn it, P_GuessSpawnHeights does below
+		z = mobj->spawnpoint->spawnz;
+		floorz = mobj->spawnpoint->spawnfloorz;
+		ceilingz = mobj->spawnpoint->spawnceilingz;
+	}
+	else
+	{
+		z = READFIXED(save_p); // Force this so 3dfloor problems don't arise.
+		floorz = READFIXED(save_p);
+		ceilingz = READFIXED(save_p);
+	}
+
 	// declare this as a valid mobj as soon as possible.
 	mobj->thinker.function.acp1 = thinker;
 
@@ -2009,6 +2103,8 @@ static void LoadMobjThinker(actionf_p1 thinker)
 		mobj->y = mobj->spawnpoint->y << FRACBITS;
 		mobj->angle = FixedAngle(mobj->spawnpoint->angle*FRACUNIT);
 	}
+	if ((diff2 & MD2_SPAWNZ) && !mobj->spawnpoint->spawnrecorded)
+		P_GuessSpawnHeights(mobj);
 	if (diff & MD_MOM)
 	{
 		mobj->momx = READFIXED(save_p);
@@ -2150,7 +2246,7 @@ static void LoadMobjThinker(actionf_p1 thinker)
 	// set sprev, snext, bprev, bnext, subsector
 	P_SetThingPosition(mobj);
 
-	mobj->mobjnum = READUINT32(save_p);
+	mobj->mobjnum = ++loadedmobjnum;
 
 	if (mobj->player)
 	{
@@ -2161,8 +2257,6 @@ static void LoadMobjThinker(actionf_p1 thinker)
 	}
 
 	P_AddThinker(&mobj->thinker);
-
-	mobj->info = (mobjinfo_t *)next; // temporarily, set when leave this function
 }
 
 //
@@ -2651,6 +2745,14 @@ static void P_NetUnArchiveThinkers(void)
 	if (READUINT32(save_p) != ARCHIVEBLOCK_THINKERS)
 		I_Error("Bad $$$.sav at archive block Thinkers");
 
+	// Heights of unmoved things come from our own copy of the level,
+	// which should have spawned them the same way as the server's.
+	// Things it didn't spawn get P_GuessSpawnHeights instead.
+	i = READUINT32(save_p);
+	if (i && i != P_SpawnedThingsChecksum())
+		CONS_Alert(CONS_WARNING, M_GetText("Map things were not spawned the same way as on the server\n"));
+	loadedmobjnum = 0;
+
 	// remove all the current thinkers
 	currentthinker = thinkercap.next;
 	for (currentthinker = thinkercap.next; currentthinker != &thinkercap; currentthinker = next)
@@ -2957,6 +3059,11 @@ static inline void P_FinishMobjs(void)
 	thinker_t *currentthinker;
 	mobj_t *mobj;
 
+#ifdef MOBJCONSISTANCY
+	// Totals are rebuilt now that target and tracer point at mobjs again
+	P_ClearMobjConsistancy();
+#endif
+
 	// put info field there real value
 	for (currentthinker = thinkercap.next; currentthinker != &thinkercap;
 		currentthinker = currentthinker->next)
@@ -2965,6 +3072,10 @@ static inline void P_FinishMobjs(void)
 		{
 			mobj = (mobj_t *)currentthinker;
 			mobj->info = &mobjinfo[mobj->type];
+#ifdef MOBJCONSISTANCY
+			mobj->consistancy = 0;
+			P_UpdateMobjConsistancy(mobj);
+#endif
 		}
 	}
 }
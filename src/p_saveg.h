@@ -27,6 +27,7 @@ boolean P_LoadGame(INT16 mapoverride);
 boolean P_LoadNetGame(void);
 
 mobj_t *P_FindNewPosition(UINT32 oldposition);
+void P_RecordSpawnedThings(void);
 
 typedef struct
 {
@@ -119,6 +119,7 @@ INT32 *blockmaplump; // Big blockmap
 fixed_t bmaporgx, bmaporgy;
 // for thing chains
 mobj_t **blocklinks;
+blockthings_t *blockthings;
 
 // REJECT
 // For fast sight rejection.
@@ -1871,6 +1872,7 @@ static void P_CreateBlockMap(void)
 		size_t count = sizeof (*blocklinks) * bmapwidth * bmapheight;
 		// clear out mobj chains (copied from from P_LoadBlockMap)
 		blocklinks = Z_Calloc(count, PU_LEVEL, NULL);
+		blockthings = Z_Calloc(sizeof (*blockthings) * bmapwidth * bmapheight, PU_LEVEL, NULL);
 		blockmap = blockmaplump + 4;
 
 #ifdef POLYOBJECTS
@@ -1948,6 +1950,7 @@ static boolean P_LoadBlockMap(lumpnum_t lumpnum)
 	// clear out mobj chains
 	count = sizeof (*blocklinks)* bmapwidth*bmapheight;
 	blocklinks = Z_Calloc(count, PU_LEVEL, NULL);
+	blockthings = Z_Calloc(sizeof (*blockthings) * bmapwidth * bmapheight, PU_LEVEL, NULL);
 	blockmap = blockmaplump+4;
 
 #ifdef POLYOBJECTS
@@ -2014,6 +2017,7 @@ static boolean P_LoadRawBlockMap(UINT8 *data, size_t count, const char *lumpname
 	// clear out mobj chains
 	count = sizeof (*blocklinks)* bmapwidth*bmapheight;
 	blocklinks = Z_Calloc(count, PU_LEVEL, NULL);
+	blockthings = Z_Calloc(sizeof (*blockthings) * bmapwidth * bmapheight, PU_LEVEL, NULL);
 	blockmap = blockmaplump+4;
 
 #ifdef POLYOBJECTS
@@ -2749,7 +2753,8 @@ boolean P_SetupLevel(boolean skipprecip)
 		{
 			// wait loop
 			while (!((nowtime = I_GetTime()) - lastwipetic))
-				I_Sleep();
+				if (!M_EncodeMovieFrame())
+					I_Sleep();
 			lastwipetic = nowtime;
 			if (moviemode) // make sure we save frames for the white hold too
 				M_SaveFrame();
@@ -2801,9 +2806,6 @@ boolean P_SetupLevel(boolean skipprecip)
 		Z_Free(ss->attachedsolid);
 	}
 
-	// Clear pointers that would be left dangling by the purge
-	R_FlushTranslationColormapCache();
-
 	Z_FreeTags(PU_LEVEL, PU_PURGELEVEL - 1);
 
 #if defined (WALLSPLATS) || defined (FLOORSPLATS)
@@ -2931,6 +2933,7 @@ boolean P_SetupLevel(boolean skipprecip)
 #endif
 
 	P_LoadThings();
+	P_RecordSpawnedThings();
 
 	P_SpawnSecretItems(loademblems);
 
@@ -16,6 +16,8 @@
 #include "p_local.h"
 #include "r_main.h"
 #include "r_state.h"
+#include "console.h"
+#include "command.h"
 
 //
 // P_CheckSight
@@ -30,7 +32,85 @@ typedef struct {
 	fixed_t bbox[4];
 } los_t;
 
-static INT32 sightcounts[2];
+static struct
+{
+	UINT32 calls; // every P_CheckSight
+	UINT32 trivial; // settled by REJECT or a shared subsector
+	UINT32 hits; // answered from the sight cache
+	UINT32 traced; // needed a walk through the BSP
+} sightstats;
+
+//
+// Sight cache
+//
+// The same looker often asks about the same target several times in one
+// tic: A_Look then A_Chase, homing attacks re-checking their target,
+// bosses picking among players. A line of sight depends only on where
+// both ends are and on the level geometry, so results are kept for the
+// rest of the tic, keyed by both positions, and all dropped at once by
+// P_ClearSightCache whenever the geometry may have moved.
+//
+#define SIGHTCACHESIZE 512 // must be a power of two
+
+typedef struct
+{
+	fixed_t x1, y1, z1, height1;
+	fixed_t x2, y2, z2, height2;
+	UINT32 epoch; // valid while this matches sightepoch
+	boolean visible;
+} sightcache_t;
+
+static sightcache_t sightcache[SIGHTCACHESIZE];
+static UINT32 sightepoch = 1;
+
+//
+// P_ClearSightCache
+//
+// Forgets every cached sight result. Called at the start of each tic and
+// whenever something may have moved a floor, ceiling, FOF or polyobject.
+//
+void P_ClearSightCache(void)
+{
+	if (!++sightepoch) // wrapped round; old entries could match again
+	{
+		memset(sightcache, 0, sizeof (sightcache));
+		sightepoch = 1;
+	}
+}
+
+static sightcache_t *P_SightCacheSlot(const mobj_t *t1, const mobj_t *t2)
+{
+	UINT32 hash = (UINT32)(t1->x ^ (t1->y >> 7) ^ (t1->z >> 13))
+		+ 31 * (UINT32)(t2->x ^ (t2->y >> 7) ^ (t2->z >> 13));
+
+	return &sightcache[(hash ^ (hash >> 16)) & (SIGHTCACHESIZE-1)];
+}
+
+static inline boolean P_SightCacheMatch(const sightcache_t *slot, const mobj_t *t1, const mobj_t *t2)
+{
+	return slot->epoch == sightepoch
+		&& slot->x1 == t1->x && slot->y1 == t1->y && slot->z1 == t1->z && slot->height1 == t1->height
+		&& slot->x2 == t2->x && slot->y2 == t2->y && slot->z2 == t2->z && slot->height2 == t2->height;
+}
+
+//
+// Command_Sightstats_f
+//
+void Command_Sightstats_f(void)
+{
+	if (COM_Argc() > 1 && !stricmp(COM_Argv(1), "reset"))
+	{
+		memset(&sightstats, 0, sizeof (sightstats));
+		CONS_Printf(M_GetText("Sight statistics reset.\n"));
+		return;
+	}
+
+	CONS_Printf(M_GetText("Sight checks: %u, trivial: %u, cached: %u, traced: %u\n"),
+		sightstats.calls, sightstats.trivial, sightstats.hits, sightstats.traced);
+	if (sightstats.hits + sightstats.traced)
+		CONS_Printf(M_GetText("Sight cache hit rate: %u%%\n"),
+			(UINT32)((UINT64)sightstats.hits * 100 / (sightstats.hits + sightstats.traced)));
+}
 
 //
 // P_DivlineSide
@@ -298,6 +378,8 @@ static boolean P_CrossBSPNode(INT32 bspnum, register los_t *los)
 		P_CrossSubsector((bspnum == -1 ? 0 : bspnum & ~NF_SUBSECTOR), los);
 }
 
+static boolean P_CheckSightLOS(mobj_t *t1, mobj_t *t2, const sector_t *s1, const sector_t *s2);
+
 //
 // P_CheckSight
 //
@@ -308,7 +390,7 @@ boolean P_CheckSight(mobj_t *t1, mobj_t *t2)
 {
 	const sector_t *s1, *s2;
 	size_t pnum;
-	los_t los;
+	sightcache_t *slot;
 
 	// First check for trivial rejection.
 	if (!t1 || !t2)
@@ -325,29 +407,59 @@ boolean P_CheckSight(mobj_t *t1, mobj_t *t2)
 	s2 = t2->subsector->sector;
 	pnum = (s1-sectors)*numsectors + (s2-sectors);
 
+	sightstats.calls++;
+
 	if (rejectmatrix != NULL)
 	{
 		// Check in REJECT table.
 		if (rejectmatrix[pnum>>3] & (1 << (pnum&7))) // can't possibly be connected
+		{
+			sightstats.trivial++;
 			return false;
+		}
 	}
 
 	// killough 11/98: shortcut for melee situations
 	// same subsector? obviously visible
 #ifndef POLYOBJECTS
 	if (t1->subsector == t2->subsector)
-		return true;
 #else
 	// haleyjd 02/23/06: can't do this if there are polyobjects in the subsec
 	if (!t1->subsector->polyList &&
 		t1->subsector == t2->subsector)
-		return true;
 #endif
+	{
+		sightstats.trivial++;
+		return true;
+	}
+
+	// Asked already this tic?
+	slot = P_SightCacheSlot(t1, t2);
+	if (P_SightCacheMatch(slot, t1, t2))
+	{
+		sightstats.hits++;
+		return slot->visible;
+	}
+
+	slot->x1 = t1->x, slot->y1 = t1->y, slot->z1 = t1->z, slot->height1 = t1->height;
+	slot->x2 = t2->x, slot->y2 = t2->y, slot->z2 = t2->z, slot->height2 = t2->height;
+	slot->epoch = sightepoch;
+	sightstats.traced++;
+
+	return (slot->visible = P_CheckSightLOS(t1, t2, s1, s2));
+}
+
+//
+// P_CheckSightLOS
+//
+// The expensive part of P_CheckSight, once the cheap ways out are gone.
+//
+static boolean P_CheckSightLOS(mobj_t *t1, mobj_t *t2, const sector_t *s1, const sector_t *s2)
+{
+	los_t los;
 
 	// An unobstructed LOS is possible.
 	// Now look from eyes of t1 to any part of t2.
-	sightcounts[1]++;
-
 	validcount++;
 
 	los.topslope =
@@ -352,6 +352,37 @@ void P_InitPicAnims(void)
 	animdefs = NULL;
 }
 
+/** Marks every frame of a texture animation if any one of them is marked.
+  * R_PrecacheLevel uses this so the whole cycle gets built ahead of time.
+  *
+  * \param present Flags indexed by texture number.
+  * \sa P_InitPicAnims
+  */
+void P_MarkAnimatedTextures(char *present)
+{
+	anim_t *anim;
+	INT32 i;
+
+	if (!anims)
+		return;
+
+	for (anim = anims; anim->istexture != -1; anim++)
+	{
+		if (!anim->istexture)
+			continue;
+
+		for (i = 0; i < anim->numpics; i++)
+			if (present[anim->basepic + i])
+				break;
+
+		if (i == anim->numpics)
+			continue;
+
+		for (i = 0; i < anim->numpics; i++)
+			present[anim->basepic + i] = 1;
+	}
+}
+
 void P_ParseANIMDEFSLump(INT32 wadNum, UINT16 lumpnum)
 {
 	char *animdefsLump;
@@ -2224,6 +2255,9 @@ static void P_ProcessLineSpecial(line_t *line, mobj_t *mo, sector_t *callsec)
 
 	I_Assert(!mo || !P_MobjWasRemoved(mo)); // If mo is there, mo must be valid!
 
+	// Most executors move or change level geometry one way or another.
+	P_ClearSightCache();
+
 	if (mo && mo->player && botingame)
 		bot = players[secondarydisplayplayer].mo;
 
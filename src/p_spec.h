@@ -27,6 +27,7 @@ extern mobj_t *skyboxmo[2];
 
 // at game start
 void P_InitPicAnims(void);
+void P_MarkAnimatedTextures(char *present);
 
 // at map load (sectors)
 void P_SetupLevelFlatAnims(void);
@@ -179,6 +179,10 @@ void Command_CountMobjs_f(void)
 void P_InitThinkers(void)
 {
 	thinkercap.prev = thinkercap.next = &thinkercap;
+	P_ClearSightCache();
+#ifdef MOBJCONSISTANCY
+	P_ClearMobjConsistancy();
+#endif
 }
 
 //
@@ -299,7 +303,24 @@ static inline void P_RunThinkers(void)
 	for (currentthinker = thinkercap.next; currentthinker != &thinkercap; currentthinker = currentthinker->next)
 	{
 		if (currentthinker->function.acp1)
+		{
+			// Anything but a mobj (or weather) may move the level around,
+			// which invalidates any cached sight checks.
+			if (currentthinker->function.acp1 != (actionf_p1)P_MobjThinker
+			&& currentthinker->function.acp1 != (actionf_p1)P_RemoveThinkerDelayed
+			&& currentthinker->function.acp1 != (actionf_p1)P_SnowThinker
+			&& currentthinker->function.acp1 != (actionf_p1)P_RainThinker
+			&& currentthinker->function.acp1 != (actionf_p1)P_NullPrecipThinker)
+				P_ClearSightCache();
 			currentthinker->function.acp1(currentthinker);
+		}
+#ifdef MOBJCONSISTANCY
+		// If it was freed, currentthinker is the one before it, which
+		// may be a mobj that has already been counted; that's harmless.
+		if (currentthinker->function.acp1 == (actionf_p1)P_MobjThinker
+		&& (((mobj_t *)currentthinker)->consistancydirty || ((mobj_t *)currentthinker)->player))
+			P_UpdateMobjConsistancy((mobj_t *)currentthinker);
+#endif
 	}
 }
 
@@ -593,6 +614,7 @@ void P_Ticker(boolean run)
 	postimgtype = postimgtype2 = postimg_none;
 
 	P_MapStart();
+	P_ClearSightCache();
 
 	if (run)
 	{
@@ -24,6 +24,7 @@
 #include "p_setup.h" // levelflats
 #include "v_video.h" // pLocalPalette
 #include "dehacked.h"
+#include "i_system.h" // I_GetTimeMicros
 
 #if defined (_WIN32) || defined (_WIN32_WCE)
 #include <malloc.h> // alloca(sizeof)
@@ -101,6 +102,20 @@ texture_t **textures = NULL;
 static UINT32 **texturecolumnofs; // column offset lookup table for each texture
 static UINT8 **texturecache; // graphics data for each generated full-size texture
 
+// The level's textures, built in one go by R_PrecacheLevel
+#define TEXTUREARENABITS 6
+#define TEXTUREARENAALIGN (1<<TEXTUREARENABITS) // cache line
+static UINT8 *texturearena = NULL;
+
+static struct
+{
+	UINT32 arena; // textures in the arena
+	size_t arenasize;
+	UINT32 arenatime; // microseconds spent building it
+	UINT32 lazy; // textures generated while drawing
+	UINT32 lazytime, lazypeak;
+} texturestats;
+
 // texture width is a power of 2, so it can easily repeat along sidedefs using a simple mask
 INT32 *texturewidthmask;
 
@@ -174,49 +189,38 @@ static inline void R_DrawColumnInCache(column_t *patch, UINT8 *cache, INT32 orig
 }
 
 //
-// R_GenerateTexture
-//
-// Allocate space for full size texture, either single patch or 'composite'
-// Build the full textures from patches.
-// The texture caching system is a little more hungry of memory, but has
-// been simplified for the sake of highcolor, dynamic ligthing, & speed.
+// R_TextureCacheSize
 //
-// This is not optimised, but it's supposed to be executed only once
-// per level, when enough memory is available.
+// Works out how much room a texture needs once it's been generated.
+// Single-patch textures can have holes in them and may be used on 2sided
+// lines, so they need to be kept in 'packed' format. BUT this is wrong for
+// skies and walls with over 255 pixels, so check if there's holes and if
+// not strip the posts.
 //
-static UINT8 *R_GenerateTexture(size_t texnum)
+static size_t R_TextureCacheSize(size_t texnum)
 {
-	UINT8 *block;
-	UINT8 *blocktex;
 	texture_t *texture;
 	texpatch_t *patch;
 	patch_t *realpatch;
-	int x, x1, x2, i;
-	size_t blocksize;
-	column_t *patchcol;
 	UINT32 *colofs;
+	int x;
 
 	I_Assert(texnum <= (size_t)numtextures);
 	texture = textures[texnum];
 	I_Assert(texture != NULL);
 
-	// allocate texture column offset lookup
+	texture->holes = false;
 
-	// single-patch textures can have holes in them and may be used on
-	// 2sided lines so they need to be kept in 'packed' format
-	// BUT this is wrong for skies and walls with over 255 pixels,
-	// so check if there's holes and if not strip the posts.
 	if (texture->patchcount == 1)
 	{
-		boolean holey = false;
 		patch = texture->patches;
 		realpatch = W_CacheLumpNumPwad(patch->wad, patch->lump, PU_CACHE);
 
 		// Check the patch for holes.
 		if (texture->width > SHORT(realpatch->width) || texture->height > SHORT(realpatch->height))
-			holey = true;
+			texture->holes = true;
 		colofs = (UINT32 *)realpatch->columnofs;
-		for (x = 0; x < texture->width && !holey; x++)
+		for (x = 0; x < texture->width && !texture->holes; x++)
 		{
 			column_t *col = (column_t *)((UINT8 *)realpatch + LONG(colofs[x]));
 			INT32 topdelta, prevdelta = -1, y = 0;
@@ -232,46 +236,56 @@ static UINT8 *R_GenerateTexture(size_t texnum)
 				col = (column_t *)((UINT8 *)col + col->length + 4);
 			}
 			if (y < texture->height)
-				holey = true; // this texture is HOLEy! D:
+				texture->holes = true; // this texture is HOLEy! D:
 		}
 
-		// If the patch uses transparency, we have to save it this way.
-		if (holey)
-		{
-			texture->holes = true;
-			blocksize = W_LumpLengthPwad(patch->wad, patch->lump);
-			block = Z_Calloc(blocksize, PU_STATIC, // will change tag at end of this function
-				&texturecache[texnum]);
-			M_Memcpy(block, realpatch, blocksize);
-			texturememory += blocksize;
-
-			// use the patch's column lookup
-			colofs = (UINT32 *)(void *)(block + 8);
-			texturecolumnofs[texnum] = colofs;
-			blocktex = block;
-			for (x = 0; x < texture->width; x++)
-				colofs[x] = LONG(LONG(colofs[x]) + 3);
-			goto done;
-		}
+		// If the patch uses transparency, we have to save it as it is.
+		if (texture->holes)
+			return W_LumpLengthPwad(patch->wad, patch->lump);
 
 		// Otherwise, do multipatch format.
 	}
 
-	// multi-patch textures (or 'composite')
-	texture->holes = false;
-	blocksize = (texture->width * 4) + (texture->width * texture->height);
-	texturememory += blocksize;
-	block = Z_Malloc(blocksize+1, PU_STATIC, &texturecache[texnum]);
+	// column offsets, then the columns themselves
+	return (texture->width * 4) + (texture->width * texture->height) + 1;
+}
 
-	memset(block, 0xF7, blocksize+1); // Transparency hack
+//
+// R_ComposeTexture
+//
+// Builds the full texture from its patches into block, which must be
+// R_TextureCacheSize bytes.
+//
+static void R_ComposeTexture(size_t texnum, UINT8 *block, size_t blocksize)
+{
+	texture_t *texture = textures[texnum];
+	texpatch_t *patch;
+	patch_t *realpatch;
+	int x, x1, x2, i;
+	column_t *patchcol;
+	UINT32 *colofs;
+
+	if (texture->holes)
+	{
+		patch = texture->patches;
+		realpatch = W_CacheLumpNumPwad(patch->wad, patch->lump, PU_CACHE);
+		M_Memcpy(block, realpatch, blocksize);
+
+		// use the patch's column lookup
+		colofs = (UINT32 *)(void *)(block + 8);
+		texturecolumnofs[texnum] = colofs;
+		for (x = 0; x < texture->width; x++)
+			colofs[x] = LONG(LONG(colofs[x]) + 3);
+		return;
+	}
+
+	// multi-patch textures (or 'composite')
+	memset(block, 0xF7, blocksize); // Transparency hack
 
 	// columns lookup table
 	colofs = (UINT32 *)(void *)block;
 	texturecolumnofs[texnum] = colofs;
 
-	// texture data after the lookup table
-	blocktex = block + (texture->width*4);
-
 	// Composite the columns together.
 	for (i = 0, patch = texture->patches; i < texture->patchcount; i++, patch++)
 	{
@@ -296,11 +310,132 @@ static UINT8 *R_GenerateTexture(size_t texnum)
 			R_DrawColumnInCache(patchcol, block + LONG(colofs[x]), patch->originy, texture->height);
 		}
 	}
+}
+
+//
+// R_GenerateTexture
+//
+// Allocate space for full size texture, either single patch or 'composite'
+// Build the full textures from patches.
+// The texture caching system is a little more hungry of memory, but has
+// been simplified for the sake of highcolor, dynamic ligthing, & speed.
+//
+// Textures used by the level are already built into the texture arena by
+// R_PrecacheLevel; this is only for ones that turn up later, which means
+// a stall in the middle of drawing the frame.
+//
+static UINT8 *R_GenerateTexture(size_t texnum)
+{
+	UINT8 *block;
+	size_t blocksize;
+	UINT32 start = I_GetTimeMicros(), took;
+
+	blocksize = R_TextureCacheSize(texnum);
+	block = Z_Malloc(blocksize, PU_STATIC, // will change tag at end of this function
+		&texturecache[texnum]);
+	R_ComposeTexture(texnum, block, blocksize);
+	texturememory += blocksize;
 
-done:
 	// Now that the texture has been built in column cache, it is purgable from zone memory.
 	Z_ChangeTag(block, PU_CACHE);
-	return blocktex;
+
+	took = I_GetTimeMicros() - start;
+	texturestats.lazy++;
+	texturestats.lazytime += took;
+	if (took > texturestats.lazypeak)
+		texturestats.lazypeak = took;
+	return block;
+}
+
+//
+// R_FreeTextureArena
+//
+// Drops the textures built for the last level.
+//
+static void R_FreeTextureArena(void)
+{
+	INT32 i;
+
+	if (!texturearena)
+		return;
+
+	for (i = 0; i < numtextures; i++)
+		if (texturecache[i] >= texturearena && texturecache[i] < texturearena + texturestats.arenasize)
+			texturecache[i] = NULL;
+
+	Z_Free(texturearena);
+	texturearena = NULL;
+	texturestats.arenasize = 0;
+	texturestats.arena = 0;
+}
+
+//
+// R_BuildTextureArena
+//
+// Builds every texture marked in present into one block, each starting on
+// its own cache line, so none of them need generating mid-frame.
+//
+static void R_BuildTextureArena(const char *present)
+{
+	size_t *offset;
+	size_t size = 0;
+	UINT32 start = I_GetTimeMicros();
+	INT32 i;
+
+	R_FreeTextureArena();
+
+	offset = calloc(numtextures, sizeof (*offset));
+	if (offset == NULL) I_Error("%s: Out of memory building textures", "R_BuildTextureArena");
+
+	for (i = 0; i < numtextures; i++)
+	{
+		if (!present[i])
+			continue;
+
+		// Anything already generated gets rebuilt in the arena.
+		Z_Free(texturecache[i]);
+
+		offset[i] = size;
+		size += (R_TextureCacheSize(i) + TEXTUREARENAALIGN - 1) & ~(size_t)(TEXTUREARENAALIGN - 1);
+	}
+
+	if (size)
+	{
+		texturearena = Z_MallocAlign(size, PU_STATIC, NULL, TEXTUREARENABITS);
+		texturestats.arenasize = size;
+
+		for (i = 0; i < numtextures; i++)
+		{
+			if (!present[i])
+				continue;
+
+			// holes was set by R_TextureCacheSize above
+			texturecache[i] = texturearena + offset[i];
+			R_ComposeTexture(i, texturecache[i], R_TextureCacheSize(i));
+			texturestats.arena++;
+		}
+	}
+
+	free(offset);
+	texturememory = size;
+	texturestats.arenatime = I_GetTimeMicros() - start;
+}
+
+void Command_Texturestats_f(void)
+{
+	if (COM_Argc() > 1 && !stricmp(COM_Argv(1), "reset"))
+	{
+		texturestats.lazy = texturestats.lazytime = texturestats.lazypeak = 0;
+		CONS_Printf(M_GetText("Texture statistics reset.\n"));
+		return;
+	}
+
+	CONS_Printf(M_GetText("Built at level load: %u textures, %s k, in %u us\n"),
+		texturestats.arena, sizeu1(texturestats.arenasize>>10), texturestats.arenatime);
+	CONS_Printf(M_GetText("Built while drawing: %u textures\n"), texturestats.lazy);
+	if (texturestats.lazy)
+		CONS_Printf(M_GetText("Stall time: avg %u us, peak %u us\n"),
+			texturestats.lazytime / texturestats.lazy, texturestats.lazypeak);
 }
 
 //
@@ -359,6 +494,8 @@ void R_FlushTextureCache(void)
 {
 	INT32 i;
 
+	R_FreeTextureArena();
+
 	if (numtextures)
 		for (i = 0; i < numtextures; i++)
 			Z_Free(texturecache[i]);
@@ -386,6 +523,7 @@ void R_LoadTextures(void)
 	// Free previous memory before numtextures change.
 	if (numtextures)
 	{
+		R_FreeTextureArena();
 		for (i = 0; i < numtextures; i++)
 		{
 			Z_Free(textures[i]);
@@ -1142,9 +1280,31 @@ INT32 R_ColormapNumForName(char *name)
 //
 static double deltas[256][3], map[256][3];
 
-static UINT8 NearestColor(UINT8 r, UINT8 g, UINT8 b);
+static UINT8 **NearestColorCells(void);
+static UINT8 NearestColor(UINT8 **cells, UINT8 r, UINT8 g, UINT8 b);
 static int RoundUp(double number);
 
+// Generated colormaps are kept between levels, keyed on everything the
+// table is computed from, so that reloading a level or visiting one with
+// the same colormap linedefs does not generate them again.
+#define COLORMAPCACHESIZE 64
+
+typedef struct
+{
+	RGBA_t palette[256];
+	double cmask[3], othermask, cdest[3];
+	UINT32 fadestart, fadedist;
+} colormapkey_t;
+
+typedef struct
+{
+	colormapkey_t key;
+	UINT8 *colormap; // 256 * 34 entries
+} colormapcache_t;
+
+static colormapcache_t colormapcache[COLORMAPCACHESIZE];
+static size_t colormapcacherotor = 0;
+
 INT32 R_CreateColormap(char *p1, char *p2, char *p3)
 {
 	double cmaskr, cmaskg, cmaskb, cdestr, cdestg, cdestb;
@@ -1251,6 +1411,34 @@ INT32 R_CreateColormap(char *p1, char *p2, char *p3)
 		double r, g, b, cbrightness;
 		int p;
 		char *colormap_p;
+		UINT8 **cells;
+		colormapkey_t key;
+		colormapcache_t *cache;
+
+		memset(&key, 0, sizeof (key));
+		M_Memcpy(key.palette, pLocalPalette, sizeof (key.palette));
+		key.cmask[0] = cmaskr;
+		key.cmask[1] = cmaskg;
+		key.cmask[2] = cmaskb;
+		key.othermask = othermask;
+		key.cdest[0] = cdestr;
+		key.cdest[1] = cdestg;
+		key.cdest[2] = cdestb;
+		key.fadestart = fadestart;
+		key.fadedist = fadedist;
+
+		colormap_p = Z_MallocAlign((256 * 34) + 10, PU_LEVEL, NULL, 8);
+		extra_colormaps[mapnum].colormap = (UINT8 *)colormap_p;
+
+		for (i = 0; i < COLORMAPCACHESIZE; i++)
+		{
+			cache = &colormapcache[i];
+			if (cache->colormap && !memcmp(&cache->key, &key, sizeof (key)))
+			{
+				M_Memcpy(colormap_p, cache->colormap, 256 * 34);
+				return (INT32)mapnum;
+			}
+		}
 
 		// Initialise the map and delta arrays
 		// map[i] stores an RGB color (as double) for index i,
@@ -1280,17 +1468,14 @@ INT32 R_CreateColormap(char *p1, char *p2, char *p3)
 			deltas[i][2] = (map[i][2] - cdestb) / (double)fadedist;
 		}
 
-		// Now allocate memory for the actual colormap array itself!
-		colormap_p = Z_MallocAlign((256 * 34) + 10, PU_LEVEL, NULL, 8);
-		extra_colormaps[mapnum].colormap = (UINT8 *)colormap_p;
-
 		// Calculate the palette index for each palette index, for each light level
 		// (as well as the two unused colormap lines we inherited from Doom)
+		cells = NearestColorCells();
 		for (p = 0; p < 34; p++)
 		{
 			for (i = 0; i < 256; i++)
 			{
-				*colormap_p = NearestColor((UINT8)RoundUp(map[i][0]),
+				*colormap_p = NearestColor(cells, (UINT8)RoundUp(map[i][0]),
 					(UINT8)RoundUp(map[i][1]),
 					(UINT8)RoundUp(map[i][2]));
 				colormap_p++;
@@ -1315,20 +1500,125 @@ INT32 R_CreateColormap(char *p1, char *p2, char *p3)
 #undef ABS2
 			}
 		}
+
+		// Remember it, replacing the oldest one when full
+		cache = &colormapcache[colormapcacherotor];
+		colormapcacherotor = (colormapcacherotor + 1) % COLORMAPCACHESIZE;
+		if (!cache->colormap)
+			cache->colormap = Z_Malloc(256 * 34, PU_STATIC, NULL);
+		M_Memcpy(&cache->key, &key, sizeof (key));
+		M_Memcpy(cache->colormap, extra_colormaps[mapnum].colormap, 256 * 34);
 	}
 
 	return (INT32)mapnum;
 }
 
+// NearestColor looks through a short list of candidates instead of the
+// whole palette. The RGB cube is split into cells, and a cell lists, in
+// palette order, only the entries that can be the nearest to some point
+// inside it: those no farther from the cell than the farthest point of the
+// cell is from its best entry. Searching that list gives the same answer
+// as searching all 256 entries, ties included. Cells are filled on first
+// use and thrown away when the palette changes; NearestColorCells checks
+// that once per colormap, not once per lookup.
+#define NEARESTCELLBITS 4 // 16 cells on each axis
+#define NEARESTCELLS (1<<(3*NEARESTCELLBITS))
+#define NEARESTCELLSIZE (256>>NEARESTCELLBITS)
+
+static RGBA_t nearestpalette[256];
+static boolean nearestvalid = false;
+static UINT8 *nearestcells[NEARESTCELLS]; // count, then the palette indices
+
+static INT32 CellDistance(INT32 c, INT32 lo, boolean farthest)
+{
+	const INT32 hi = lo + NEARESTCELLSIZE - 1;
+	INT32 d;
+
+	if (farthest)
+		d = max(abs(c - lo), abs(c - hi));
+	else if (c < lo)
+		d = lo - c;
+	else if (c > hi)
+		d = c - hi;
+	else
+		d = 0;
+	return d*d;
+}
+
+static UINT8 *NearestCell(INT32 cell)
+{
+	const INT32 lo[3] = {
+		(cell >> (2*NEARESTCELLBITS)) * NEARESTCELLSIZE,
+		((cell >> NEARESTCELLBITS) & ((1<<NEARESTCELLBITS)-1)) * NEARESTCELLSIZE,
+		(cell & ((1<<NEARESTCELLBITS)-1)) * NEARESTCELLSIZE
+	};
+	INT32 mindist[256], bound = INT32_MAX, i, count = 0;
+	UINT8 list[257], *cells;
+
+	for (i = 0; i < 256; i++)
+	{
+		const RGBA_t *c = &pLocalPalette[i];
+		const INT32 farthest = CellDistance(c->s.red, lo[0], true)
+			+ CellDistance(c->s.green, lo[1], true)
+			+ CellDistance(c->s.blue, lo[2], true);
+
+		mindist[i] = CellDistance(c->s.red, lo[0], false)
+			+ CellDistance(c->s.green, lo[1], false)
+			+ CellDistance(c->s.blue, lo[2], false);
+		if (farthest < bound)
+			bound = farthest;
+	}
+
+	for (i = 0; i < 256; i++)
+		if (mindist[i] <= bound)
+			list[1 + count++] = (UINT8)i;
+	list[0] = (UINT8)(count - 1); // there is always at least one
+
+	cells = Z_Malloc(count + 1, PU_STATIC, NULL);
+	M_Memcpy(cells, list, count + 1);
+	return cells;
+}
+
+// Returns the cell lists for pLocalPalette, emptying them if the palette
+// has changed since they were filled.
+static UINT8 **NearestColorCells(void)
+{
+	INT32 cell;
+
+	if (!nearestvalid || memcmp(nearestpalette, pLocalPalette, sizeof (nearestpalette)))
+	{
+		for (cell = 0; cell < NEARESTCELLS; cell++)
+		{
+			if (nearestcells[cell])
+				Z_Free(nearestcells[cell]);
+			nearestcells[cell] = NULL;
+		}
+		M_Memcpy(nearestpalette, pLocalPalette, sizeof (nearestpalette));
+		nearestvalid = true;
+	}
+	return nearestcells;
+}
+
 // Thanks to quake2 source!
 // utils3/qdata/images.c
-static UINT8 NearestColor(UINT8 r, UINT8 g, UINT8 b)
+static UINT8 NearestColor(UINT8 **cells, UINT8 r, UINT8 g, UINT8 b)
 {
 	int dr, dg, db;
-	int distortion, bestdistortion = 256 * 256 * 4, bestcolor = 0, i;
-
-	for (i = 0; i < 256; i++)
+	int distortion, bestdistortion = 256 * 256 * 4, bestcolor = 0, i, count;
+	INT32 cell;
+	UINT8 *list;
+
+	cell = ((r / NEARESTCELLSIZE) << (2*NEARESTCELLBITS))
+		| ((g / NEARESTCELLSIZE) << NEARESTCELLBITS)
+		| (b / NEARESTCELLSIZE);
+	list = cells[cell];
+	if (!list)
+		list = cells[cell] = NearestCell(cell);
+
+	count = list[0] + 1;
+	for (list++; count--; list++)
 	{
+		i = *list;
 		dr = r - pLocalPalette[i].s.red;
 		dg = g - pLocalPalette[i].s.green;
 		db = b - pLocalPalette[i].s.blue;
@@ -1553,17 +1843,12 @@ void R_PrecacheLevel(void)
 	// while the sky texture is stored like a wall texture, with a skynum dependent name.
 	texturepresent[skytexture] = 1;
 
-	texturememory = 0;
-	for (j = 0; j < (unsigned)numtextures; j++)
-	{
-		if (!texturepresent[j])
-			continue;
+	// So are the other frames of anything animated.
+	P_MarkAnimatedTextures(texturepresent);
 
-		if (!texturecache[j])
-			R_GenerateTexture(j);
-		// pre-caching individual patches that compose textures became obsolete,
-		// since we cache entire composite textures
-	}
+	// pre-caching individual patches that compose textures became obsolete,
+	// since we cache entire composite textures
+	R_BuildTextureArena(texturepresent);
 	free(texturepresent);
 
 	//
@@ -76,6 +76,7 @@ UINT8 *R_GetFlat(lumpnum_t flatnum);
 // I/O, setting up the stuff.
 void R_InitData(void);
 void R_PrecacheLevel(void);
+void Command_Texturestats_f(void);
 
 // Retrieval.
 // Floor/ceiling opaque texture tiles,
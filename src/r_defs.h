@@ -279,6 +279,19 @@ typedef enum
 	SF_TRIGGERSPECIAL_TOUCH =  4,
 } sectorflags_t;
 
+#ifdef HWRENDER
+// The sector state the hardware renderer's cached geometry was built from
+typedef struct
+{
+	fixed_t floorheight, ceilingheight;
+	INT32 floorpic, ceilingpic;
+	fixed_t floor_xoffs, floor_yoffs;
+	fixed_t ceiling_xoffs, ceiling_yoffs;
+	angle_t floorpic_angle, ceilingpic_angle;
+	void *f_slope, *c_slope;
+} grgeomstate_t;
+#endif
+
 //
 // The SECTORS record, at runtime.
 // Stores things/mobjs.
@@ -359,6 +372,12 @@ typedef struct sector_s
 	linechain_t *sectorLines;
 	struct sector_s **stackList;
 	double lineoutLength;
+
+	// static geometry cache, see HWR_SectorGeometryVersion
+	grgeomstate_t grgeom;
+	UINT32 grgeomversion; // bumped every time grdirty gets set
+	UINT32 grgeomframe; // frame grgeom was last checked on
+	boolean grdirty; // geometry changed since the previous frame
 #endif // ----- end special tricks -----
 
 	// This points to the master's floorheight, so it can be changed in realtime!
@@ -581,6 +600,7 @@ typedef struct seg_s
 	float flength; // length of the seg, used by hardware renderer
 
 	lightmap_t *lightmaps; // for static lightmap
+	struct grwallcache_s *grwallcache; // walls built for this seg, reused while its sectors are unchanged
 #endif
 
 	// Why slow things down by calculating lightlists for every thick side?
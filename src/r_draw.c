@@ -129,8 +129,17 @@ UINT32 nflatxshift, nflatyshift, nflatshiftup, nflatmask;
 #define SKIN_RAMP_LENGTH 16
 #define DEFAULT_STARTTRANSCOLOR 160
 #define NUM_PALETTE_ENTRIES 256
+#define NUM_TT_ROWS (MAXSKINS + 4)
 
-static UINT8** translationtablecache[MAXSKINS + 4] = {NULL};
+// Every translation colormap lives in one block: a row of MAXTRANSLATIONS
+// tables for each skin, then the rows for the special colormaps above.
+// The tables never move, so anything keyed on a colormap pointer (the
+// hardware renderer's recoloured sprites) is shared by everything drawn
+// in the same skin and colour.
+static UINT8 *translationtables = NULL;
+
+// starttranscolor each row was built with plus one, 0 if not built yet
+static INT32 translationrowstart[NUM_TT_ROWS] = {0};
 
 
 // See also the enum skincolors_t
@@ -223,6 +232,12 @@ void R_InitTranslationTables(void)
 	W_ReadLump(W_GetNumForName("TRANS80"), transtables+0x70000);
 	W_ReadLump(W_GetNumForName("TRANS90"), transtables+0x80000);
 #endif
+
+	// Translation colormaps for skins are built as the skins are added
+	R_BuildTranslationColormaps(TC_DEFAULT);
+	R_BuildTranslationColormaps(TC_BOSS);
+	R_BuildTranslationColormaps(TC_METALSONIC);
+	R_BuildTranslationColormaps(TC_ALLWHITE);
 }
 
 
@@ -498,67 +513,80 @@ static void R_GenerateTranslationColormap(UINT8 *dest_colormap, INT32 skinnum, U
 }
 
 
-/**	\brief	Retrieves a translation colormap from the cache.
-
-	\param	skinnum	number of skin, TC_DEFAULT or TC_BOSS
-	\param	color	translation color
-	\param	flags	set GTC_CACHE to use the cache
-
-	\return	Colormap. If not cached, caller should Z_Free.
-*/
-UINT8* R_GetTranslationColormap(INT32 skinnum, skincolors_t color, UINT8 flags)
+// Row of the translation table store used by a skin number or TC_ constant
+static INT32 R_TranslationRow(INT32 skinnum)
 {
-	UINT8* ret;
-	INT32 skintableindex;
+	switch (skinnum)
+	{
+		case TC_DEFAULT:    return DEFAULT_TT_CACHE_INDEX;
+		case TC_BOSS:       return BOSS_TT_CACHE_INDEX;
+		case TC_METALSONIC: return METALSONIC_TT_CACHE_INDEX;
+		case TC_ALLWHITE:   return ALLWHITE_TT_CACHE_INDEX;
+		default:            return skinnum;
+	}
+}
 
-	// Adjust if we want the default colormap
-	if (skinnum == TC_DEFAULT) skintableindex = DEFAULT_TT_CACHE_INDEX;
-	else if (skinnum == TC_BOSS) skintableindex = BOSS_TT_CACHE_INDEX;
-	else if (skinnum == TC_METALSONIC) skintableindex = METALSONIC_TT_CACHE_INDEX;
-	else if (skinnum == TC_ALLWHITE) skintableindex = ALLWHITE_TT_CACHE_INDEX;
-	else skintableindex = skinnum;
+// What the row's tables depend on, so a skin slot reused by a skin with
+// a different ramp gets rebuilt
+static INT32 R_TranslationRowStart(INT32 skinnum)
+{
+	if (skinnum >= 0)
+		return skins[skinnum].starttranscolor + 1;
+	return DEFAULT_STARTTRANSCOLOR + 1;
+}
 
-	if (flags & GTC_CACHE)
-	{
+/**	\brief	Builds every translation colormap for a skin.
 
-		// Allocate table for skin if necessary
-		if (!translationtablecache[skintableindex])
-			translationtablecache[skintableindex] = Z_Calloc(MAXTRANSLATIONS * sizeof(UINT8**), PU_STATIC, NULL);
+	\param	skinnum	number of skin, or one of the TC_ constants
 
-		// Get colormap
-		ret = translationtablecache[skintableindex][color];
-	}
-	else ret = NULL;
+	\return	void
+*/
+void R_BuildTranslationColormaps(INT32 skinnum)
+{
+	const INT32 row = R_TranslationRow(skinnum);
+	UINT8 *dest;
+	INT32 color;
 
-	// Generate the colormap if necessary
-	if (!ret)
-	{
-		ret = Z_MallocAlign(NUM_PALETTE_ENTRIES, (flags & GTC_CACHE) ? PU_LEVEL : PU_STATIC, NULL, 8);
-		R_GenerateTranslationColormap(ret, skinnum, color);
+	// Skins get added before R_InitTranslationTables
+	if (!translationtables)
+		translationtables = Z_MallocAlign((size_t)NUM_TT_ROWS * MAXTRANSLATIONS * NUM_PALETTE_ENTRIES,
+			PU_STATIC, NULL, 8);
 
-		// Cache the colormap if desired
-		if (flags & GTC_CACHE)
-			translationtablecache[skintableindex][color] = ret;
-	}
+	dest = translationtables + (size_t)row * MAXTRANSLATIONS * NUM_PALETTE_ENTRIES;
+	for (color = 0; color < MAXTRANSLATIONS; color++, dest += NUM_PALETTE_ENTRIES)
+		R_GenerateTranslationColormap(dest, skinnum, (UINT8)color);
 
-	return ret;
+	translationrowstart[row] = R_TranslationRowStart(skinnum);
 }
 
-/**	\brief	Flushes cache of translation colormaps.
+/**	\brief	Retrieves a translation colormap.
 
-	Flushes cache of translation colormaps, but doesn't actually free the
-	colormaps themselves. These are freed when PU_LEVEL blocks are purged,
-	at or before which point, this function should be called.
+	\param	skinnum	number of skin, TC_DEFAULT or TC_BOSS
+	\param	color	translation color
+	\param	flags	set GTC_CACHE to get the shared table
 
-	\return	void
+	\return	Colormap. If not cached, caller should Z_Free.
 */
-void R_FlushTranslationColormapCache(void)
+UINT8* R_GetTranslationColormap(INT32 skinnum, skincolors_t color, UINT8 flags)
 {
-	INT32 i;
+	const INT32 row = R_TranslationRow(skinnum);
+	UINT8 *ret;
+
+	// Skins normally have theirs built when they're added
+	if (translationrowstart[row] != R_TranslationRowStart(skinnum))
+		R_BuildTranslationColormaps(skinnum);
+
+	ret = translationtables + ((size_t)row * MAXTRANSLATIONS + color) * NUM_PALETTE_ENTRIES;
 
-	for (i = 0; i < (INT32)(sizeof(translationtablecache) / sizeof(translationtablecache[0])); i++)
-		if (translationtablecache[i])
-			memset(translationtablecache[i], 0, MAXTRANSLATIONS * sizeof(UINT8**));
+	// Callers that want a table of their own get a copy
+	if (!(flags & GTC_CACHE))
+	{
+		UINT8 *copy = Z_MallocAlign(NUM_PALETTE_ENTRIES, PU_STATIC, NULL, 8);
+		M_Memcpy(copy, ret, NUM_PALETTE_ENTRIES);
+		ret = copy;
+	}
+
+	return ret;
 }
 
 UINT8 R_GetColorByName(const char *name)
@@ -109,7 +109,7 @@ extern lumpnum_t viewborderlump[8];
 // Initialize color translation tables, for player rendering etc.
 void R_InitTranslationTables(void);
 UINT8* R_GetTranslationColormap(INT32 skinnum, skincolors_t color, UINT8 flags);
-void R_FlushTranslationColormapCache(void);
+void R_BuildTranslationColormaps(INT32 skinnum);
 UINT8 R_GetColorByName(const char *name);
 
 // Custom player skin translation
@@ -825,7 +825,7 @@ void R_SetupFrame(player_t *player, boolean skybox)
 		aimingangle = player->aiming;
 		viewangle = viewmobj->angle;
 
-		if (!demoplayback && player->playerstate != PST_DEAD)
+		if (!demoplayback && !playerless && player->playerstate != PST_DEAD)
 		{
 			if (player == &players[consoleplayer])
 			{
@@ -908,7 +908,7 @@ void R_SkyboxFrame(player_t *player)
 	{
 		aimingangle = player->aiming;
 		viewangle = player->mo->angle;
-		if (!demoplayback && player->playerstate != PST_DEAD)
+		if (!demoplayback && !playerless && player->playerstate != PST_DEAD)
 		{
 			if (player == &players[consoleplayer])
 			{
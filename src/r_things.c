@@ -2808,7 +2808,7 @@ next_token:
 			// So just let the function in the while loop take care of it for us.
 		}
 
-		R_FlushTranslationColormapCache();
+		R_BuildTranslationColormaps(numskins);
 
 		CONS_Printf(M_GetText("Added skin '%s'\n"), skin->name);
 #ifdef SKINVALUES
@@ -149,17 +149,110 @@ typedef struct
 	// handle of the sound being played
 	INT32 handle;
 
+	// other channels with the same origin hash, and with the same sound
+	// (nextsfx links the free channels while the channel isn't in use)
+	INT32 prevorigin, nextorigin;
+	INT32 prevsfx, nextsfx;
+
 } channel_t;
 
 // the set of channels available
 static channel_t *channels = NULL;
 static INT32 numofchannels = 0;
 
+// Playing channels are found by origin and by sound through these
+// instead of looking at every channel.
+#define ORIGINHASHSIZE 256
+static INT32 originchannels[ORIGINHASHSIZE];
+static INT32 sfxchannels[NUMSFX];
+static INT32 freechannels = -1;
+
+#define S_OriginHash(origin) ((((size_t)(origin)) >> 4 ^ ((size_t)(origin)) >> 12) & (ORIGINHASHSIZE-1))
+
 //
 // Internals.
 //
 static void S_StopChannel(INT32 cnum);
 
+static void S_ResetChannelLinks(void)
+{
+	INT32 i;
+
+	for (i = 0; i < ORIGINHASHSIZE; i++)
+		originchannels[i] = -1;
+	for (i = 0; i < NUMSFX; i++)
+		sfxchannels[i] = -1;
+
+	freechannels = -1;
+	for (i = numofchannels-1; i >= 0; i--)
+	{
+		channels[i].sfxinfo = NULL;
+		channels[i].origin = NULL;
+		channels[i].nextsfx = freechannels;
+		freechannels = i;
+	}
+}
+
+// Takes the first free channel and puts it in the origin and sound lists.
+static INT32 S_LinkChannel(const void *origin, sfxinfo_t *sfxinfo)
+{
+	INT32 cnum = freechannels;
+	channel_t *c = &channels[cnum];
+	INT32 *head;
+
+	freechannels = c->nextsfx;
+
+	c->sfxinfo = sfxinfo;
+	c->origin = origin;
+
+	head = &sfxchannels[sfxinfo - S_sfx];
+	c->prevsfx = -1;
+	c->nextsfx = *head;
+	if (*head != -1)
+		channels[*head].prevsfx = cnum;
+	*head = cnum;
+
+	c->prevorigin = c->nextorigin = -1;
+	if (origin)
+	{
+		head = &originchannels[S_OriginHash(origin)];
+		c->nextorigin = *head;
+		if (*head != -1)
+			channels[*head].prevorigin = cnum;
+		*head = cnum;
+	}
+
+	return cnum;
+}
+
+// Takes a channel out of the origin and sound lists and frees it.
+static void S_UnlinkChannel(INT32 cnum)
+{
+	channel_t *c = &channels[cnum];
+
+	if (c->prevsfx != -1)
+		channels[c->prevsfx].nextsfx = c->nextsfx;
+	else
+		sfxchannels[c->sfxinfo - S_sfx] = c->nextsfx;
+	if (c->nextsfx != -1)
+		channels[c->nextsfx].prevsfx = c->prevsfx;
+
+	if (c->origin)
+	{
+		if (c->prevorigin != -1)
+			channels[c->prevorigin].nextorigin = c->nextorigin;
+		else
+			originchannels[S_OriginHash(c->origin)] = c->nextorigin;
+		if (c->nextorigin != -1)
+			channels[c->nextorigin].prevorigin = c->prevorigin;
+	}
+
+	c->sfxinfo = NULL;
+	c->origin = NULL;
+	c->nextsfx = freechannels;
+	freechannels = cnum;
+}
+
 //
 // S_getChannel
 //
@@ -168,54 +261,50 @@ static void S_StopChannel(INT32 cnum);
 static INT32 S_getChannel(const void *origin, sfxinfo_t *sfxinfo)
 {
 	// channel number to use
-	INT32 cnum;
+	INT32 cnum = sfxchannels[sfxinfo - S_sfx];
+	INT32 i;
 
-	channel_t *c;
+	// Now checks if same sound is being played, rather
+	// than just one sound per mobj
+	if (cnum != -1 && (sfxinfo->pitch & SF_NOMULTIPLESOUND))
+		return -1;
+	else if (cnum != -1 && sfxinfo->singularity == true)
+		S_StopChannel(cnum);
 
-	// Find an open channel
-	for (cnum = 0; cnum < numofchannels; cnum++)
+	if (origin)
 	{
-		if (!channels[cnum].sfxinfo)
-			break;
-
-		// Now checks if same sound is being played, rather
-		// than just one sound per mobj
-		else if (sfxinfo == channels[cnum].sfxinfo && (sfxinfo->pitch & SF_NOMULTIPLESOUND))
-		{
-			return -1;
-			break;
-		}
-		else if (sfxinfo == channels[cnum].sfxinfo && sfxinfo->singularity == true)
-		{
-			S_StopChannel(cnum);
-			break;
-		}
-		else if (origin && channels[cnum].origin == origin && channels[cnum].sfxinfo == sfxinfo)
+		for (cnum = originchannels[S_OriginHash(origin)]; cnum != -1; cnum = channels[cnum].nextorigin)
 		{
-			if (sfxinfo->pitch & SF_NOINTERRUPT)
-				return -1;
-			else
+			if (channels[cnum].origin != origin)
+				continue;
+
+			if (channels[cnum].sfxinfo == sfxinfo)
+			{
+				if (sfxinfo->pitch & SF_NOINTERRUPT)
+					return -1;
 				S_StopChannel(cnum);
-			break;
-		}
-		else if (origin && channels[cnum].origin == origin
-			&& channels[cnum].sfxinfo->name != sfxinfo->name
-			&& channels[cnum].sfxinfo->pitch == SF_TOTALLYSINGLE && sfxinfo->pitch == SF_TOTALLYSINGLE)
-		{
-			S_StopChannel(cnum);
-			break;
+				break;
+			}
+			else if (channels[cnum].sfxinfo->name != sfxinfo->name
+				&& channels[cnum].sfxinfo->pitch == SF_TOTALLYSINGLE && sfxinfo->pitch == SF_TOTALLYSINGLE)
+			{
+				S_StopChannel(cnum);
+				break;
+			}
 		}
 	}
 
 	// None available
-	if (cnum == numofchannels)
+	if (freechannels == -1)
 	{
-		// Look for lower priority
-		for (cnum = 0; cnum < numofchannels; cnum++)
-			if (channels[cnum].sfxinfo->priority <= sfxinfo->priority)
-				break;
+		// Look for the lowest priority
+		cnum = -1;
+		for (i = 0; i < numofchannels; i++)
+			if (channels[i].sfxinfo->priority <= sfxinfo->priority
+				&& (cnum == -1 || channels[i].sfxinfo->priority < channels[cnum].sfxinfo->priority))
+				cnum = i;
 
-		if (cnum == numofchannels)
+		if (cnum == -1)
 		{
 			// No lower priority. Sorry, Charlie.
 			return -1;
@@ -227,13 +316,8 @@ static INT32 S_getChannel(const void *origin, sfxinfo_t *sfxinfo)
 		}
 	}
 
-	c = &channels[cnum];
-
-	// channel is decided to be cnum.
-	c->sfxinfo = sfxinfo;
-	c->origin = origin;
-
-	return cnum;
+	// channel is decided to be the first free one.
+	return S_LinkChannel(origin, sfxinfo);
 }
 
 void S_RegisterSoundStuff(void)
@@ -290,8 +374,6 @@ void S_RegisterSoundStuff(void)
 
 static void SetChannelsNum(void)
 {
-	INT32 i;
-
 	// Allocating the internal channels for mixing
 	// (the maximum number of sounds rendered
 	// simultaneously) within zone memory.
@@ -300,6 +382,8 @@ static void SetChannelsNum(void)
 
 	Z_Free(channels);
 	channels = NULL;
+	numofchannels = 0;
+	S_ResetChannelLinks();
 
 
 	if (cv_numChannels.value == 999999999) //Alam_GBC: OH MY ROD!(ROD rimmiced with GOD!)
@@ -317,8 +401,7 @@ static void SetChannelsNum(void)
 	numofchannels = cv_numChannels.value;
 
 	// Free all channels for use
-	for (i = 0; i < numofchannels; i++)
-		channels[i].sfxinfo = 0;
+	S_ResetChannelLinks();
 }
 
 
@@ -378,7 +461,7 @@ void S_StopSoundByID(void *origin, sfxenum_t sfx_id)
 		return;
 	}
 #endif
-	for (cnum = 0; cnum < numofchannels; cnum++)
+	for (cnum = originchannels[S_OriginHash(origin)]; cnum != -1; cnum = channels[cnum].nextorigin)
 	{
 		if (channels[cnum].sfxinfo == &S_sfx[sfx_id] && channels[cnum].origin == origin)
 		{
@@ -399,14 +482,9 @@ void S_StopSoundByNum(sfxenum_t sfxnum)
 		return;
 	}
 #endif
-	for (cnum = 0; cnum < numofchannels; cnum++)
-	{
-		if (channels[cnum].sfxinfo == &S_sfx[sfxnum])
-		{
-			S_StopChannel(cnum);
-			break;
-		}
-	}
+	cnum = sfxchannels[sfxnum];
+	if (cnum != -1)
+		S_StopChannel(cnum);
 }
 
 void S_StartSoundAtVolume(const void *origin_p, sfxenum_t sfx_id, INT32 volume)
@@ -686,9 +764,9 @@ void S_StopSound(void *origin)
 		return;
 	}
 #endif
-	for (cnum = 0; cnum < numofchannels; cnum++)
+	for (cnum = originchannels[S_OriginHash(origin)]; cnum != -1; cnum = channels[cnum].nextorigin)
 	{
-		if (channels[cnum].sfxinfo && channels[cnum].origin == origin)
+		if (channels[cnum].origin == origin)
 		{
 			S_StopChannel(cnum);
 			break;
@@ -893,7 +971,6 @@ void S_ClearSfx(void)
 
 static void S_StopChannel(INT32 cnum)
 {
-	INT32 i;
 	channel_t *c = &channels[cnum];
 
 	if (c->sfxinfo)
@@ -902,16 +979,10 @@ static void S_StopChannel(INT32 cnum)
 		if (I_SoundIsPlaying(c->handle))
 			I_StopSound(c->handle);
 
-		// check to see
-		//  if other channels are playing the sound
-		for (i = 0; i < numofchannels; i++)
-			if (cnum != i && c->sfxinfo == channels[i].sfxinfo)
-				break;
-
 		// degrade usefulness of sound data
 		c->sfxinfo->usefulness--;
 
-		c->sfxinfo = 0;
+		S_UnlinkChannel(cnum);
 	}
 }
 
@@ -987,7 +1058,14 @@ INT32 S_AdjustSoundParams(const mobj_t *listener, const mobj_t *source, INT32 *v
 	{
 		fixed_t x, y, yl, yh, xl, xh, newdist;
 
-		if (R_PointInSubsector(listensource.x, listensource.y)->sector->ceilingpic == skyflatnum)
+		// The search below is over a thousand subsector lookups, and every
+		// rain channel asks again each tic from the same spot.
+		static fixed_t outsidex, outsidey, outsidedist;
+		static tic_t outsidetic = (tic_t)-1;
+
+		if (outsidetic == gametic && outsidex == listensource.x && outsidey == listensource.y)
+			approx_dist = outsidedist;
+		else if (R_PointInSubsector(listensource.x, listensource.y)->sector->ceilingpic == skyflatnum)
 			approx_dist = 0;
 		else
 		{
@@ -1011,6 +1089,11 @@ INT32 S_AdjustSoundParams(const mobj_t *listener, const mobj_t *source, INT32 *v
 					}
 				}
 		}
+
+		outsidetic = gametic;
+		outsidex = listensource.x;
+		outsidey = listensource.y;
+		outsidedist = approx_dist;
 	}
 	else
 	{
@@ -1081,7 +1164,7 @@ INT32 S_OriginPlaying(void *origin)
 		return HW3S_OriginPlaying(origin);
 #endif
 
-	for (cnum = 0; cnum < numofchannels; cnum++)
+	for (cnum = originchannels[S_OriginHash(origin)]; cnum != -1; cnum = channels[cnum].nextorigin)
 		if (channels[cnum].origin == origin)
 			return 1;
 	return 0;
@@ -1091,17 +1174,12 @@ INT32 S_OriginPlaying(void *origin)
 // is playing anywhere.
 INT32 S_IdPlaying(sfxenum_t id)
 {
-	INT32 cnum;
-
 #ifdef HW3SOUND
 	if (hws_mode != HWS_DEFAULT_MODE)
 		return HW3S_IdPlaying(id);
 #endif
 
-	for (cnum = 0; cnum < numofchannels; cnum++)
-		if ((size_t)(channels[cnum].sfxinfo - S_sfx) == (size_t)id)
-			return 1;
-	return 0;
+	return (sfxchannels[id] != -1);
 }
 
 // Searches through the channels and checks for
@@ -1117,7 +1195,7 @@ INT32 S_SoundPlaying(void *origin, sfxenum_t id)
 		return HW3S_SoundPlaying(origin, id);
 #endif
 
-	for (cnum = 0; cnum < numofchannels; cnum++)
+	for (cnum = originchannels[S_OriginHash(origin)]; cnum != -1; cnum = channels[cnum].nextorigin)
 	{
 		if (channels[cnum].origin == origin
 		 && (size_t)(channels[cnum].sfxinfo - S_sfx) == (size_t)id)
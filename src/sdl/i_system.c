@@ -2061,6 +2061,25 @@ tic_t I_GetTime (void)
 }
 #endif
 
+//
+// I_GetTimeMicros
+// returns a free-running microsecond timestamp
+//
+UINT32 I_GetTimeMicros(void)
+{
+	static Uint64 basetime = 0;
+	const Uint64 frequency = SDL_GetPerformanceFrequency();
+	Uint64 ticks = SDL_GetPerformanceCounter();
+
+	if (!basetime)
+		basetime = ticks;
+
+	ticks -= basetime;
+
+	// split the division so the multiply can't overflow on fast counters
+	return (UINT32)((ticks / frequency) * 1000000 + (ticks % frequency) * 1000000 / frequency);
+}
+
 //
 //I_StartupTimer
 //
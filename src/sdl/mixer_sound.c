@@ -84,10 +84,97 @@ static Music_Emu *gme;
 static INT32 current_track;
 #endif
 
+// Doom format sounds are kept as they are in the lump, unsigned 8-bit mono
+// at their own rate, and mix_sfx resamples and pans them on the audio thread. Other
+// formats are loaded by the mixer as chunks, as are Doom sounds if the
+// output isn't 16-bit stereo.
+typedef struct
+{
+	Mix_Chunk *chunk; // or NULL for a Doom format sound
+	UINT8 *samples; // our own copy, the lump cache is shared between sfx
+	UINT32 length; // in samples
+	UINT32 step; // FRACUNIT is one sample per output sample
+} mixsfx_t;
+
+#define NUMVOICES 256 // the same as the mixer channels
+#define VOICEHANDLE 0x100 // added to voice numbers to tell them from mixer channels
+
+typedef struct
+{
+	const mixsfx_t *sfx; // NULL if the voice is free
+	UINT32 pos, frac;
+	INT32 left, right; // 1<<15 is full volume
+} voice_t;
+
+static voice_t voices[NUMVOICES];
+static SDL_mutex *voice_mutex = NULL;
+static int mix_freq;
+static boolean native_sfx = false;
+
 /// ------------------------
 /// Audio System
 /// ------------------------
 
+#define MIXBLOCK 512
+
+// Mixes the playing voices into the mixer's output, one block at a time:
+// first the voice is stepped through at the output rate, then the block is
+// scaled, panned and added, which the compiler can vectorize.
+static void mix_sfx(void *udata, Uint8 *stream, int len)
+{
+	INT16 *out = (INT16 *)stream;
+	INT32 frames = len / 4, start, count, i, v;
+	INT32 block[MIXBLOCK];
+	(void)udata;
+
+	SDL_LockMutex(voice_mutex);
+	for (v = 0; v < NUMVOICES; v++)
+	{
+		voice_t *voice = &voices[v];
+		const UINT8 *src;
+		UINT32 pos, frac, step, length;
+		INT32 left, right;
+
+		if (!voice->sfx)
+			continue;
+
+		src = voice->sfx->samples;
+		length = voice->sfx->length;
+		step = voice->sfx->step;
+		pos = voice->pos;
+		frac = voice->frac;
+		left = voice->left;
+		right = voice->right;
+
+		for (start = 0; start < frames && pos < length; start += count)
+		{
+			INT16 *o = out + start*2;
+
+			for (count = 0; count < MIXBLOCK && start + count < frames && pos < length; count++)
+			{
+				block[count] = ((INT32)src[pos] - 0x80) << 8; // unsigned 8-bit to signed 16-bit
+				frac += step;
+				pos += frac >> FRACBITS;
+				frac &= FRACUNIT-1;
+			}
+
+			for (i = 0; i < count; i++)
+			{
+				INT32 l = o[i*2] + ((block[i] * left) >> 15);
+				INT32 r = o[i*2+1] + ((block[i] * right) >> 15);
+				o[i*2] = (INT16)(l > INT16_MAX ? INT16_MAX : (l < INT16_MIN ? INT16_MIN : l));
+				o[i*2+1] = (INT16)(r > INT16_MAX ? INT16_MAX : (r < INT16_MIN ? INT16_MIN : r));
+			}
+		}
+
+		if (pos >= length)
+			voice->sfx = NULL;
+		voice->pos = pos;
+		voice->frac = frac;
+	}
+	SDL_UnlockMutex(voice_mutex);
+}
+
 void I_StartupSound(void)
 {
 	I_Assert(!sound_started);
@@ -128,6 +215,18 @@ void I_StartupSound(void)
 	sound_started = true;
 	songpaused = false;
 	Mix_AllocateChannels(256);
+
+	{
+		Uint16 format;
+		int channels;
+
+		memset(voices, 0, sizeof (voices));
+		if (Mix_QuerySpec(&mix_freq, &format, &channels) && format == AUDIO_S16SYS && channels == 2)
+			voice_mutex = SDL_CreateMutex();
+		native_sfx = (voice_mutex != NULL);
+		if (native_sfx)
+			Mix_SetPostMix(mix_sfx, NULL);
+	}
 }
 
 void I_ShutdownSound(void)
@@ -136,7 +235,12 @@ void I_ShutdownSound(void)
 		return; // not an error condition
 	sound_started = false;
 
+	Mix_SetPostMix(NULL, NULL);
 	Mix_CloseAudio();
+	if (voice_mutex)
+		SDL_DestroyMutex(voice_mutex);
+	voice_mutex = NULL;
+	native_sfx = false;
 #if SDL_MIXER_VERSION_ATLEAST(1,2,11)
 	Mix_Quit();
 #endif
@@ -269,9 +373,8 @@ static Mix_Chunk *ds2chunk(void *stream)
 	return Mix_QuickLoad_RAW(sound, (Uint32)((UINT8*)d-sound));
 }
 
-void *I_GetSfx(sfxinfo_t *sfx)
+static Mix_Chunk *LoadChunk(sfxinfo_t *sfx, void *lump)
 {
-	void *lump;
 	Mix_Chunk *chunk;
 	SDL_RWops *rw;
 #ifdef HAVE_LIBGME
@@ -279,12 +382,6 @@ void *I_GetSfx(sfxinfo_t *sfx)
 	gme_info_t *info;
 #endif
 
-	if (sfx->lumpnum == LUMPERROR)
-		sfx->lumpnum = S_GetSfxLumpNum(sfx);
-	sfx->length = W_LumpLength(sfx->lumpnum);
-
-	lump = W_CacheLumpNum(sfx->lumpnum, PU_SOUND);
-
 	// convert from standard DoomSound format.
 	chunk = ds2chunk(lump);
 	if (chunk)
@@ -425,11 +522,71 @@ void *I_GetSfx(sfxinfo_t *sfx)
 	return NULL; // haven't been able to get anything
 }
 
+void *I_GetSfx(sfxinfo_t *sfx)
+{
+	UINT8 *lump;
+	mixsfx_t *mixsfx;
+
+	if (sfx->lumpnum == LUMPERROR)
+		sfx->lumpnum = S_GetSfxLumpNum(sfx);
+	sfx->length = W_LumpLength(sfx->lumpnum);
+
+	lump = W_CacheLumpNum(sfx->lumpnum, PU_SOUND);
+
+	mixsfx = Z_Calloc(sizeof (*mixsfx), PU_SOUND, NULL);
+
+	// Keep standard DoomSound format as it is, the mixer callback reads it straight from a copy of the samples.
+	if (native_sfx && sfx->length > 8 && lump[0] == 3 && lump[1] == 0)
+	{
+		UINT8 *p = lump + 2;
+		UINT16 freq = READUINT16(p);
+		UINT32 samples = READUINT32(p);
+
+		if (samples > sfx->length - 8)
+			samples = (UINT32)sfx->length - 8;
+		if (freq && samples)
+		{
+			mixsfx->samples = Z_Malloc(samples, PU_SOUND, NULL);
+			M_Memcpy(mixsfx->samples, p, samples);
+			Z_Free(lump);
+			mixsfx->length = samples;
+			mixsfx->step = (UINT32)(((UINT64)freq << FRACBITS) / mix_freq);
+			return mixsfx;
+		}
+	}
+
+	mixsfx->chunk = LoadChunk(sfx, lump);
+	if (!mixsfx->chunk)
+	{
+		Z_Free(mixsfx);
+		return NULL;
+	}
+	return mixsfx;
+}
+
+// Stops any voice playing the sound. Call with voice_mutex locked.
+static void StopVoices(const mixsfx_t *mixsfx)
+{
+	INT32 v;
+	for (v = 0; v < NUMVOICES; v++)
+		if (voices[v].sfx == mixsfx)
+			voices[v].sfx = NULL;
+}
+
 void I_FreeSfx(sfxinfo_t *sfx)
 {
-	if (sfx->data)
+	mixsfx_t *mixsfx = sfx->data;
+
+	if (mixsfx && !mixsfx->chunk)
 	{
-		Mix_Chunk *chunk = (Mix_Chunk*)sfx->data;
+		SDL_LockMutex(voice_mutex);
+		StopVoices(mixsfx);
+		SDL_UnlockMutex(voice_mutex);
+		Z_Free(mixsfx->samples);
+	}
+	else if (mixsfx)
+	{
+		Mix_Chunk *chunk = mixsfx->chunk;
 		UINT8 *abufdata = NULL;
 		if (chunk->allocated == 0)
 		{
@@ -437,44 +594,100 @@ void I_FreeSfx(sfxinfo_t *sfx)
 			// I believe this should ensure the sound is not playing when we free it
 			abufdata = chunk->abuf;
 		}
-		Mix_FreeChunk(sfx->data);
+		Mix_FreeChunk(chunk);
 		if (abufdata)
 		{
 			// I'm going to assume we used Z_Malloc to allocate this data.
 			Z_Free(abufdata);
 		}
 	}
+	if (mixsfx)
+		Z_Free(mixsfx);
 	sfx->data = NULL;
 	sfx->lumpnum = LUMPERROR;
 }
 
+// Works out a voice's gains the same way Mix_Volume and Mix_SetPanning would.
+static void SetVoiceParams(voice_t *voice, UINT8 volume, UINT8 sep)
+{
+	INT32 left = min((UINT16)(0xff-sep)<<1, 0xff), right = min((UINT16)(sep)<<1, 0xff);
+	voice->left = (volume * left << 15) / (MIX_MAX_VOLUME * 0xff);
+	voice->right = (volume * right << 15) / (MIX_MAX_VOLUME * 0xff);
+}
+
 INT32 I_StartSound(sfxenum_t id, UINT8 vol, UINT8 sep, UINT8 pitch, UINT8 priority, INT32 channel)
 {
 	UINT8 volume = (((UINT16)vol + 1) * (UINT16)sfx_volume) / 62; // (256 * 31) / 62 == 127
-	INT32 handle = Mix_PlayChannel(channel, S_sfx[id].data, 0);
-	Mix_Volume(handle, volume);
-	Mix_SetPanning(handle, min((UINT16)(0xff-sep)<<1, 0xff), min((UINT16)(sep)<<1, 0xff));
+	const mixsfx_t *mixsfx = S_sfx[id].data;
+	INT32 handle;
+
 	(void)pitch; // Mixer can't handle pitch
 	(void)priority; // priority and channel management is handled by SRB2...
+
+	if (!mixsfx)
+		return -1;
+
+	if (!mixsfx->chunk)
+	{
+		voice_t *voice;
+
+		if (channel < 0 || channel >= NUMVOICES)
+		{
+			// pick any free voice
+			for (channel = 0; channel < NUMVOICES; channel++)
+				if (!voices[channel].sfx)
+					break;
+			if (channel == NUMVOICES)
+				return -1;
+		}
+
+		SDL_LockMutex(voice_mutex);
+		voice = &voices[channel];
+		voice->sfx = mixsfx;
+		voice->pos = voice->frac = 0;
+		SetVoiceParams(voice, volume, sep);
+		SDL_UnlockMutex(voice_mutex);
+		return channel + VOICEHANDLE;
+	}
+
+	handle = Mix_PlayChannel(channel, mixsfx->chunk, 0);
+	Mix_Volume(handle, volume);
+	Mix_SetPanning(handle, min((UINT16)(0xff-sep)<<1, 0xff), min((UINT16)(sep)<<1, 0xff));
 	return handle;
 }
 
 void I_StopSound(INT32 handle)
 {
+	if (handle >= VOICEHANDLE)
+	{
+		SDL_LockMutex(voice_mutex);
+		voices[handle - VOICEHANDLE].sfx = NULL;
+		SDL_UnlockMutex(voice_mutex);
+		return;
+	}
 	Mix_HaltChannel(handle);
 }
 
 boolean I_SoundIsPlaying(INT32 handle)
 {
+	if (handle >= VOICEHANDLE)
+		return (voices[handle - VOICEHANDLE].sfx != NULL); // a stale answer is harmless here
 	return Mix_Playing(handle);
 }
 
 void I_UpdateSoundParams(INT32 handle, UINT8 vol, UINT8 sep, UINT8 pitch)
 {
 	UINT8 volume = (((UINT16)vol + 1) * (UINT16)sfx_volume) / 62; // (256 * 31) / 62 == 127
+	(void)pitch;
+	if (handle >= VOICEHANDLE)
+	{
+		SDL_LockMutex(voice_mutex);
+		SetVoiceParams(&voices[handle - VOICEHANDLE], volume, sep);
+		SDL_UnlockMutex(voice_mutex);
+		return;
+	}
 	Mix_Volume(handle, volume);
 	Mix_SetPanning(handle, min((UINT16)(0xff-sep)<<1, 0xff), min((UINT16)(sep)<<1, 0xff));
-	(void)pitch;
 }
 
 void I_SetSfxVolume(UINT8 volume)
@@ -2189,6 +2189,19 @@ tic_t I_GetTime (void)
 }
 #endif
 
+//
+// I_GetTimeMicros
+// SDL 1.2 only has a millisecond timer
+//
+UINT32 I_GetTimeMicros(void)
+{
+#ifdef _arch_dreamcast
+	return (UINT32)(timer_ms_gettime64()*1000);
+#else
+	return SDL_GetTicks()*1000;
+#endif
+}
+
 //
 //I_StartupTimer
 //
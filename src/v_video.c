@@ -34,7 +34,7 @@
 UINT8 *screens[5];
 // screens[0] = main display window
 // screens[1] = back screen, alternative blitting
-// screens[2] = screenshot buffer, gif movie buffer
+// screens[2] = screenshot buffer
 // screens[3] = fade screen start
 // screens[4] = fade screen end, postimage tempoarary buffer
 
@@ -326,6 +326,316 @@ static inline UINT8 transmappedpdraw(const UINT8 *dest, const UINT8 *source, fix
 	return *(v_translevel + (((*(v_colormap + source[ofs>>FRACBITS]))<<8)&0xff00) + (*dest&0xff));
 }
 
+// --------------------------------------------------------------------------
+// Scaled patch cache
+//
+// The HUD, menus and console draw the same patches at the same scales every
+// frame. Instead of walking posts and rescaling every pixel each time, the
+// software renderer converts a patch once per (scale, flip) into rows of
+// opaque spans at screen resolution, which are then blitted with straight
+// copies or table lookups.
+// --------------------------------------------------------------------------
+
+typedef struct
+{
+	INT32 x; // first screen column, relative to desttop
+	INT32 length;
+	size_t ofs; // first pixel in pixels[]
+} vpatchspan_t;
+
+typedef struct vpatchcache_s
+{
+	const patch_t *patch;
+	void **owner; // the patch's zone user, cleared if the lump is purged
+	fixed_t pscale;
+	INT32 dup;
+	boolean flip;
+	boolean overlap; // posts overlap once scaled, which translucency would blend twice
+
+	INT32 height; // rows, from the top of the patch
+	INT32 *rowspans; // first span of each row, height+1 entries
+	vpatchspan_t *spans;
+	UINT8 *pixels;
+	size_t size;
+
+	struct vpatchcache_s *next;
+} vpatchcache_t;
+
+#define PATCHCACHE_HASHSIZE 256
+#define PATCHCACHE_BUDGET (16<<20)
+#define PATCHCACHE_MAXPIXELS (PATCHCACHE_BUDGET>>3) // bigger patches are drawn uncached
+
+static vpatchcache_t *patchcache[PATCHCACHE_HASHSIZE];
+static size_t patchcachesize = 0;
+
+static inline size_t V_PatchCacheHash(const patch_t *patch, fixed_t pscale, INT32 dup)
+{
+	return (((size_t)patch >> 3) ^ (size_t)(pscale >> 10) ^ (size_t)dup) & (PATCHCACHE_HASHSIZE-1);
+}
+
+void V_FlushPatchCache(void)
+{
+	vpatchcache_t *pc, *next;
+	size_t i;
+
+	for (i = 0; i < PATCHCACHE_HASHSIZE; i++)
+	{
+		for (pc = patchcache[i]; pc; pc = next)
+		{
+			next = pc->next;
+			Z_Free(pc);
+		}
+		patchcache[i] = NULL;
+	}
+	patchcachesize = 0;
+}
+
+// Rasterizes a patch exactly as the column loop in V_DrawFixedPatch would,
+// then packs each row of the result into spans.
+static vpatchcache_t *V_BuildPatchCache(const patch_t *patch, void **owner, fixed_t pscale, INT32 dup, boolean flip, fixed_t fdup, fixed_t pwidth)
+{
+	const fixed_t colfrac = FixedDiv(FRACUNIT, fdup), rowfrac = FixedDiv(FRACUNIT, fdup);
+	const column_t *column;
+	const UINT8 *source;
+	UINT8 *bitmap, *mask;
+	boolean overlap = false;
+	vpatchcache_t *pc;
+	fixed_t col, ofs;
+	INT32 numcols = 0, height = 0, jbase, c, row, topdelta, prevdelta;
+	size_t numspans = 0, numpixels = 0, size;
+
+	for (col = 0; (col>>FRACBITS) < SHORT(patch->width); col += colfrac)
+		numcols++;
+
+	// find how many screen rows the posts cover
+	for (c = 0, col = 0; c < numcols; c++, col += colfrac)
+	{
+		prevdelta = -1;
+		column = (const column_t *)((const UINT8 *)(patch) + LONG(patch->columnofs[col>>FRACBITS]));
+		while (column->topdelta != 0xff)
+		{
+			topdelta = column->topdelta;
+			if (topdelta <= prevdelta)
+				topdelta += prevdelta;
+			prevdelta = topdelta;
+			row = FixedInt(FixedMul(topdelta<<FRACBITS, fdup));
+			for (ofs = 0; (ofs>>FRACBITS) < column->length; ofs += rowfrac)
+				row++;
+			if (row > height)
+				height = row;
+			column = (const column_t *)((const UINT8 *)column + column->length + 4);
+		}
+	}
+
+	if (!numcols || !height || (size_t)numcols * height > PATCHCACHE_MAXPIXELS)
+		return NULL;
+
+	// V_FLIP mirrors column c to pwidth - c
+	jbase = flip ? pwidth - (numcols - 1) : 0;
+
+	bitmap = Z_Malloc((size_t)numcols * height, PU_STATIC, NULL);
+	mask = Z_Calloc((size_t)numcols * height, PU_STATIC, NULL);
+
+	for (c = 0, col = 0; c < numcols; c++, col += colfrac)
+	{
+		const INT32 j = (flip ? pwidth - c : c) - jbase;
+		prevdelta = -1;
+		column = (const column_t *)((const UINT8 *)(patch) + LONG(patch->columnofs[col>>FRACBITS]));
+		while (column->topdelta != 0xff)
+		{
+			topdelta = column->topdelta;
+			if (topdelta <= prevdelta)
+				topdelta += prevdelta;
+			prevdelta = topdelta;
+			source = (const UINT8 *)(column) + 3;
+			row = FixedInt(FixedMul(topdelta<<FRACBITS, fdup));
+			for (ofs = 0; (ofs>>FRACBITS) < column->length; ofs += rowfrac, row++)
+			{
+				overlap |= mask[row*numcols + j];
+				bitmap[row*numcols + j] = source[ofs>>FRACBITS];
+				mask[row*numcols + j] = 1;
+			}
+			column = (const column_t *)((const UINT8 *)column + column->length + 4);
+		}
+	}
+
+	for (row = 0; row < height; row++)
+	{
+		const UINT8 *m = mask + row*numcols;
+		for (c = 0; c < numcols; c++)
+		{
+			if (!m[c])
+				continue;
+			numspans++;
+			while (c < numcols && m[c])
+			{
+				numpixels++;
+				c++;
+			}
+		}
+	}
+
+	size = sizeof (*pc) + numspans * sizeof (vpatchspan_t) + (height + 1) * sizeof (INT32) + numpixels;
+	pc = Z_Malloc(size, PU_STATIC, NULL);
+	pc->patch = patch;
+	pc->owner = owner;
+	pc->pscale = pscale;
+	pc->dup = dup;
+	pc->flip = flip;
+	pc->overlap = overlap;
+	pc->height = height;
+	pc->spans = (vpatchspan_t *)(pc + 1);
+	pc->rowspans = (INT32 *)(pc->spans + numspans);
+	pc->pixels = (UINT8 *)(pc->rowspans + height + 1);
+	pc->size = size;
+
+	numspans = numpixels = 0;
+	for (row = 0; row < height; row++)
+	{
+		const UINT8 *m = mask + row*numcols, *b = bitmap + row*numcols;
+		pc->rowspans[row] = (INT32)numspans;
+		for (c = 0; c < numcols; c++)
+		{
+			vpatchspan_t *span;
+			if (!m[c])
+				continue;
+			span = &pc->spans[numspans++];
+			span->x = jbase + c;
+			span->ofs = numpixels;
+			while (c < numcols && m[c])
+				pc->pixels[numpixels++] = b[c++];
+			span->length = (INT32)(numpixels - span->ofs);
+		}
+	}
+	pc->rowspans[height] = (INT32)numspans;
+
+	Z_Free(bitmap);
+	Z_Free(mask);
+	return pc;
+}
+
+static vpatchcache_t *V_GetPatchCache(const patch_t *patch, fixed_t pscale, INT32 dup, boolean flip, fixed_t fdup, fixed_t pwidth)
+{
+	const size_t hash = V_PatchCacheHash(patch, pscale, dup);
+	vpatchcache_t **link, *pc;
+	void **owner;
+
+	for (link = &patchcache[hash]; (pc = *link) != NULL; link = &pc->next)
+	{
+		if (pc->patch != patch || pc->pscale != pscale || pc->dup != dup || pc->flip != flip)
+			continue;
+		if (*pc->owner == patch)
+			return pc;
+
+		// The lump was purged, and something else now lives at this address.
+		*link = pc->next;
+		patchcachesize -= pc->size;
+		Z_Free(pc);
+		break;
+	}
+
+	// Only patches owned by the WAD cache can be tracked this way.
+	owner = Z_GetUser(patch);
+	if (!owner || *owner != patch)
+		return NULL;
+
+	pc = V_BuildPatchCache(patch, owner, pscale, dup, flip, fdup, pwidth);
+	if (!pc)
+		return NULL;
+
+	if (patchcachesize + pc->size > PATCHCACHE_BUDGET)
+		V_FlushPatchCache();
+
+	pc->next = patchcache[hash];
+	patchcache[hash] = pc;
+	patchcachesize += pc->size;
+	return pc;
+}
+
+static inline void V_BlitSpan(UINT8 *dest, const UINT8 *src, INT32 n)
+{
+	M_Memcpy(dest, src, n);
+}
+static inline void V_BlitSpanMapped(UINT8 *dest, const UINT8 *src, INT32 n)
+{
+	const UINT8 *colormap = v_colormap;
+	INT32 i;
+	for (i = 0; i < n; i++)
+		dest[i] = colormap[src[i]];
+}
+static inline void V_BlitSpanTranslucent(UINT8 *dest, const UINT8 *src, INT32 n)
+{
+	const UINT8 *translevel = v_translevel;
+	INT32 i;
+	for (i = 0; i < n; i++)
+		dest[i] = translevel[(src[i]<<8) + dest[i]];
+}
+static inline void V_BlitSpanTransMapped(UINT8 *dest, const UINT8 *src, INT32 n)
+{
+	const UINT8 *colormap = v_colormap, *translevel = v_translevel;
+	INT32 i;
+	for (i = 0; i < n; i++)
+		dest[i] = translevel[(colormap[src[i]]<<8) + dest[i]];
+}
+
+// Draws a cached patch with its left edge at desttop.
+// Clips to the same screen area as the column loop: columns where x+j is
+// off the screen are skipped, as is anything outside the framebuffer.
+static void V_BlitPatchCache(const vpatchcache_t *pc, UINT8 *desttop, INT32 x, INT32 scrn)
+{
+	UINT8 *screen = screens[scrn&V_PARAMMASK];
+	const ptrdiff_t base = desttop - screen;
+	const ptrdiff_t limit = (ptrdiff_t)vid.rowbytes * vid.height;
+	INT32 row, s;
+
+	for (row = 0; row < pc->height; row++)
+	{
+		const ptrdiff_t rowofs = base + (ptrdiff_t)row * vid.width;
+		ptrdiff_t lo = -x, hi = vid.width - x;
+
+		if (-rowofs > lo)
+			lo = -rowofs;
+		if (limit - rowofs < hi)
+			hi = limit - rowofs;
+		if (lo >= hi)
+		{
+			if (limit - rowofs <= -x)
+				break; // below the bottom of the screen
+			continue;
+		}
+
+		for (s = pc->rowspans[row]; s < pc->rowspans[row+1]; s++)
+		{
+			const vpatchspan_t *span = &pc->spans[s];
+			ptrdiff_t start = span->x, end = span->x + span->length;
+			const UINT8 *src;
+			UINT8 *dest;
+
+			if (start < lo)
+				start = lo;
+			if (end > hi)
+				end = hi;
+			if (start >= end)
+				continue;
+
+			src = pc->pixels + span->ofs + (start - span->x);
+			dest = screen + rowofs + start;
+
+			if (v_translevel)
+			{
+				if (v_colormap)
+					V_BlitSpanTransMapped(dest, src, (INT32)(end - start));
+				else
+					V_BlitSpanTranslucent(dest, src, (INT32)(end - start));
+			}
+			else if (v_colormap)
+				V_BlitSpanMapped(dest, src, (INT32)(end - start));
+			else
+				V_BlitSpan(dest, src, (INT32)(end - start));
+		}
+	}
+}
+
 // Draws a patch scaled to arbitrary size.
 void V_DrawFixedPatch(fixed_t x, fixed_t y, fixed_t pscale, INT32 scrn, patch_t *patch, const UINT8 *colormap)
 {
@@ -503,6 +813,15 @@ void V_DrawFixedPatch(fixed_t x, fixed_t y, fixed_t pscale, INT32 scrn, patch_t
 	deststart = desttop;
 	destend = desttop + pwidth;
 
+	{
+		const vpatchcache_t *pc = V_GetPatchCache(patch, pscale, dupx, (scrn & V_FLIP) != 0, fdup, pwidth);
+		if (pc && !(pc->overlap && v_translevel))
+		{
+			V_BlitPatchCache(pc, desttop, x, scrn);
+			return;
+		}
+	}
+
 	for (col = 0; (col>>FRACBITS) < SHORT(patch->width); col += colfrac, ++offx, desttop++)
 	{
 		INT32 topdelta, prevdelta = -1;
@@ -2217,6 +2536,7 @@ void V_Init(void)
 	const INT32 screensize = vid.rowbytes * vid.height;
 
 	LoadMapPalette();
+	V_FlushPatchCache(); // scaled for the old mode
 	// hardware modes do not use screens[] pointers
 	for (i = 0; i < NUMSCREENS; i++)
 		screens[i] = NULL;
@@ -102,12 +102,14 @@ static loadfunc_t hwdFuncTable[] = {
 	{"FinishUpdate@4",      &hwdriver.pfnFinishUpdate},
 	{"Draw2DLine@12",       &hwdriver.pfnDraw2DLine},
 	{"DrawPolygon@16",      &hwdriver.pfnDrawPolygon},
+	{"DrawIndexedTriangles@24", &hwdriver.pfnDrawIndexedTriangles},
 	{"SetBlend@4",          &hwdriver.pfnSetBlend},
 	{"ClearBuffer@12",      &hwdriver.pfnClearBuffer},
 	{"SetTexture@4",        &hwdriver.pfnSetTexture},
 	{"ReadRect@24",         &hwdriver.pfnReadRect},
 	{"GClipRect@20",        &hwdriver.pfnGClipRect},
 	{"ClearMipMapCache@0",  &hwdriver.pfnClearMipMapCache},
+	{"DeleteTexture@4",     &hwdriver.pfnDeleteTexture},
 	{"SetSpecialState@8",   &hwdriver.pfnSetSpecialState},
 	{"DrawMD2@16",          &hwdriver.pfnDrawMD2},
 	{"DrawMD2i@36",         &hwdriver.pfnDrawMD2i},
@@ -133,12 +135,14 @@ static loadfunc_t hwdFuncTable[] = {
 	{"FinishUpdate",        &hwdriver.pfnFinishUpdate},
 	{"Draw2DLine",          &hwdriver.pfnDraw2DLine},
 	{"DrawPolygon",         &hwdriver.pfnDrawPolygon},
+	{"DrawIndexedTriangles", &hwdriver.pfnDrawIndexedTriangles},
 	{"SetBlend",            &hwdriver.pfnSetBlend},
 	{"ClearBuffer",         &hwdriver.pfnClearBuffer},
 	{"SetTexture",          &hwdriver.pfnSetTexture},
 	{"ReadRect",            &hwdriver.pfnReadRect},
 	{"GClipRect",           &hwdriver.pfnGClipRect},
 	{"ClearMipMapCache",    &hwdriver.pfnClearMipMapCache},
+	{"DeleteTexture",       &hwdriver.pfnDeleteTexture},
 	{"SetSpecialState",     &hwdriver.pfnSetSpecialState},
 	{"DrawMD2",             &hwdriver.pfnDrawMD2},
 	{"DrawMD2i",            &hwdriver.pfnDrawMD2i},
@@ -259,6 +259,28 @@ tic_t I_GetTime(void)
 	return newtics;
 }
 
+// I_GetTimeMicros
+// Free-running microsecond timestamp, used for frame pacing statistics.
+// Falls back to the multimedia timer when there's no high resolution counter.
+UINT32 I_GetTimeMicros(void)
+{
+	static LARGE_INTEGER basetime = {{0, 0}};
+	static LARGE_INTEGER frequency = {{0, 0}};
+	LARGE_INTEGER currtime;
+
+	if (!frequency.QuadPart && QueryPerformanceFrequency(&frequency))
+		QueryPerformanceCounter(&basetime);
+
+	if (frequency.QuadPart && QueryPerformanceCounter(&currtime))
+	{
+		currtime.QuadPart -= basetime.QuadPart;
+		return (UINT32)((currtime.QuadPart / frequency.QuadPart) * 1000000
+			+ (currtime.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart);
+	}
+
+	return timeGetTime()*1000;
+}
+
 void I_Sleep(void)
 {
 	if (cv_sleep.value != -1)
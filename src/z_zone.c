@@ -711,3 +711,33 @@ void Z_SetUser2(void *ptr, void **newuser)
 	block->user = (void*)newuser;
 	*newuser = ptr;
 }
+
+/** Returns the owner a block was allocated or Z_SetUser'd with.
+  * The owner is cleared when the block is freed, so callers can keep it to
+  * tell whether the block they saw is still alive.
+  *
+  * \param ptr Start of a zone block.
+  * \return The block's user, or NULL if it has none or ptr isn't a zone block.
+  */
+void **Z_GetUser(const void *ptr)
+{
+	const memhdr_t *hdr;
+	void **user;
+
+	if (ptr == NULL)
+		return NULL;
+
+	hdr = (const memhdr_t *)((const UINT8 *)ptr - sizeof *hdr);
+
+#ifdef VALGRIND_MAKE_MEM_DEFINED
+	VALGRIND_MAKE_MEM_DEFINED(hdr, sizeof *hdr);
+#endif
+
+	user = (hdr->id == ZONEID) ? hdr->block->user : NULL;
+
+#ifdef VALGRIND_MAKE_MEM_NOACCESS
+	VALGRIND_MAKE_MEM_NOACCESS(hdr, sizeof *hdr);
+#endif
+
+	return user;
+}
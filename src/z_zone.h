@@ -116,6 +116,8 @@ char *Z_StrDup(const char *in);
 #define Z_SetUser(p,u) Z_SetUser2(p, u)
 #endif
 
+void **Z_GetUser(const void *ptr);
+
 #ifdef _NDS ///TODO: need a lock reference system
 #define Z_Unlock(p) Z_ChangeTag(p, PU_CACHE_UNLOCKED)
 #else